@@ -0,0 +1,593 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <player.h>
+#include <dispmanx_window.h>
+
+/* Headless benchmarks for the player_interface API.
+ *
+ *   player_bench --scenario setup|switch|seek|cpu [--codec h264|vp8|theora]
+ *                [--size WxH] [--runs N] [--streams N] [--duration S]
+ *
+ * The media is generated once with videotestsrc/audiotestsrc and kept under
+ * I_PLAYER_BENCH_MEDIA (default ~/.cache/i_player/bench). Players are built
+ * with player_get_handler as usual, only the playbin sinks are replaced by
+ * fakesinks so nothing depends on a display. Every run prints one JSON line
+ * on stdout, logs go to stderr unless I_PLAYER_LOG says otherwise.
+ *
+ * Exit status 77 (skipped) when an encoder for the codec is missing.*/
+
+#define BENCH_SCHEMA_VERSION 1
+#define BENCH_EXIT_SKIP 77
+#define BENCH_MEDIA_SECONDS 20
+#define BENCH_FRAMERATE 30
+#define BENCH_FRAME_TIMEOUT_US (10 * G_USEC_PER_SEC)
+#define BENCH_MAX_STREAMS 4
+
+typedef struct
+{
+    const char *name;
+    const char *video_encoder;
+    const char *muxer;
+    const char *extension;
+}s_bench_codec_t;
+
+static const s_bench_codec_t s_codecs[] =
+{
+    { "h264",   "x264enc speed-preset=ultrafast key-int-max=30 ! h264parse", "matroskamux", "mkv" },
+    { "vp8",    "vp8enc deadline=1 keyframe-max-dist=30",                     "webmmux",     "webm" },
+    { "theora", "theoraenc keyframe-force=30",                                "oggmux",      "ogg" },
+};
+
+/* one per player, fed from the video fakesink pad probe*/
+typedef struct
+{
+    GMutex lock;
+    GCond cond;
+    GstElement *video_sink;
+    guint64 frames;
+    gboolean waiting;
+    gboolean need_flush;       /* seeks: only buffers after the flush count*/
+    gint64 start;
+    gint64 latency_us;
+}s_bench_sink_t;
+
+typedef struct
+{
+    const char *scenario;
+    const s_bench_codec_t *codec;
+    guint width;
+    guint height;
+    guint runs;
+    guint streams;
+    guint duration;
+}s_bench_options_t;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static gboolean s_bench_parse_options(int32_t argc, char *argv[], s_bench_options_t *options)
+{
+    const char *codec = "h264";
+    int32_t i;
+    guint c;
+
+    options->scenario = NULL;
+    options->width = 1280;
+    options->height = 720;
+    options->runs = 10;
+    options->streams = 1;
+    options->duration = 8;
+
+    for (i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--scenario") == 0)
+            options->scenario = argv[i + 1];
+        else if (strcmp(argv[i], "--codec") == 0)
+            codec = argv[i + 1];
+        else if (strcmp(argv[i], "--size") == 0)
+        {
+            if (sscanf(argv[i + 1], "%ux%u", &options->width, &options->height) != 2)
+                return FALSE;
+        }
+        else if (strcmp(argv[i], "--runs") == 0)
+            options->runs = (guint)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--streams") == 0)
+            options->streams = (guint)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--duration") == 0)
+            options->duration = (guint)atoi(argv[i + 1]);
+        else
+            return FALSE;
+    }
+    if (i != argc || options->scenario == NULL || options->runs == 0 || options->duration == 0 ||
+            options->streams == 0 || options->streams > BENCH_MAX_STREAMS)
+        return FALSE;
+
+    options->codec = NULL;
+    for (c = 0; c < G_N_ELEMENTS(s_codecs); c++)
+    {
+        if (strcmp(s_codecs[c].name, codec) == 0)
+            options->codec = &s_codecs[c];
+    }
+    return (options->codec != NULL);
+}
+
+/* Returns the path of the cached media, NULL when it can not be encoded here*/
+static gchar *s_bench_make_media(const s_bench_options_t *options, const char *pattern)
+{
+    const gchar *dir = g_getenv("I_PLAYER_BENCH_MEDIA");
+    gchar *cache_dir = NULL, *name = NULL, *path = NULL, *part = NULL, *description = NULL;
+    GstElement *pipeline = NULL;
+    GstMessage *message = NULL;
+    GstBus *bus = NULL;
+    GError *err = NULL;
+    gboolean ok = FALSE;
+
+    cache_dir = dir ? g_strdup(dir) : g_build_filename(g_get_user_cache_dir(), "i_player", "bench", NULL);
+    g_mkdir_with_parents(cache_dir, 0755);
+    name = g_strdup_printf("%s-%ux%u-%s.%s", options->codec->name, options->width, options->height, pattern, options->codec->extension);
+    path = g_build_filename(cache_dir, name, NULL);
+    if (g_file_test(path, G_FILE_TEST_EXISTS))
+    {
+        ok = TRUE;
+        goto safe_exit;
+    }
+
+    part = g_strdup_printf("%s.part", path);
+    description = g_strdup_printf("videotestsrc num-buffers=%d pattern=%s ! video/x-raw,width=%u,height=%u,framerate=%d/1 ! "
+            "%s ! %s name=mux ! filesink location=\"%s\" "
+            "audiotestsrc num-buffers=%d samplesperbuffer=441 ! audio/x-raw,rate=44100 ! audioconvert ! vorbisenc ! mux.",
+            BENCH_MEDIA_SECONDS * BENCH_FRAMERATE, pattern, options->width, options->height, BENCH_FRAMERATE,
+            options->codec->video_encoder, options->codec->muxer, part, BENCH_MEDIA_SECONDS * 100);
+
+    I_LOG_INFO("========== Generating %s ==========\n", path);
+    pipeline = gst_parse_launch(description, &err);
+    if (pipeline == NULL || err)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Can not encode %s here : %s !!!!!!!!!!\n", options->codec->name, err ? err->message : "");
+        goto safe_exit;
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    bus = gst_element_get_bus(pipeline);
+    message = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    if (message && GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS)
+        ok = (rename(part, path) == 0);
+    else
+        I_LOG_ERROR("xxxxxxxxxx Encoding %s failed xxxxxxxxxx\n", path);
+
+safe_exit:
+    if (message)
+        gst_message_unref(message);
+    if (pipeline)
+        gst_object_unref(pipeline);
+    if (err)
+        g_error_free(err);
+    if (part)
+    {
+        remove(part);
+        g_free(part);
+    }
+    g_free(description);
+    g_free(name);
+    g_free(cache_dir);
+    if (!ok)
+    {
+        g_free(path);
+        path = NULL;
+    }
+    return path;
+}
+
+/* video streaming thread*/
+static GstPadProbeReturn s_bench_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    s_bench_sink_t *sink = (s_bench_sink_t *) user_data;
+
+    g_mutex_lock(&sink->lock);
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        sink->frames++;
+        if (sink->waiting && !sink->need_flush)
+        {
+            sink->latency_us = g_get_monotonic_time() - sink->start;
+            sink->waiting = FALSE;
+            g_cond_signal(&sink->cond);
+        }
+    }
+    else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP)
+        sink->need_flush = FALSE;
+    g_mutex_unlock(&sink->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void s_bench_sink_init(s_bench_sink_t *sink)
+{
+    GstPad *pad = NULL;
+
+    I_ZEROMEM(sink, sizeof(s_bench_sink_t));
+    g_mutex_init(&sink->lock);
+    g_cond_init(&sink->cond);
+    sink->video_sink = gst_object_ref_sink (gst_element_factory_make ("fakesink", NULL));
+    g_object_set (sink->video_sink, "sync", TRUE, NULL);
+
+    pad = gst_element_get_static_pad (sink->video_sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH, s_bench_sink_probe, sink, NULL);
+    gst_object_unref (pad);
+    return;
+}
+
+static void s_bench_sink_clear(s_bench_sink_t *sink)
+{
+    gst_object_unref (sink->video_sink);
+    g_cond_clear(&sink->cond);
+    g_mutex_clear(&sink->lock);
+    return;
+}
+
+/* Arm before the operation, start is when the operation began*/
+static void s_bench_sink_arm(s_bench_sink_t *sink, gint64 start, gboolean need_flush)
+{
+    g_mutex_lock(&sink->lock);
+    sink->waiting = TRUE;
+    sink->need_flush = need_flush;
+    sink->start = start;
+    sink->latency_us = -1;
+    g_mutex_unlock(&sink->lock);
+    return;
+}
+
+/* Latency from start to the first frame, -1 on timeout*/
+static gint64 s_bench_sink_wait(s_bench_sink_t *sink)
+{
+    gint64 deadline = g_get_monotonic_time() + BENCH_FRAME_TIMEOUT_US;
+    gint64 latency_us;
+
+    g_mutex_lock(&sink->lock);
+    while (sink->waiting)
+    {
+        if (!g_cond_wait_until(&sink->cond, &sink->lock, deadline))
+            break;
+    }
+    sink->waiting = FALSE;
+    latency_us = sink->latency_us;
+    g_mutex_unlock(&sink->lock);
+    return latency_us;
+}
+
+static guint64 s_bench_sink_frames(s_bench_sink_t *sink)
+{
+    guint64 frames;
+
+    g_mutex_lock(&sink->lock);
+    frames = sink->frames;
+    g_mutex_unlock(&sink->lock);
+    return frames;
+}
+
+static player_instance_t *s_bench_new_player(const char *media, s_bench_sink_t *sink)
+{
+    player_instance_t *player_instance = NULL;
+    GstElement *audio_sink = NULL;
+
+    if (player_get_handler(media, NULL, NULL, &player_instance) != 0)
+        return NULL;
+
+    /* synced like real sinks, so the pipelines run at their natural rate*/
+    audio_sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (audio_sink, "sync", TRUE, NULL);
+    g_object_set (player_instance->pipeline, "video-sink", sink->video_sink, "audio-sink", audio_sink, NULL);
+    return player_instance;
+}
+
+static gint64 s_bench_cpu_time_us(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return ((gint64)usage.ru_utime.tv_sec + (gint64)usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+        (gint64)usage.ru_utime.tv_usec + (gint64)usage.ru_stime.tv_usec;
+}
+
+/* pipeline setup : player_get_handler and player_play to the first frame*/
+static gboolean s_bench_setup(const s_bench_options_t *options, const char *media, gdouble *samples)
+{
+    s_bench_sink_t sink;
+    player_instance_t *player_instance = NULL;
+    gboolean ok = TRUE;
+    guint run;
+
+    for (run = 0; run < options->runs && ok; run++)
+    {
+        s_bench_sink_init(&sink);
+        s_bench_sink_arm(&sink, g_get_monotonic_time(), FALSE);
+        player_instance = s_bench_new_player(media, &sink);
+        if (player_instance)
+        {
+            player_play(player_instance);
+            samples[run] = (gdouble)s_bench_sink_wait(&sink);
+            ok = (samples[run] >= 0);
+            player_release(player_instance);
+        }
+        else
+            ok = FALSE;
+        s_bench_sink_clear(&sink);
+    }
+    return ok;
+}
+
+/* uri switch : player_stop, new src_uri and player_play to the first new frame*/
+static gboolean s_bench_switch(const s_bench_options_t *options, const char *media, const char *other_media, gdouble *samples)
+{
+    s_bench_sink_t sink;
+    player_instance_t *player_instance = NULL;
+    gboolean ok = FALSE;
+    guint run;
+    gint64 start;
+
+    s_bench_sink_init(&sink);
+    player_instance = s_bench_new_player(media, &sink);
+    if (player_instance == NULL)
+        goto safe_exit;
+
+    s_bench_sink_arm(&sink, g_get_monotonic_time(), FALSE);
+    player_play(player_instance);
+    ok = (s_bench_sink_wait(&sink) >= 0);
+
+    for (run = 0; run < options->runs && ok; run++)
+    {
+        start = g_get_monotonic_time();
+        s_bench_sink_arm(&sink, start, FALSE);
+        player_stop(player_instance);
+        g_free(player_instance->src_uri);
+        player_instance->src_uri = player_make_uri((run % 2) ? media : other_media);
+        player_play(player_instance);
+        samples[run] = (gdouble)s_bench_sink_wait(&sink);
+        ok = (samples[run] >= 0);
+    }
+    player_release(player_instance);
+
+safe_exit:
+    s_bench_sink_clear(&sink);
+    return ok;
+}
+
+/* seek latency : player_relative_seek to the first frame after the flush*/
+static gboolean s_bench_seek(const s_bench_options_t *options, const char *media, gdouble *samples)
+{
+    s_bench_sink_t sink;
+    player_instance_t *player_instance = NULL;
+    gint64 position = 0, duration = -1, deadline;
+    gboolean ok = FALSE;
+    guint run;
+
+    s_bench_sink_init(&sink);
+    player_instance = s_bench_new_player(media, &sink);
+    if (player_instance == NULL)
+        goto safe_exit;
+
+    s_bench_sink_arm(&sink, g_get_monotonic_time(), FALSE);
+    player_play(player_instance);
+    if (s_bench_sink_wait(&sink) < 0)
+        goto release;
+
+    /* relative seeks need the duration from media info*/
+    deadline = g_get_monotonic_time() + BENCH_FRAME_TIMEOUT_US;
+    while ((duration = player_get_duration(player_instance)) <= 0 && g_get_monotonic_time() < deadline)
+        g_usleep(10000);
+    if (duration <= 0)
+        goto release;
+
+    ok = TRUE;
+    for (run = 0; run < options->runs && ok; run++)
+    {
+        player_query_position(player_instance, &position);
+        s_bench_sink_arm(&sink, g_get_monotonic_time(), TRUE);
+        player_relative_seek(player_instance, (position > duration / 2) ? -0.3 : 0.3);
+        samples[run] = (gdouble)s_bench_sink_wait(&sink);
+        ok = (samples[run] >= 0);
+    }
+
+release:
+    player_release(player_instance);
+safe_exit:
+    s_bench_sink_clear(&sink);
+    return ok;
+}
+
+/* steady state cpu : percent of one core per stream while the streams play*/
+static gboolean s_bench_cpu(const s_bench_options_t *options, const char *media, gdouble *samples, gdouble *fps)
+{
+    s_bench_sink_t sinks[BENCH_MAX_STREAMS];
+    player_instance_t *players[BENCH_MAX_STREAMS] = { NULL };
+    gint64 wall, cpu;
+    guint64 frames, start_frames;
+    gboolean ok = TRUE;
+    guint run, i;
+
+    for (run = 0; run < options->runs && ok; run++)
+    {
+        for (i = 0; i < options->streams; i++)
+        {
+            s_bench_sink_init(&sinks[i]);
+            players[i] = s_bench_new_player(media, &sinks[i]);
+            if (players[i] == NULL)
+            {
+                ok = FALSE;
+                continue;
+            }
+            s_bench_sink_arm(&sinks[i], g_get_monotonic_time(), FALSE);
+            player_play(players[i]);
+        }
+        for (i = 0; i < options->streams && ok; i++)
+            ok = (s_bench_sink_wait(&sinks[i]) >= 0);
+
+        if (ok)
+        {
+            start_frames = 0;
+            for (i = 0; i < options->streams; i++)
+                start_frames += s_bench_sink_frames(&sinks[i]);
+            wall = g_get_monotonic_time();
+            cpu = s_bench_cpu_time_us();
+
+            g_usleep((gulong)options->duration * G_USEC_PER_SEC);
+
+            wall = g_get_monotonic_time() - wall;
+            cpu = s_bench_cpu_time_us() - cpu;
+            frames = 0;
+            for (i = 0; i < options->streams; i++)
+                frames += s_bench_sink_frames(&sinks[i]);
+            frames -= start_frames;
+            samples[run] = (gdouble)cpu * 100.0 / (gdouble)wall / options->streams;
+            fps[run] = (gdouble)frames * G_USEC_PER_SEC / (gdouble)wall / options->streams;
+        }
+
+        for (i = 0; i < options->streams; i++)
+        {
+            if (players[i])
+                player_release(players[i]);
+            players[i] = NULL;
+            s_bench_sink_clear(&sinks[i]);
+        }
+    }
+    return ok;
+}
+
+static int s_bench_compare(const void *a, const void *b)
+{
+    gdouble x = *(const gdouble *)a, y = *(const gdouble *)b;
+    return (x > y) - (x < y);
+}
+
+/* One line, keys are fixed so results of different builds can be compared*/
+static void s_bench_print(const s_bench_options_t *options, const char *unit, gdouble *samples, gdouble *fps)
+{
+    gdouble *sorted = g_new(gdouble, options->runs);
+    gdouble sum = 0, fps_sum = 0, median;
+    guint run;
+
+    memcpy(sorted, samples, options->runs * sizeof(gdouble));
+    qsort(sorted, options->runs, sizeof(gdouble), s_bench_compare);
+    median = (options->runs % 2) ? sorted[options->runs / 2] : (sorted[options->runs / 2 - 1] + sorted[options->runs / 2]) / 2;
+    for (run = 0; run < options->runs; run++)
+    {
+        sum += samples[run];
+        fps_sum += fps[run];
+    }
+
+    printf("{\"schema\":%d,\"scenario\":\"%s\",\"codec\":\"%s\",\"width\":%u,\"height\":%u,\"streams\":%u,\"runs\":%u,"
+            "\"unit\":\"%s\",\"median\":%.1f,\"mean\":%.1f,\"min\":%.1f,\"max\":%.1f,\"fps\":%.1f,\"samples\":[",
+            BENCH_SCHEMA_VERSION, options->scenario, options->codec->name, options->width, options->height, options->streams,
+            options->runs, unit, median, sum / options->runs, sorted[0], sorted[options->runs - 1], fps_sum / options->runs);
+    for (run = 0; run < options->runs; run++)
+        printf("%s%.1f", run ? "," : "", samples[run]);
+    printf("]}\n");
+    fflush(stdout);
+
+    g_free(sorted);
+    return;
+}
+
+/* ********** Main Goes Here ***********/
+
+int32_t main(int32_t argc, char *argv[])
+{
+    s_bench_options_t options;
+    gchar *media = NULL, *other_media = NULL;
+    gdouble *samples = NULL, *fps = NULL;
+    const char *unit = "us";
+    gboolean ok = FALSE;
+    int32_t ret = 1;
+
+    if (!s_bench_parse_options(argc, argv, &options))
+    {
+        fprintf(stderr, "%s --scenario setup|switch|seek|cpu [--codec h264|vp8|theora] [--size WxH] [--runs N] [--streams N] [--duration S]\n", argv[0]);
+        return 2;
+    }
+
+    /* stdout carries the results*/
+    if (g_getenv("I_PLAYER_LOG") == NULL)
+        g_setenv("I_PLAYER_LOG", "file:/dev/stderr", TRUE);
+    if (g_getenv("I_PLAYER_WINDOW_BACKEND") == NULL)
+        g_setenv("I_PLAYER_WINDOW_BACKEND", "soft", TRUE);
+    i_log_init();
+
+    dispmanx_initialize_window_system();
+    gst_init (&argc, &argv);
+    player_init();
+
+    media = s_bench_make_media(&options, "smpte");
+    if (media && strcmp(options.scenario, "switch") == 0)
+        other_media = s_bench_make_media(&options, "ball");
+    if (media == NULL || (strcmp(options.scenario, "switch") == 0 && other_media == NULL))
+    {
+        ret = BENCH_EXIT_SKIP;
+        goto safe_exit;
+    }
+
+    samples = g_new0(gdouble, options.runs);
+    fps = g_new0(gdouble, options.runs);
+    if (strcmp(options.scenario, "setup") == 0)
+        ok = s_bench_setup(&options, media, samples);
+    else if (strcmp(options.scenario, "switch") == 0)
+        ok = s_bench_switch(&options, media, other_media, samples);
+    else if (strcmp(options.scenario, "seek") == 0)
+        ok = s_bench_seek(&options, media, samples);
+    else if (strcmp(options.scenario, "cpu") == 0)
+    {
+        unit = "percent_core";
+        ok = s_bench_cpu(&options, media, samples, fps);
+    }
+    else
+        I_LOG_ERROR("xxxxxxxxxx Unknown Scenario %s xxxxxxxxxx\n", options.scenario);
+
+    if (ok)
+    {
+        s_bench_print(&options, unit, samples, fps);
+        ret = 0;
+    }
+    else
+        I_LOG_ERROR("xxxxxxxxxx Benchmark %s failed xxxxxxxxxx\n", options.scenario);
+
+safe_exit:
+    g_free(samples);
+    g_free(fps);
+    g_free(media);
+    g_free(other_media);
+
+    player_shutdown();
+    dispmanx_shutdown_window_system();
+    i_log_shutdown();
+    return ret;
+}
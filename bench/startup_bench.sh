@@ -0,0 +1,80 @@
+#!/bin/sh
+# Startup benchmark for i_player.
+#
+# Runs the player RUNS times per startup mode and prints one JSON object per
+# mode with the median time to gst_init done and to the first frame, taken
+# from the I_PLAYER_STARTUP_REPORT checkpoints.
+#
+#   bench/startup_bench.sh <i_player binary> <media> [runs]
+#
+# Modes : serial      display init, then gst_init, full registry
+#         parallel    display init beside gst_init, full registry
+#         allow-list  parallel, registry restricted to PLAYER_PLUGIN_ALLOW_LIST
+#
+# Set COLD=1 (as root) to drop the page cache before every run, which is what
+# a boot from SD card looks like.
+
+PLAYER=$1
+MEDIA=$2
+RUNS=${3:-5}
+TIMEOUT=${TIMEOUT:-20}
+
+if [ -z "$PLAYER" ] || [ -z "$MEDIA" ]; then
+    echo "usage: $0 <i_player binary> <media> [runs]" >&2
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# value of "key":N in a one line JSON report, the first frame key is top level
+json_value() {
+    tr '{,' '\n\n' < "$1" | sed -n "s/.*\"$2\":\(-\{0,1\}[0-9]*\).*/\1/p" | head -n 1
+}
+
+# at of the named checkpoint
+checkpoint_at() {
+    tr '{' '\n' < "$1" | sed -n "s/.*\"name\":\"$2\",\"at\":\([0-9]*\).*/\1/p" | head -n 1
+}
+
+median() {
+    sort -n | awk '{ v[NR] = $1 } END { if (NR == 0) print -1; else if (NR % 2) print v[(NR + 1) / 2]; else print int((v[NR / 2] + v[NR / 2 + 1]) / 2) }'
+}
+
+run_once() {
+    report=$1
+    shift
+    rm -f "$report"
+    [ "$COLD" = "1" ] && sync && echo 3 > /proc/sys/vm/drop_caches 2>/dev/null
+    env "$@" I_PLAYER_STARTUP_REPORT="$report" "$PLAYER" "$MEDIA" < /dev/null > "$WORK/log" 2>&1 &
+    pid=$!
+    waited=0
+    while [ ! -s "$report" ] && [ $waited -lt $((TIMEOUT * 10)) ] && kill -0 $pid 2>/dev/null; do
+        sleep 0.1
+        waited=$((waited + 1))
+    done
+    kill $pid 2>/dev/null
+    wait $pid 2>/dev/null
+}
+
+bench_mode() {
+    name=$1
+    shift
+    : > "$WORK/gst_init"
+    : > "$WORK/first_frame"
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        run_once "$WORK/report.json" "$@"
+        if [ -s "$WORK/report.json" ]; then
+            checkpoint_at "$WORK/report.json" gst_init >> "$WORK/gst_init"
+            json_value "$WORK/report.json" time_to_first_frame >> "$WORK/first_frame"
+        fi
+        i=$((i + 1))
+    done
+    printf '{"mode":"%s","runs":%d,"gst_init_us":%s,"time_to_first_frame_us":%s}\n' "$name" "$RUNS" \
+        "$(median < "$WORK/gst_init")" "$(median < "$WORK/first_frame")"
+}
+
+bench_mode serial I_PLAYER_SERIAL_STARTUP=1
+bench_mode parallel
+bench_mode allow-list I_PLAYER_PLUGINS=default
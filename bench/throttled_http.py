@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# Throttled HTTP server for the buffering policy (include/player_buffering.h).
+#
+# Serves the files of a directory at a fixed byte rate, optionally stopping
+# the transfer for a while at a fixed interval, which is what a flaky Wi-Fi
+# link looks like to souphttpsrc. Range requests are honoured so seeking and
+# download buffering work.
+#
+#   bench/throttled_http.py <dir> [--port 8080] [--rate 500] [--stall-every 10 --stall-for 3]
+#
+# --rate is in KiB/s. Then play http://localhost:8080/<file> with for example
+# I_PLAYER_BUFFERING=5000:20:99 and compare the stall counts logged on exit.
+
+import argparse
+import os
+import re
+import time
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+CHUNK = 16 * 1024
+
+
+def make_handler(args):
+    class ThrottledHandler(SimpleHTTPRequestHandler):
+        def __init__(self, *handler_args, **kwargs):
+            super().__init__(*handler_args, directory=args.dir, **kwargs)
+
+        def log_message(self, fmt, *log_args):
+            if args.verbose:
+                super().log_message(fmt, *log_args)
+
+        def do_GET(self):
+            path = self.translate_path(self.path)
+            if not os.path.isfile(path):
+                self.send_error(404)
+                return
+
+            size = os.path.getsize(path)
+            start, end = 0, size - 1
+            match = re.match(r"bytes=(\d*)-(\d*)", self.headers.get("Range", ""))
+            if match and (match.group(1) or match.group(2)):
+                if match.group(1):
+                    start = int(match.group(1))
+                    if match.group(2):
+                        end = min(int(match.group(2)), size - 1)
+                else:
+                    start = max(size - int(match.group(2)), 0)
+                if start >= size:
+                    self.send_error(416)
+                    return
+                self.send_response(206)
+                self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end, size))
+            else:
+                self.send_response(200)
+            self.send_header("Content-Type", self.guess_type(path))
+            self.send_header("Content-Length", str(end - start + 1))
+            self.send_header("Accept-Ranges", "bytes")
+            self.end_headers()
+
+            rate = args.rate * 1024
+            began = time.monotonic()
+            paced = began  # start of the rate budget, moved on by stalls
+            sent = 0
+            with open(path, "rb") as media:
+                media.seek(start)
+                remaining = end - start + 1
+                while remaining > 0:
+                    elapsed = time.monotonic() - began
+                    if args.stall_every > 0 and elapsed % args.stall_every > args.stall_every - args.stall_for:
+                        # stalls are not paid back with a burst
+                        time.sleep(0.05)
+                        paced += 0.05
+                        continue
+                    data = media.read(min(CHUNK, remaining))
+                    if not data:
+                        break
+                    try:
+                        self.wfile.write(data)
+                    except (BrokenPipeError, ConnectionResetError):
+                        return
+                    sent += len(data)
+                    remaining -= len(data)
+                    ahead = sent / rate - (time.monotonic() - paced) if rate > 0 else 0
+                    if ahead > 0:
+                        time.sleep(ahead)
+
+    return ThrottledHandler
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP server with a throttled, stalling link")
+    parser.add_argument("dir")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--rate", type=float, default=500.0, help="KiB/s, 0 for unlimited")
+    parser.add_argument("--stall-every", type=float, default=0.0, help="seconds between stalls")
+    parser.add_argument("--stall-for", type=float, default=2.0, help="seconds per stall")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("", args.port), make_handler(args))
+    print("serving %s on port %d at %.0f KiB/s" % (args.dir, args.port, args.rate))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
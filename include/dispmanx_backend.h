@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------------
+ Window system backend used by dispmanx_window.c
+
+ The window code only talks to the display through this table, so the same
+ layout logic can drive the VideoCore dispmanx API on a Pi or the in-memory
+ software compositor (soft_compositor.c) on any Linux host.
+-------------------------------------------------------------------------*/
+
+#ifndef __DISPMANX_BACKEND_H
+#define __DISPMANX_BACKEND_H
+
+#include "player.h"
+
+typedef struct
+{
+    const char *name;
+    gboolean native_window; /* elements can be handed to EGL/video sinks as EGL_DISPMANX_WINDOW_T*/
+
+    void (*init)(void);
+    void (*deinit)(void);
+
+    DISPMANX_DISPLAY_HANDLE_T (*display_open)(uint32_t screen);
+    int (*display_get_info)(DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_MODEINFO_T *info);
+    int (*display_close)(DISPMANX_DISPLAY_HANDLE_T display);
+
+    DISPMANX_UPDATE_HANDLE_T (*update_start)(int32_t priority);
+    int (*update_submit_sync)(DISPMANX_UPDATE_HANDLE_T update);
+    /* returns at once, cb_func is called from a backend thread once the update is on screen*/
+    int (*update_submit)(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_CALLBACK_FUNC_T cb_func, void *cb_arg);
+
+    DISPMANX_ELEMENT_HANDLE_T (*element_add)(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+            int32_t layer, const VC_RECT_T *dst_rect, DISPMANX_RESOURCE_HANDLE_T src,
+            const VC_RECT_T *src_rect, VC_DISPMANX_ALPHA_T *alpha, DISPMANX_TRANSFORM_T transform);
+    int (*element_change_attributes)(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+            uint32_t change_flags, int32_t layer, uint8_t opacity,
+            const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect);
+    /* flips the resource shown by an element, used for frames written by the CPU*/
+    int (*element_change_source)(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element, DISPMANX_RESOURCE_HANDLE_T src);
+    int (*element_remove)(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element);
+
+    DISPMANX_RESOURCE_HANDLE_T (*resource_create)(VC_IMAGE_TYPE_T type, uint32_t width, uint32_t height);
+    int (*resource_write_data)(DISPMANX_RESOURCE_HANDLE_T resource, VC_IMAGE_TYPE_T src_type,
+            int src_pitch, void *src_address, const VC_RECT_T *rect);
+    int (*resource_delete)(DISPMANX_RESOURCE_HANDLE_T resource);
+}dispmanx_backend_t;
+
+/* dispmanx_backend_vc.c, only built with -Ddispmanx=true*/
+const dispmanx_backend_t *dispmanx_backend_vc(void);
+
+/* soft_compositor.c*/
+const dispmanx_backend_t *dispmanx_backend_soft(void);
+
+#endif /* __DISPMANX_BACKEND_H*/
@@ -0,0 +1,97 @@
+/*-------------------------------------------------------------------------
+ Minimal stand-ins for the VideoCore dispmanx types used by the player.
+
+ Only used when the player is built without the Raspberry Pi userland
+ (meson -Ddispmanx=false), so the window code can be built and run against
+ the software compositor on an ordinary Linux host. Layout and values follow
+ interface/vmcs_host/vc_dispmanx_types.h.
+-------------------------------------------------------------------------*/
+
+#ifndef __DISPMANX_COMPAT_H
+#define __DISPMANX_COMPAT_H
+
+#include <stdint.h>
+
+typedef uint32_t DISPMANX_DISPLAY_HANDLE_T;
+typedef uint32_t DISPMANX_UPDATE_HANDLE_T;
+typedef uint32_t DISPMANX_ELEMENT_HANDLE_T;
+typedef uint32_t DISPMANX_RESOURCE_HANDLE_T;
+typedef uint32_t DISPMANX_PROTECTION_T;
+
+#define DISPMANX_PROTECTION_NONE 0
+
+typedef enum
+{
+    VC_IMAGE_RGB565 = 1,
+    VC_IMAGE_RGBA32 = 15,
+    VC_IMAGE_RGBA16 = 17
+}VC_IMAGE_TYPE_T;
+
+typedef enum
+{
+    DISPMANX_NO_ROTATE = 0,
+    DISPMANX_SNAPSHOT_FILL = 1 << 18
+}DISPMANX_TRANSFORM_T;
+
+typedef enum
+{
+    DISPMANX_FLAGS_ALPHA_FROM_SOURCE = 0,
+    DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS = 1,
+    DISPMANX_FLAGS_ALPHA_FIXED_NON_ZERO = 2,
+    DISPMANX_FLAGS_ALPHA_FIXED_EXCEED_0X07 = 3,
+    DISPMANX_FLAGS_ALPHA_PREMULT = 1 << 16,
+    DISPMANX_FLAGS_ALPHA_MIX = 1 << 17
+}DISPMANX_FLAGS_ALPHA_T;
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+}VC_RECT_T;
+
+typedef struct
+{
+    DISPMANX_FLAGS_ALPHA_T flags;
+    uint32_t opacity;
+    DISPMANX_RESOURCE_HANDLE_T mask;
+}VC_DISPMANX_ALPHA_T;
+
+typedef void *DISPMANX_CLAMP_T;
+
+typedef void (*DISPMANX_CALLBACK_FUNC_T)(DISPMANX_UPDATE_HANDLE_T u, void *arg);
+
+typedef struct
+{
+    int32_t width;
+    int32_t height;
+    DISPMANX_TRANSFORM_T transform;
+    uint32_t display_num;
+}DISPMANX_MODEINFO_T;
+
+typedef struct
+{
+    DISPMANX_ELEMENT_HANDLE_T element;
+    int width;
+    int height;
+}EGL_DISPMANX_WINDOW_T;
+
+/* flags for vc_dispmanx_element_change_attributes */
+#define ELEMENT_CHANGE_LAYER          (1<<0)
+#define ELEMENT_CHANGE_OPACITY        (1<<1)
+#define ELEMENT_CHANGE_DEST_RECT      (1<<2)
+#define ELEMENT_CHANGE_SRC_RECT       (1<<3)
+#define ELEMENT_CHANGE_MASK_RESOURCE  (1<<4)
+#define ELEMENT_CHANGE_TRANSFORM      (1<<5)
+
+static inline int vc_dispmanx_rect_set(VC_RECT_T *rect, uint32_t x_offset, uint32_t y_offset, uint32_t width, uint32_t height)
+{
+    rect->x = (int32_t)x_offset;
+    rect->y = (int32_t)y_offset;
+    rect->width = (int32_t)width;
+    rect->height = (int32_t)height;
+    return 0;
+}
+
+#endif /* __DISPMANX_COMPAT_H*/
@@ -0,0 +1,59 @@
+/*-------------------------------------------------------------------------
+ Frame renderer
+
+ Shows frames produced by the CPU (appsink, overlays, test patterns) on a
+ dispmanx element of its own. A fixed pool of 2 or 3 resources is created
+ up front, every frame is copied into a free one with resource_write_data
+ (through a staging copy when its pitch is not 32 byte aligned) and the
+ element is flipped to it through the display update queue. A resource is
+ only written again once a newer one is on screen, so there is no tearing
+ and nothing is allocated per frame.
+
+ The producer thread only copies. Flips are requested from an idle on the
+ player context (the default main context), one at a time: the next flip
+ goes out once the previous frame is on screen. A frame written while a
+ flip is outstanding waits, and is replaced if a newer frame is written
+ before its flip was requested. When no resource is free or waiting the
+ frame is dropped.
+
+ Works on both backends, the soft compositor keeps the resources in
+ memory so the path can be run and measured without a Pi.
+ Push from one thread, everything else from the player context.
+-------------------------------------------------------------------------*/
+
+#ifndef __DISPMANX_FRAME_H
+#define __DISPMANX_FRAME_H
+
+#include "player.h"
+
+#define DISPMANX_FRAME_MIN_BUFFERS 2
+#define DISPMANX_FRAME_MAX_BUFFERS 3
+/* The VideoCore reads uploaded rows at this pitch alignment, other pitches are staged*/
+#define DISPMANX_FRAME_PITCH_ALIGN 32
+
+typedef struct dispmanx_frame_renderer dispmanx_frame_renderer_t;
+
+typedef struct
+{
+  guint64 frames_pushed;
+  guint64 frames_shown;
+  guint64 frames_dropped;   /* no free resource*/
+  guint64 frames_replaced;  /* overwritten by a newer frame before its flip was requested, never shown*/
+  guint64 frames_staged;    /* copied through the staging buffer for pitch alignment*/
+  guint64 bytes_copied;     /* staging copies included*/
+  guint64 copy_time_us;     /* staging copy plus upload*/
+  guint64 copy_max_us;
+  gint64 elapsed_us;        /* first to last frame on screen*/
+  gdouble fps;              /* frames on screen per second*/
+  gdouble copy_mb_per_s;    /* upload bandwidth while copying*/
+}dispmanx_frame_stats_t;
+
+/*dispmanx_frame.c*/
+dispmanx_frame_renderer_t *dispmanx_frame_renderer_new(int32_t layer, const VC_RECT_T *dst_rect, VC_IMAGE_TYPE_T type,
+    uint32_t width, uint32_t height, guint buffers);
+gboolean dispmanx_frame_renderer_push(dispmanx_frame_renderer_t *renderer, const void *pixels, int32_t pitch);
+void dispmanx_frame_renderer_set_rects(dispmanx_frame_renderer_t *renderer, const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect);
+void dispmanx_frame_renderer_get_stats(dispmanx_frame_renderer_t *renderer, dispmanx_frame_stats_t *stats);
+void dispmanx_frame_renderer_free(dispmanx_frame_renderer_t *renderer);
+
+#endif /* __DISPMANX_FRAME_H*/
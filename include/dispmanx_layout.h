@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------------
+ Video layout
+
+ Computes the dispmanx src_rect (16.16 fixed point, source pixels) and
+ dst_rect (screen pixels) of a video element for an aspect ratio mode.
+ All scaling and cropping is left to the display hardware through the
+ two rects, no videoscale or videocrop element is needed.
+
+ The source display shape is width * par_n : height * par_d, so
+ anamorphic content is laid out correctly. Everything is integer math,
+ the function has no side effects. tests/layout_test.c covers the modes.
+
+ PLAYER_AR_ORIGINAL   fit inside the area, bars where the shapes differ
+ PLAYER_AR_STRETCH    whole frame on the whole area, shape ignored
+ PLAYER_AR_LETTERBOX  full width, bars top and bottom (crops top and
+                      bottom for sources taller than the area)
+ PLAYER_AR_PILLARBOX  full height, bars left and right (crops the sides
+                      for sources wider than the area)
+ PLAYER_AR_CROP       fill the area, the excess of the source is cropped
+ PLAYER_AR_ZOOM       fit, then magnified by zoom around the centre
+ PLAYER_AR_CUSTOM     fit the region of the source given in params
+-------------------------------------------------------------------------*/
+
+#ifndef __DISPMANX_LAYOUT_H
+#define __DISPMANX_LAYOUT_H
+
+#include "player.h"
+
+#define DISPMANX_LAYOUT_ONE (1 << 16) /* 1.0 in 16.16*/
+#define DISPMANX_LAYOUT_MAX_SIZE 32767 /* largest source side 16.16 fits in a VC_RECT_T, larger sources are refused*/
+
+typedef struct
+{
+  uint32_t width;
+  uint32_t height;
+  uint32_t par_n; /* 0 is taken as 1:1*/
+  uint32_t par_d;
+}dispmanx_layout_source_t;
+
+typedef struct
+{
+  dispmanx_player_aspect_ratio_e mode;
+  int32_t zoom;      /* 16.16, PLAYER_AR_ZOOM only, below 1.0 is taken as 1.0*/
+  VC_RECT_T region;  /* 16.16 source pixels, PLAYER_AR_CUSTOM only*/
+}dispmanx_layout_params_t;
+
+/*dispmanx_layout.c*/
+gboolean dispmanx_layout_compute(const dispmanx_layout_source_t *source, const VC_RECT_T *area,
+    const dispmanx_layout_params_t *params, VC_RECT_T *src_rect, VC_RECT_T *dst_rect);
+dispmanx_player_aspect_ratio_e dispmanx_layout_next_mode(dispmanx_player_aspect_ratio_e mode);
+const char *dispmanx_layout_mode_name(dispmanx_player_aspect_ratio_e mode);
+
+#endif /* __DISPMANX_LAYOUT_H*/
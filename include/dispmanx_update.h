@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------------
+ Display update transactions
+
+ Element attribute changes are collected here and submitted to the backend
+ as one update per frame instead of one blocking update per window call.
+ Changes to the same element are merged, a removal drops earlier changes
+ and its resource is only deleted once the removal has been submitted.
+
+ With a context set, the flush runs on that context at most once per frame
+ interval. Without a context every change is submitted immediately unless
+ it is inside a dispmanx_update_begin()/dispmanx_update_end() block.
+
+ In async mode the submit does not wait for vsync, the backend completion
+ is handed back to the context where resources are released and
+ dispmanx_update_notify() callbacks run. At most max_in_flight updates are
+ outstanding, further changes keep coalescing until one completes.
+
+ dispmanx_update_notify() callbacks and resource deletion always run on the
+ context when one is set, in submit order, also for synchronous submits made
+ from another thread. Without a context they run on the submitting thread.
+
+ New elements are added with dispmanx_update_add_elements(), which submits
+ them together with everything queued before them so an add never overtakes
+ a queued change. The handles are needed at once, so adds are not held
+ back by an open begin/end block or a full in flight queue.
+-------------------------------------------------------------------------*/
+
+#ifndef __DISPMANX_UPDATE_H
+#define __DISPMANX_UPDATE_H
+
+#include "player.h"
+#include "dispmanx_backend.h"
+
+#define DISPMANX_UPDATE_DEFAULT_FRAME_US 16667 /* 60Hz*/
+#define DISPMANX_UPDATE_DEFAULT_MAX_IN_FLIGHT 2
+
+typedef void (*dispmanx_update_done_cb)(gpointer user_data);
+
+/* One element for dispmanx_update_add_elements, element is filled in*/
+typedef struct
+{
+    int32_t layer;
+    VC_RECT_T dst_rect;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+    VC_RECT_T src_rect;
+    VC_DISPMANX_ALPHA_T alpha;
+    DISPMANX_TRANSFORM_T transform;
+    DISPMANX_ELEMENT_HANDLE_T element;
+}dispmanx_update_element_t;
+
+typedef struct
+{
+    guint64 changes_requested;  /* element changes and removals queued by callers*/
+    guint64 changes_coalesced;  /* requests merged into an already pending change*/
+    guint64 updates_submitted;  /* backend update_start/submit cycles issued*/
+    guint64 updates_async;      /* of which submitted without blocking*/
+    guint64 submits_deferred;   /* flushes held back because max_in_flight was reached*/
+    guint64 submit_time_us;     /* total submit to on screen time*/
+    guint64 submit_min_us;
+    guint64 submit_max_us;
+    guint in_flight_peak;
+}dispmanx_update_stats_t;
+
+/*dispmanx_update.c*/
+void dispmanx_update_init(const dispmanx_backend_t *backend);
+void dispmanx_update_shutdown(void);
+void dispmanx_update_set_context(GMainContext *context);
+void dispmanx_update_set_async(gboolean async, guint max_in_flight);
+void dispmanx_update_set_frame_interval(gint64 frame_us);
+void dispmanx_update_begin(void);
+void dispmanx_update_end(void);
+int dispmanx_update_change_element(DISPMANX_ELEMENT_HANDLE_T element, uint32_t change_flags, int32_t layer, uint8_t opacity,
+        const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect);
+int dispmanx_update_change_source(DISPMANX_ELEMENT_HANDLE_T element, DISPMANX_RESOURCE_HANDLE_T resource);
+int dispmanx_update_add_elements(DISPMANX_DISPLAY_HANDLE_T display, dispmanx_update_element_t *elements, guint count);
+int dispmanx_update_remove_element(DISPMANX_ELEMENT_HANDLE_T element, DISPMANX_RESOURCE_HANDLE_T resource);
+void dispmanx_update_notify(dispmanx_update_done_cb cb, gpointer user_data);
+void dispmanx_update_flush(void);
+void dispmanx_update_get_stats(dispmanx_update_stats_t *stats);
+
+#endif /* __DISPMANX_UPDATE_H*/
@@ -11,6 +11,7 @@
 #define __DISPMANX_WINDOW_H
 
 #include "player.h"
+#include "dispmanx_backend.h"
 #define WIN_MOVE_STEPS 20
 
 typedef struct
@@ -21,13 +22,23 @@ typedef struct
 
 
 /*dispmanx_window.c*/
+gboolean dispmanx_set_backend(const char *name);
+const char *dispmanx_get_backend_name(void);
+const dispmanx_backend_t *dispmanx_get_backend(void);
+DISPMANX_ELEMENT_HANDLE_T dispmanx_win_add_resource_element(int32_t layer, const VC_RECT_T *dst_rect,
+    DISPMANX_RESOURCE_HANDLE_T resource, const VC_RECT_T *src_rect, uint8_t opacity);
+void dispmanx_get_display_size(int32_t *width, int32_t *height);
 gboolean dispmanx_initialize_window_system(void);
 gboolean dispmanx_create_video_window(player_instance_t *player_instance);
+void dispmanx_destroy_video_window(player_instance_t *player_instance);
 void dispmanx_shutdown_window_system(void);
 void dispmanx_win_show_background_element(dispmanx_background_t *bg, gboolean show);
 void dispmanx_win_destroy_background_element(dispmanx_background_t *bg);
+void dispmanx_win_show_video_element(dispmanx_window_t *vid_win, gboolean show);
 void dispmanx_win_set_fullscreen(dispmanx_window_t *vid_win, gboolean fullscreen);
 void dispmanx_win_set_aspect_ratio(player_instance_t *player_instance, dispmanx_player_aspect_ratio_e ar);
+void dispmanx_win_set_zoom(dispmanx_window_t *vid_win, int32_t zoom);
+void dispmanx_win_set_custom_region(dispmanx_window_t *vid_win, const VC_RECT_T *region);
 void dispmanx_win_move(dispmanx_window_t *vid_win, gint x, gint y); 
 
 #endif /* __DISPMANX_WINDOW_H*/
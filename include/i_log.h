@@ -0,0 +1,86 @@
+/*-------------------------------------------------------------------------
+ Logging
+
+ Levels above I_LOG_LEVEL (meson -Dlog-level=...) compile to nothing, their
+ arguments are still type checked but never evaluated at run time.
+
+ Enabled records are formatted into a ring owned by the calling thread and
+ written out by a background writer, to stdout, a file or syslog
+ (I_PLAYER_LOG=stdout|syslog|file:/path). A full ring drops the record and
+ counts it, a log call never waits for the writer or for the output.
+ Before i_log_init() and after i_log_shutdown() records are written
+ directly, as the old printf macros did.
+
+ The macros keep their trailing ';' so existing call sites which omit it
+ still build.
+-------------------------------------------------------------------------*/
+
+#ifndef __I_LOG_H
+#define __I_LOG_H
+
+#include <stdint.h>
+
+#define I_LOG_LEVEL_NONE    0
+#define I_LOG_LEVEL_FATAL   1
+#define I_LOG_LEVEL_ERROR   2
+#define I_LOG_LEVEL_WARNING 3
+#define I_LOG_LEVEL_INFO    4
+#define I_LOG_LEVEL_DEBUG   5
+#define I_LOG_LEVEL_TRACE   6
+
+#ifndef I_LOG_LEVEL
+#define I_LOG_LEVEL I_LOG_LEVEL_TRACE
+#endif
+
+#define I_LOG_RING_SLOTS 128 /* per thread, power of two*/
+#define I_LOG_MSG_SIZE 224   /* longer messages are truncated*/
+
+#define I_LOG_EMIT(level, msg, args...) \
+    i_log_write((level), __FILE__, __func__, __LINE__, msg, ## args)
+#define I_LOG_DROP(msg, args...) \
+    do { if (0) i_log_write(I_LOG_LEVEL_NONE, NULL, NULL, 0, msg, ## args); } while (0)
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_FATAL
+#define I_LOG_FATAL(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_FATAL, msg, ## args);
+#else
+#define I_LOG_FATAL(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_ERROR
+#define I_LOG_ERROR(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_ERROR, msg, ## args);
+#else
+#define I_LOG_ERROR(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_WARNING
+#define I_LOG_WARNING(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_WARNING, msg, ## args);
+#else
+#define I_LOG_WARNING(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_INFO
+#define I_LOG_INFO(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_INFO, msg, ## args);
+#else
+#define I_LOG_INFO(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_DEBUG
+#define I_LOG_DEBUG(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_DEBUG, msg, ## args);
+#else
+#define I_LOG_DEBUG(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+#if I_LOG_LEVEL >= I_LOG_LEVEL_TRACE
+#define I_LOG_TRACE(msg, args...) I_LOG_EMIT(I_LOG_LEVEL_TRACE, msg, ## args);
+#else
+#define I_LOG_TRACE(msg, args...) I_LOG_DROP(msg, ## args);
+#endif
+
+/* i_log.c*/
+void i_log_init(void);
+void i_log_shutdown(void);
+void i_log_write(int level, const char *file, const char *func, int line, const char *format, ...)
+    __attribute__((format(printf, 5, 6)));
+uint64_t i_log_get_dropped(void);
+
+#endif /* __I_LOG_H*/
@@ -19,11 +19,17 @@
 #include <gst/player/player.h>
 #pragma GCC diagnostic pop
 
+#include "i_log.h"
+
+#if I_PLAYER_HAVE_DISPMANX
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include "bcm_host.h"
 #include "interface/vmcs_host/vc_dispmanx_types.h"
 #include "interface/vmcs_host/vc_vchi_dispmanx.h"
+#else
+#include "dispmanx_compat.h"
+#endif
 
 #define P_MAX_BUFFER_SIZE 128
 #define PLAYER_SRC_ELEM_NAME "Player_Src_Elem"
@@ -32,19 +38,15 @@
 #define IS_STATIC_PAD(pad) (GST_PAD_TEMPLATE_PRESENCE(gst_pad_get_pad_template(pad)) == GST_PAD_ALWAYS)
 
 #define VOLUME_STEPS 20
+#define PLAYER_POSITION_UPDATE_DEFAULT_MS 100
+
+/* Plugins the playbin based pipelines use on the Pi, for player_registry_restrict*/
+#define PLAYER_PLUGIN_ALLOW_LIST "coreelements,playback,typefindfunctions,app,autodetect,videoconvert,videoscale," \
+    "audioconvert,audioresample,volume,isomp4,matroska,id3demux,audioparsers,videoparsersbad,omx,opengl,alsa,libav,soup"
 
-#define I_LOG_FATAL(msg, args...) \
-    printf("\e[0;31m%-9s : %s -> %s(%d) : " msg "\e[0m", "[FATAL]", __FILE__, __func__, __LINE__, ## args);
-#define I_LOG_ERROR(msg, args...) \
-    printf("\e[0;31m%-9s : %s -> %s(%d) : " msg "\e[0m", "[ERROR]", __FILE__, __func__, __LINE__, ## args);
-#define I_LOG_WARNING(msg, args...) \
-    printf("\e[0;33m%-9s : %s -> %s(%d) : " msg "\e[0m", "[WARN]", __FILE__, __func__, __LINE__, ## args);
-#define I_LOG_INFO(msg, args...) \
-    printf("\e[0;32m%-9s :\e[0m %s -> %s(%d) : " msg, "[INFO]", __FILE__, __func__, __LINE__, ## args);
-#define I_LOG_DEBUG(msg, args...) \
-    printf("\e[0;36m%-9s :\e[0m %s -> %s(%d) : " msg, "[DEBUG]", __FILE__, __func__, __LINE__, ## args);
-#define I_LOG_TRACE(msg, args...) \
-    printf("\e[0;34m%-9s :\e[0m %s -> %s(%d) : " msg, "[TRACE]", __FILE__, __func__, __LINE__, ## args);
+/* Concurrent players sharing one display, each owns two layers from PLAYER_LAYER_BASE - 1 up*/
+#define PLAYER_MAX_INSTANCES 16
+#define PLAYER_LAYER_BASE 0
 
 #define I_ASSERT assert
 #define I_ZEROMEM(ptr, length)  (memset(ptr, 0, length))
@@ -60,7 +62,12 @@
 typedef enum
 {
     PLAYER_AR_ORIGINAL = 1,
-    PLAYER_AR_STRETCH
+    PLAYER_AR_STRETCH,
+    PLAYER_AR_LETTERBOX,
+    PLAYER_AR_PILLARBOX,
+    PLAYER_AR_CROP,
+    PLAYER_AR_ZOOM,
+    PLAYER_AR_CUSTOM    /* see dispmanx_layout.h*/
 }dispmanx_player_aspect_ratio_e;
 
 typedef struct
@@ -73,7 +80,12 @@ typedef struct
     guint vid_width;
     guint vid_height;
     gboolean in_fullscreen;
+    guint par_n;            /* pixel aspect ratio, 0 until known*/
+    guint par_d;
     dispmanx_player_aspect_ratio_e ar;
+    int32_t zoom;           /* 16.16, PLAYER_AR_ZOOM*/
+    VC_RECT_T custom_region;/* 16.16 source pixels, PLAYER_AR_CUSTOM*/
+    uint8_t opacity;
 }dispmanx_window_t;
 
 typedef struct
@@ -96,10 +108,28 @@ typedef struct
 } dispmanx_background_t;
 
 
+/* Entries queued after the current uri, switched gaplessly by playbin*/
+typedef struct
+{
+    GMutex lock;
+    GQueue uris;            /* gchar* still to play*/
+    GQueue retired_uris;    /* previous src_uri strings, freed on release*/
+    gulong about_to_finish_id;
+    GstPad *probe_pad;      /* video sink pad used to time the switch*/
+    gulong probe_id;
+    gboolean gapless_pending;
+    gboolean waiting_first_frame;
+    gint64 last_frame_time; /* monotonic us*/
+    gint64 switch_start;
+    gint64 last_switch_us;  /* last frame of the old entry to first frame of the new one*/
+    guint switches;
+}player_playlist_t;
+
 /* Player Structure*/
 typedef struct
 {
     uint32_t player_handler;
+    gint layer_slot;
     char player_name[P_MAX_BUFFER_SIZE];
     gchar *src_uri;
     gchar *dest_uri;
@@ -116,12 +146,20 @@ typedef struct
     GstState desired_state;
 
     /*Trick & Timing*/
-    gint64 duration;
+    gint64 duration; /* cached from duration-changed and media info, -1 while unknown*/
     gboolean seek_enabled;
     gdouble rate;
+    gint64 media_cache_layout_time; /* monotonic, window laid out from the media info cache, 0 otherwise*/
 
     gdouble volume;
 
+    /* Position updates, polled on the main context only while playing*/
+    GCallback position_updated_cb;
+    guint position_interval_ms;
+    guint position_source_id;
+    gint64 position_last_second;    /* last whole second shown by the host, -1 before the first*/
+    GstPlayerState player_state;
+
     /* For handling messages on pipeline bus and sending signals on dbus*/
     GstBus *bus;
     void *player_object;
@@ -130,6 +168,35 @@ typedef struct
     gpointer video_window_handle;
     dispmanx_window_t vid_win;
 	dispmanx_background_t bg;
+
+    player_playlist_t playlist;
+
+    /* Frame statistics, NULL unless player_stats_enable was called*/
+    struct player_stats *stats;
+
+    /* Bus telemetry, see player_monitor.h*/
+    struct player_monitor *monitor;
+
+    /* Set for players without a display, see player_headless.h*/
+    struct player_headless *headless;
+
+    /* Set for players uploading frames themselves, see player_frames.h*/
+    struct player_frames *frames;
+
+    /* Queue sizes, watermarks and stall statistics, see player_buffering.h*/
+    struct player_buffering *buffering;
+
+    /* Seek coalescing, created by the first seek, see player_seek.h*/
+    struct player_seek *seek;
+
+    /* Load accounting per rate, created by the first rate change, see player_trick.h*/
+    struct player_trick *trick;
+
+    /* Seek preview strip, see player_thumbs.h*/
+    struct player_thumbs *thumbs;
+
+    /* Window layout from the sink caps, see player_geometry.h*/
+    struct player_geometry *geometry;
 }player_instance_t;
 
 /* player_interface.c*/
@@ -144,6 +211,35 @@ void player_relative_seek (player_instance_t *player_instance, gdouble percent);
 void player_release(player_instance_t *player_instance);
 void play_set_relative_volume (player_instance_t *player_instance, gdouble volume_step);
 void player_init(void);
+void player_stop_loop(void);
 void player_shutdown(void);
+gchar *player_make_uri(const char *location);
+GstPad *player_get_video_sink_pad(player_instance_t *player_instance);
+gboolean player_element_is_video_sink(GstElement *element);
+int8_t player_set_position_update_interval(player_instance_t *player_instance, guint interval_ms);
+int8_t player_query_position(player_instance_t *player_instance, gint64 *position);
+gint64 player_get_duration(player_instance_t *player_instance);
+
+/* player_playlist.c*/
+void player_playlist_init(player_instance_t *player_instance);
+void player_playlist_release(player_instance_t *player_instance);
+int8_t player_playlist_append(player_instance_t *player_instance, const char *uri);
+void player_playlist_clear(player_instance_t *player_instance);
+int8_t player_playlist_set_uri(player_instance_t *player_instance, const char *location);
+/* After a gapless switch GstPlayer's uri and media info uri are stale, read this one instead*/
+gchar *player_playlist_dup_current_uri(player_instance_t *player_instance);
+int8_t player_playlist_next(player_instance_t *player_instance);
+guint player_playlist_length(player_instance_t *player_instance);
+gint64 player_playlist_get_last_switch_time(player_instance_t *player_instance);
+
+/* player_registry.c*/
+int8_t player_registry_restrict(const char *allow_list);
+
+/* player_manager.c*/
+int8_t player_manager_register(player_instance_t *player_instance);
+void player_manager_unregister(player_instance_t *player_instance);
+player_instance_t *player_manager_lookup(uint32_t handle);
+guint player_manager_count(void);
+guint player_manager_get_handles(uint32_t *handles, guint max_handles);
 
 #endif /*__PLAYER_H*/
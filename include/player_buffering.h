@@ -0,0 +1,57 @@
+/*-------------------------------------------------------------------------
+ Buffering policy
+
+ Sizes the network queues of a player and sets when buffering starts and
+ stops. playbin's queue2 (progressive and HLS sources) and the decodebin
+ multiqueue report 100 % at the high watermark, and once they have
+ reported 100 % they only report again when the level falls below the low
+ watermark. GstPlayer pauses the pipeline on a report below 100 % and
+ resumes it at 100 %, so a wide band between the two gives few long
+ refills instead of a stall every few hundred milliseconds.
+
+ download keeps the whole of a progressive HTTP stream in a temporary
+ file, which makes seeking back free and lets the player run from the
+ file once the network falls behind.
+
+ Every refill after the initial fill is counted as a stall, seeks
+ included, with its duration.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_BUFFERING_H
+#define __PLAYER_BUFFERING_H
+
+#include "player.h"
+
+#define PLAYER_BUFFERING_DEFAULT_SIZE (4 * 1024 * 1024)
+#define PLAYER_BUFFERING_DEFAULT_DURATION ((gint64)(5 * GST_SECOND))
+#define PLAYER_BUFFERING_DEFAULT_LOW 10
+#define PLAYER_BUFFERING_DEFAULT_HIGH 99
+
+typedef struct
+{
+    gint buffer_size;           /* bytes, -1 keeps playbin's default*/
+    gint64 buffer_duration;     /* ns, -1 keeps playbin's default*/
+    gint low_percent;           /* of the queue, buffering starts below this*/
+    gint high_percent;          /* of the queue, playback resumes here*/
+    gboolean download;          /* progressive download to a temporary file*/
+}player_buffering_config_t;
+
+typedef struct
+{
+    gint percent;               /* last reported level*/
+    gboolean buffering;         /* paused for a refill right now*/
+    gint64 initial_us;          /* first report to the first 100 %, -1 until filled*/
+    guint64 stalls;             /* refills after the initial fill*/
+    gint64 stall_time_us;       /* total, the current stall included*/
+    gint64 longest_stall_us;
+    gint min_percent;           /* lowest level reported during playback*/
+}player_buffering_stats_t;
+
+/* player_buffering.c*/
+void player_buffering_config_init(player_buffering_config_t *config);
+int8_t player_buffering_configure(player_instance_t *player_instance, const player_buffering_config_t *config);
+void player_buffering_release(player_instance_t *player_instance);
+int8_t player_buffering_get_stats(player_instance_t *player_instance, player_buffering_stats_t *stats);
+void player_buffering_log_stats(player_instance_t *player_instance);
+
+#endif /* __PLAYER_BUFFERING_H*/
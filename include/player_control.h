@@ -0,0 +1,114 @@
+/*-------------------------------------------------------------------------
+ Local control server
+
+ Drives the players of this process from other processes over a Unix
+ domain socket (I_PLAYER_CONTROL=<path> in the standalone player). Any
+ number of clients may connect, and each may pipeline any number of
+ commands without waiting for the replies. Commands are run by the
+ command dispatcher (player_dispatch.h), so a run of the same command for
+ the same player may be merged, but every command is still acknowledged,
+ in order, with the time from its parsing to the end of its execution.
+
+ Text commands are one line each,
+
+     <seq> <handle> <command> [args]\n
+
+ and are answered with "<seq> <status> <latency_us> [value]\n". seq is
+ echoed back, handle is the player_manager handle of the player, 0 for
+ the default player. Commands are
+
+     play | pause | resume | toggle | stop
+     seek <ms> | skip <ms> | rate <rate>
+     volume <percent> | volume-step <percent>
+     fullscreen <0|1> | move <dx> <dy> | aspect <name|1..6> | background <0|1>
+     uri <location> | list
+
+ list answers with the live handles, comma separated.
+
+ Binary commands start with PLAYER_CONTROL_MAGIC, which can not start a
+ text line, and are a little endian player_control_header_t followed by
+ length bytes of payload: int32 arguments (rate in 1/1000), or the uri.
+ They are answered with a player_control_ack_t.
+
+ All functions are called from the main context, commands run on the
+ player context.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_CONTROL_H
+#define __PLAYER_CONTROL_H
+
+#include "player.h"
+
+#define PLAYER_CONTROL_MAGIC 0xB1
+#define PLAYER_CONTROL_MAX_FRAME 4096        /* longest line or binary payload*/
+#define PLAYER_CONTROL_MAX_PENDING (64 * 1024) /* unsent replies before a client is no longer read*/
+#define PLAYER_CONTROL_MAX_IN_FLIGHT 256         /* commands queued for the player context, likewise*/
+#define PLAYER_CONTROL_MAX_CLIENTS 16
+#define PLAYER_CONTROL_MAX_ARGS 4
+
+typedef enum
+{
+    PLAYER_CONTROL_OP_PLAY = 1,
+    PLAYER_CONTROL_OP_PAUSE,
+    PLAYER_CONTROL_OP_RESUME,
+    PLAYER_CONTROL_OP_TOGGLE_PAUSE,
+    PLAYER_CONTROL_OP_STOP,
+    PLAYER_CONTROL_OP_SEEK,          /* ms*/
+    PLAYER_CONTROL_OP_SKIP,          /* ms, relative*/
+    PLAYER_CONTROL_OP_RATE,          /* 1/1000*/
+    PLAYER_CONTROL_OP_VOLUME,        /* percent*/
+    PLAYER_CONTROL_OP_VOLUME_STEP,   /* percent, relative*/
+    PLAYER_CONTROL_OP_FULLSCREEN,    /* 0 or 1*/
+    PLAYER_CONTROL_OP_MOVE,          /* dx, dy*/
+    PLAYER_CONTROL_OP_ASPECT,        /* dispmanx_player_aspect_ratio_e, up to PLAYER_AR_ZOOM*/
+    PLAYER_CONTROL_OP_BACKGROUND,    /* 0 or 1*/
+    PLAYER_CONTROL_OP_URI,           /* payload is the location*/
+    PLAYER_CONTROL_OP_LIST           /* ack value is the number of players*/
+}player_control_op_e;
+
+typedef enum
+{
+    PLAYER_CONTROL_OK = 0,
+    PLAYER_CONTROL_FAILED,
+    PLAYER_CONTROL_NO_PLAYER,
+    PLAYER_CONTROL_BAD_COMMAND
+}player_control_status_e;
+
+/* on the wire, little endian, 12 and 16 bytes without padding*/
+typedef struct
+{
+    uint8_t magic;
+    uint8_t op;
+    uint16_t length;
+    uint32_t seq;
+    uint32_t handle;
+}player_control_header_t;
+
+typedef struct
+{
+    uint8_t magic;
+    uint8_t op;
+    uint8_t status;
+    uint8_t reserved;
+    uint32_t seq;
+    uint32_t latency_us;
+    int32_t value;
+}player_control_ack_t;
+
+typedef struct
+{
+    guint64 clients;            /* accepted so far*/
+    guint64 commands;
+    guint64 errors;             /* commands not answered with PLAYER_CONTROL_OK*/
+    guint64 protocol_errors;    /* clients dropped for malformed or oversized frames*/
+    gint64 latency_total_us;
+    gint64 latency_max_us;
+}player_control_stats_t;
+
+/* player_control.c*/
+int8_t player_control_start(const char *socket_path, uint32_t default_handle);
+void player_control_set_default(uint32_t handle);
+void player_control_stop(void);
+void player_control_get_stats(player_control_stats_t *stats);
+
+#endif /* __PLAYER_CONTROL_H*/
@@ -0,0 +1,80 @@
+/*-------------------------------------------------------------------------
+ Command dispatcher
+
+ Every source of control (keyboard, control socket, GstPlayer signal
+ handlers) pushes commands here instead of calling into GstPlayer and
+ the window functions itself. Pushing is lock free and allowed from any
+ thread: commands go into an intrusive multi producer single consumer
+ queue and the first push of a burst schedules one drain on the player
+ context, where all of them run in the order they were pushed.
+
+ Commands for the same player and of the same kind which follow each
+ other in the queue form a run and are merged before anything runs:
+
+ PLAYER_DISPATCH_MERGE_LAST    only the last one runs (absolute seek, uri)
+ PLAYER_DISPATCH_MERGE_SUM     the first one runs with the arguments of all
+                               of them added up (window moves, relative seeks)
+ PLAYER_DISPATCH_MERGE_TOGGLE  one runs if the run is odd, none if it is even
+
+ Every pushed command still gets its done callback, in push order, with
+ the result of the command which ran for it.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_DISPATCH_H
+#define __PLAYER_DISPATCH_H
+
+#include "player.h"
+
+#define PLAYER_DISPATCH_MAX_ARGS 4
+#define PLAYER_DISPATCH_MAX_BATCH 256 /* commands per drain, merging does not cross drains*/
+
+typedef enum
+{
+    PLAYER_DISPATCH_MERGE_NONE = 0,
+    PLAYER_DISPATCH_MERGE_LAST,
+    PLAYER_DISPATCH_MERGE_SUM,
+    PLAYER_DISPATCH_MERGE_TOGGLE
+}player_dispatch_merge_e;
+
+typedef struct player_dispatch_command player_dispatch_command_t;
+
+/* player context, player_instance is NULL when the handle is 0 or no longer valid*/
+typedef int8_t (*player_dispatch_exec_cb)(player_instance_t *player_instance, player_dispatch_command_t *command);
+typedef void (*player_dispatch_done_cb)(player_dispatch_command_t *command, int8_t result, gint64 latency_us);
+
+struct player_dispatch_command
+{
+    player_dispatch_command_t *next;    /* queue link, owned by the dispatcher*/
+    player_dispatch_command_t *run_next;
+    uint32_t handle;
+    guint kind;                         /* commands of the same kind and handle may merge*/
+    player_dispatch_merge_e merge;
+    gint64 args[PLAYER_DISPATCH_MAX_ARGS];
+    gchar *text;                        /* freed with the command*/
+    player_dispatch_exec_cb exec;
+    player_dispatch_done_cb done;
+    gpointer data;
+    GDestroyNotify data_free;
+    gint64 queued_time;                 /* monotonic, latency is counted from here*/
+};
+
+typedef struct
+{
+    guint64 pushed;
+    guint64 executed;
+    guint64 merged;             /* commands which did not run of their own*/
+    guint64 drains;
+    guint max_batch;            /* most commands handled by one drain*/
+    gint64 latency_total_us;    /* push to done, divide by pushed*/
+    gint64 latency_max_us;
+}player_dispatch_stats_t;
+
+/* player_dispatch.c*/
+void player_dispatch_init(GMainContext *context);
+void player_dispatch_shutdown(void);
+player_dispatch_command_t *player_dispatch_command_new(uint32_t handle, guint kind, player_dispatch_merge_e merge, player_dispatch_exec_cb exec);
+void player_dispatch_push(player_dispatch_command_t *command);
+void player_dispatch_get_stats(player_dispatch_stats_t *stats);
+void player_dispatch_log_stats(void);
+
+#endif /* __PLAYER_DISPATCH_H*/
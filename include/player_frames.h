@@ -0,0 +1,34 @@
+/*-------------------------------------------------------------------------
+ Direct frame upload
+
+ A player from player_get_frame_handler() has no EGL window and no video
+ renderer. Its playbin renders into an appsink negotiated to RGBA and
+ every sample is copied into a dispmanx_frame renderer (see
+ dispmanx_frame.h) on the player's video layer, placed with the layout
+ engine like the normal window.
+
+ The streaming thread only copies. The renderer is built from an idle on
+ the player context once the first sample's size is known and re-built
+ there when the video size changes, not per frame; samples arriving while
+ no renderer of their size exists are counted as dropped. Frames are also
+ dropped when the display holds every buffer of the pool.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_FRAMES_H
+#define __PLAYER_FRAMES_H
+
+#include "player.h"
+#include "dispmanx_frame.h"
+
+#define PLAYER_FRAMES_DEFAULT_BUFFERS 3
+
+/* player_frames.c*/
+int8_t player_frames_setup(player_instance_t *player_instance, guint buffers);
+void player_frames_release(player_instance_t *player_instance);
+int8_t player_frames_get_stats(player_instance_t *player_instance, dispmanx_frame_stats_t *stats);
+void player_frames_log_stats(player_instance_t *player_instance);
+
+/* player_interface.c*/
+int8_t player_get_frame_handler(const char *src_uri, guint buffers, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance);
+
+#endif /* __PLAYER_FRAMES_H*/
@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ Early window geometry
+
+ Lays the video window out from the CAPS event on the video sink pad
+ instead of waiting for GstPlayer's media-info-updated, which is emitted
+ from the bus long after negotiation. A resolution change mid stream is
+ handled the same way.
+
+ The probe only records the new geometry, the window itself is changed
+ on the player context inside one dispmanx_update_begin()/end() block.
+ The first buffer after a change is held at the sink pad until that
+ block is queued, so the new rectangles are queued before the sink
+ renders the frame. The frame goes through EGL, not through the update
+ queue, so both reach the screen at the next vsync at best, not in one
+ update. The hold is bounded (50 ms) so a context that is itself waiting
+ on the pipeline does not deadlock; a timed out hold lets the frame
+ through at the old layout and is counted.
+ The time from the caps event to the update being on screen is measured
+ with dispmanx_update_notify() and logged when the player is released.
+
+ Only windowed players have one, the frame upload path takes its size
+ from the caps itself and headless players have no window.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_GEOMETRY_H
+#define __PLAYER_GEOMETRY_H
+
+#include "player.h"
+
+typedef struct
+{
+    guint64 caps_events;        /* video caps seen at the sink*/
+    guint64 changes;            /* of which changed the window*/
+    guint64 unchanged;          /* of which the window already had, from the media info cache or earlier caps*/
+    gint64 first_caps_to_window_us;  /* -1 until the first change is on screen*/
+    gint64 last_caps_to_window_us;
+    gint64 max_caps_to_window_us;
+    gint64 total_caps_to_window_us;  /* divide by changes_on_screen*/
+    guint64 changes_on_screen;
+    guint64 buffers_held;       /* first buffers after a change that waited for the layout*/
+    guint64 hold_timeouts;      /* of which went through before the layout was queued*/
+}player_geometry_stats_t;
+
+/* player_geometry.c*/
+int8_t player_geometry_setup(player_instance_t *player_instance);
+void player_geometry_attach_sink(player_instance_t *player_instance, GstElement *video_sink);
+void player_geometry_get_stats(player_instance_t *player_instance, player_geometry_stats_t *stats);
+void player_geometry_log_stats(player_instance_t *player_instance);
+void player_geometry_release(player_instance_t *player_instance);
+
+#endif /* __PLAYER_GEOMETRY_H*/
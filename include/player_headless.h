@@ -0,0 +1,45 @@
+/*-------------------------------------------------------------------------
+ Headless decode throughput
+
+ A player from player_get_headless_handler() has no window and no video
+ renderer. Its playbin renders into a fakesink or an appsink with sync
+ disabled, so the pipeline runs as fast as the source and the decoders
+ allow, and the video sink pad counts decoded frames and bytes. The
+ source pad counts the encoded bytes read.
+
+ Used to check offline whether a board decodes given content faster than
+ real time (realtime_factor > 1.0).
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_HEADLESS_H
+#define __PLAYER_HEADLESS_H
+
+#include "player.h"
+
+typedef enum
+{
+    PLAYER_HEADLESS_FAKESINK = 1,
+    PLAYER_HEADLESS_APPSINK      /* samples are pulled like a real consumer would*/
+}player_headless_sink_e;
+
+typedef struct
+{
+    guint64 frames;
+    guint64 decoded_bytes;      /* at the video sink*/
+    guint64 input_bytes;        /* read by the source element*/
+    gint64 elapsed_us;          /* first to last frame*/
+    gint64 stream_time_us;      /* media time covered by those frames*/
+    gdouble fps;
+    gdouble realtime_factor;    /* stream time / wall time*/
+}player_headless_stats_t;
+
+/* player_headless.c*/
+int8_t player_headless_setup(player_instance_t *player_instance, player_headless_sink_e sink_type);
+void player_headless_release(player_instance_t *player_instance);
+int8_t player_headless_get_stats(player_instance_t *player_instance, player_headless_stats_t *stats);
+void player_headless_log_stats(player_instance_t *player_instance);
+
+/* player_interface.c*/
+int8_t player_get_headless_handler(const char *src_uri, player_headless_sink_e sink_type, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance);
+
+#endif /* __PLAYER_HEADLESS_H*/
@@ -0,0 +1,69 @@
+/*-------------------------------------------------------------------------
+ Media info cache
+
+ Remembers what was learnt about a uri (video size, pixel aspect ratio,
+ frame rate, duration, tracks) across runs, in a key file in the user
+ cache dir (i_player/media_info). player_play lays the video window out
+ from a cached entry before the pipeline has pre-rolled, so the first
+ frame comes up at its final size instead of being resized once
+ GstPlayer reports the media info.
+
+ Entries are written from the media info of every played uri, and
+ uris which are only queued (playlist, warm pool) are discovered in the
+ background with GstDiscoverer on the player context. A local file's
+ entry is only used while its size and mtime match, other uris expire
+ after PLAYER_MEDIA_CACHE_MAX_AGE_S.
+
+ Hits, misses and the time the correct layout was on screen earlier
+ than without the cache are counted and logged at shutdown.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_MEDIA_CACHE_H
+#define __PLAYER_MEDIA_CACHE_H
+
+#include "player.h"
+
+#define PLAYER_MEDIA_CACHE_MAX_ENTRIES 256
+#define PLAYER_MEDIA_CACHE_MAX_AGE_S (24 * 60 * 60)
+#define PLAYER_MEDIA_CACHE_DISCOVER_TIMEOUT (10 * GST_SECOND)
+#define PLAYER_MEDIA_CACHE_SAVE_DELAY_S 2
+
+typedef struct
+{
+    guint width;            /* 0 without video*/
+    guint height;
+    guint par_n;
+    guint par_d;
+    gint fps_n;
+    gint fps_d;
+    gint64 duration;        /* ns, -1 unknown or live*/
+    guint video_tracks;
+    guint audio_tracks;
+    guint subtitle_tracks;
+    gboolean seekable;
+}player_media_info_t;
+
+typedef struct
+{
+    guint64 lookups;
+    guint64 hits;
+    guint64 misses;
+    guint64 stale;          /* entries dropped because the file changed or they expired*/
+    guint64 discoveries;
+    guint64 discovery_failures;
+    gint64 discovery_us;    /* total time spent discovering*/
+    gint64 saved_us;        /* pre-sized layout to the media info which would have done it*/
+    guint entries;
+}player_media_cache_stats_t;
+
+/* player_media_cache.c*/
+void player_media_cache_init(void);
+void player_media_cache_shutdown(void);
+gboolean player_media_cache_lookup(const char *uri, player_media_info_t *info);
+void player_media_cache_store(const char *uri, const player_media_info_t *info);
+int8_t player_media_cache_discover(const char *uri);
+void player_media_cache_add_saved(gint64 saved_us);
+void player_media_cache_get_stats(player_media_cache_stats_t *stats);
+void player_media_cache_log_stats(void);
+
+#endif /* __PLAYER_MEDIA_CACHE_H*/
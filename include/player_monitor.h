@@ -0,0 +1,56 @@
+/*-------------------------------------------------------------------------
+ Bus monitor
+
+ Listens on the pipeline bus of a player for the messages which explain
+ playback problems after the fact: QOS, LATENCY, BUFFERING, WARNING and
+ STREAM_STATUS. Each type is counted per player, and the interesting ones
+ go into a bounded timeline (the oldest events are overwritten, repeated
+ QOS from one element is folded into one entry). A summary is logged when
+ the player is released.
+
+ GstPlayer already runs a signal watch on the bus, so messages arrive on
+ GstPlayer's own thread and everything here is guarded by one mutex.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_MONITOR_H
+#define __PLAYER_MONITOR_H
+
+#include "player.h"
+
+#define PLAYER_MONITOR_TIMELINE 128 /* events kept per player*/
+#define PLAYER_MONITOR_QOS_FOLD_US (1 * G_USEC_PER_SEC) /* QOS from one element within this is one event*/
+
+typedef struct
+{
+    gint64 time_us;             /* since the monitor started*/
+    GstMessageType type;
+    guint repeat;               /* folded QOS messages*/
+    gchar source[32];
+    gchar detail[96];
+}player_monitor_event_t;
+
+typedef struct
+{
+    guint64 qos;
+    guint64 qos_dropped;        /* latest processed/dropped pair summed over all elements*/
+    guint64 qos_processed;
+    gint64 max_jitter_us;
+    guint64 latency;
+    guint64 buffering;
+    guint64 buffering_stalls;   /* times the level fell below 100 %*/
+    gint buffering_min_percent;
+    gint64 buffering_time_us;   /* total time below 100 %*/
+    guint64 warnings;
+    guint64 stream_status;
+    gint streaming_threads;     /* entered minus left*/
+    gint64 elapsed_us;
+}player_monitor_counters_t;
+
+/* player_monitor.c*/
+int8_t player_monitor_start(player_instance_t *player_instance);
+void player_monitor_stop(player_instance_t *player_instance);
+int8_t player_monitor_get_counters(player_instance_t *player_instance, player_monitor_counters_t *counters);
+guint player_monitor_get_timeline(player_instance_t *player_instance, player_monitor_event_t *events, guint max_events);
+void player_monitor_log_summary(player_instance_t *player_instance);
+
+#endif /* __PLAYER_MONITOR_H*/
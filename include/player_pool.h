@@ -0,0 +1,58 @@
+/*-------------------------------------------------------------------------
+ Warm player pool
+
+ Keeps pre-built players for a configured set of uris, pre-rolled in
+ PAUSED with their video window hidden. Switching to a warm entry is a
+ play plus an opacity swap of the two windows in one display update, no
+ pipeline construction, typefinding or decoder setup.
+
+ The number of warm players is bounded by max_warm and by an estimated
+ memory budget, the least recently used entry which is not on screen is
+ released first and re-built on its next switch (a cold switch).
+
+ All functions are called from the main context.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_POOL_H
+#define __PLAYER_POOL_H
+
+#include "player.h"
+
+#define PLAYER_POOL_DEFAULT_MAX_WARM 4
+#define PLAYER_POOL_DEFAULT_BUDGET (64 * 1024 * 1024)
+#define PLAYER_POOL_BASE_COST (4 * 1024 * 1024) /* demuxer, queues and sink per player*/
+#define PLAYER_POOL_DECODE_FRAMES 8 /* decoded frames held by decoder and sink*/
+
+typedef struct
+{
+    guint max_warm;          /* players kept pre-rolled, the visible one included*/
+    guint64 memory_budget;   /* estimated bytes for all warm players*/
+}player_pool_config_t;
+
+typedef struct
+{
+    guint64 switches;
+    guint64 warm_hits;       /* switches served by a pre-rolled player*/
+    guint64 cold_misses;     /* switches which had to build the player first*/
+    guint64 evictions;
+    guint warm;              /* currently warm players*/
+    guint64 memory_estimate; /* bytes, for the warm players*/
+    gint64 last_switch_us;   /* switch call to the display update showing the new window on screen*/
+    gint64 warm_switch_us;   /* totals, divide by warm_hits / cold_misses*/
+    gint64 cold_switch_us;
+    gint64 min_switch_us;
+    gint64 max_switch_us;
+}player_pool_stats_t;
+
+/* player_pool.c*/
+void player_pool_init(const player_pool_config_t *config, i_player_signal_handlers_t *sig_handlers);
+void player_pool_shutdown(void);
+int8_t player_pool_add(const char *src_uri);
+int8_t player_pool_remove(const char *src_uri);
+guint player_pool_length(void);
+const gchar *player_pool_get_uri(guint index);
+int8_t player_pool_switch(const char *src_uri, player_instance_t *current, player_instance_t **next);
+gboolean player_pool_owns(player_instance_t *player_instance);
+void player_pool_get_stats(player_pool_stats_t *stats);
+
+#endif /* __PLAYER_POOL_H*/
@@ -0,0 +1,52 @@
+/*-------------------------------------------------------------------------
+ Seek controller
+
+ Every flushing seek throws away the queued data of the whole pipeline,
+ so a burst of seek keys must not become a burst of seeks. Requests are
+ coalesced: only one seek is in flight, requests arriving meanwhile only
+ move the target and the newest target is sought when the seek in flight
+ is done (ASYNC_DONE).
+
+ While input keeps coming the seeks are KEY_UNIT | SNAP, which decode
+ from the nearest key frame and show it at once. Once no request came
+ for PLAYER_SEEK_SETTLE_MS a single ACCURATE seek lands on the exact
+ target.
+
+ Rate changes are seeks too and share the queue, at trick rates (see
+ player_trick.h) every seek is a key frame only trick mode seek.
+
+ Latency is taken from issuing a seek to the first frame at the video
+ sink after its flush. Requests come from the main context, seeks are
+ also issued from GstPlayer's thread when the previous one is done.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_SEEK_H
+#define __PLAYER_SEEK_H
+
+#include "player.h"
+
+#define PLAYER_SEEK_SETTLE_MS 300
+
+typedef struct
+{
+    guint64 requests;
+    guint64 coalesced;          /* requests replaced by a newer one before being sought*/
+    guint64 scrub_seeks;        /* KEY_UNIT seeks issued*/
+    guint64 accurate_seeks;
+    gint64 last_latency_us;     /* seek issued to its first frame, -1 before any*/
+    gint64 min_latency_us;
+    gint64 max_latency_us;
+    gint64 total_latency_us;
+    guint64 latency_samples;
+    gint64 last_settle_us;      /* last request of a burst to the exact frame, -1 before any*/
+}player_seek_stats_t;
+
+/* player_seek.c*/
+int8_t player_seek_to(player_instance_t *player_instance, gint64 position);
+int8_t player_seek_relative(player_instance_t *player_instance, gint64 offset);
+int8_t player_seek_set_rate(player_instance_t *player_instance, gint64 position, gdouble rate);
+void player_seek_release(player_instance_t *player_instance);
+int8_t player_seek_get_stats(player_instance_t *player_instance, player_seek_stats_t *stats);
+void player_seek_log_stats(player_instance_t *player_instance);
+
+#endif /* __PLAYER_SEEK_H*/
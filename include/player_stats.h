@@ -0,0 +1,49 @@
+/*-------------------------------------------------------------------------
+ Frame statistics
+
+ Optional per player rendering health, collected with probes on the video
+ sink pad of the playbin GstPlayer runs:
+
+ - frames reaching the sink and the interval between them, as a histogram
+   and as a running jitter against the expected frame duration,
+ - late buffers, from the QoS events the sink sends upstream after each
+   render (positive jitter means the frame was shown late),
+ - dropped frames, from the sink's QoS messages on the bus.
+
+ Nothing is attached until player_stats_enable() is called.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_STATS_H
+#define __PLAYER_STATS_H
+
+#include "player.h"
+
+#define PLAYER_STATS_BUCKETS 12 /* see player_stats_bucket_limit()*/
+
+typedef struct
+{
+    guint64 frames;
+    guint64 late;               /* QoS events with positive jitter*/
+    guint64 dropped;            /* reported by the sink*/
+    guint64 qos_events;
+    gint64 max_lateness_us;
+    gdouble proportion;         /* last QoS proportion, > 1.0 means the sink cannot keep up*/
+    gint64 interval_min_us;
+    gint64 interval_max_us;
+    gint64 interval_mean_us;
+    gint64 jitter_us;           /* running mean deviation from the expected interval*/
+    guint64 histogram[PLAYER_STATS_BUCKETS];
+    gint64 elapsed_us;          /* since enable or reset*/
+}player_stats_snapshot_t;
+
+/* player_stats.c*/
+int8_t player_stats_enable(player_instance_t *player_instance);
+void player_stats_disable(player_instance_t *player_instance);
+void player_stats_attach_sink(player_instance_t *player_instance, GstElement *video_sink);
+void player_stats_reset(player_instance_t *player_instance);
+int8_t player_stats_get(player_instance_t *player_instance, player_stats_snapshot_t *snapshot);
+gint64 player_stats_bucket_limit(guint bucket);
+gchar *player_stats_to_json(player_instance_t *player_instance);
+int8_t player_stats_dump(player_instance_t *player_instance, const char *path);
+
+#endif /* __PLAYER_STATS_H*/
@@ -0,0 +1,64 @@
+/*-------------------------------------------------------------------------
+ Seek preview thumbnails
+
+ Builds a strip of small RGB565 frames, one every interval of the media
+ of a player, for seek previews in a UI. A second playbin decodes video
+ only into an appsink and is stepped through the positions with key unit
+ seeks in PAUSED, so only the key frame at each position is decoded and
+ scaled.
+
+ The pipeline runs from a worker thread whose threads, the streaming
+ threads included, are set to SCHED_IDLE, and after each frame the worker
+ sleeps as long as the frame took, so the foreground player always wins.
+
+ A position which fails to seek or decode is left black and counted in
+ the strip's missing, the strip is still delivered but not cached.
+
+ Finished strips are cached on disk (the user cache dir, i_player/thumbs)
+ under a key of the uri, the thumbnail size, the interval and for local
+ files the size and mtime. A cache hit is loaded from within
+ player_thumbs_request.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_THUMBS_H
+#define __PLAYER_THUMBS_H
+
+#include "player.h"
+
+#define PLAYER_THUMBS_DEFAULT_WIDTH 160
+#define PLAYER_THUMBS_DEFAULT_HEIGHT 90
+#define PLAYER_THUMBS_DEFAULT_INTERVAL ((gint64)(10 * GST_SECOND))
+#define PLAYER_THUMBS_MAX_COUNT 1024
+#define PLAYER_THUMBS_BYTES_PER_PIXEL 2 /* VC_IMAGE_RGB565*/
+
+typedef struct
+{
+    guint width;            /* of one thumbnail*/
+    guint height;
+    gint64 interval;        /* ns between thumbnails*/
+}player_thumbs_config_t;
+
+typedef struct
+{
+    guint width;
+    guint height;
+    guint count;
+    gint64 interval;
+    gboolean from_cache;
+    gint64 build_us;        /* extraction or cache load time*/
+    guint missing;          /* positions which could not be seeked to or decoded, left black. Such strips are not cached*/
+    guint8 *pixels;         /* count frames of width * height RGB565 pixels, pitch width * 2*/
+}player_thumbs_strip_t;
+
+/* main context, strip is NULL when no strip could be built. The strip belongs to the player*/
+typedef void (*player_thumbs_ready_cb)(player_instance_t *player_instance, const player_thumbs_strip_t *strip, gpointer user_data);
+
+/* player_thumbs.c*/
+void player_thumbs_config_init(player_thumbs_config_t *config);
+int8_t player_thumbs_request(player_instance_t *player_instance, const player_thumbs_config_t *config,
+        player_thumbs_ready_cb ready_cb, gpointer user_data);
+const player_thumbs_strip_t *player_thumbs_get(player_instance_t *player_instance);
+const guint8 *player_thumbs_at(const player_thumbs_strip_t *strip, gint64 position);
+void player_thumbs_release(player_instance_t *player_instance);
+
+#endif /* __PLAYER_THUMBS_H*/
@@ -0,0 +1,42 @@
+/*-------------------------------------------------------------------------
+ Startup checkpoints
+
+ Monotonic timestamps taken once per process along the startup path, from
+ main() to the first frame reaching the video sink. Only the first mark of
+ each checkpoint is kept, so marks can be left in code which runs again
+ later (every state change, every player).
+
+ The report is JSON, one object with every checkpoint in the order it was
+ reached, its time since process start and the time since the previous
+ checkpoint (the phase it closes). Steps which run side by side only get
+ the part which was not hidden behind the other.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_TIMING_H
+#define __PLAYER_TIMING_H
+
+#include "player.h"
+
+typedef enum
+{
+    PLAYER_TIMING_PROCESS_START = 0,
+    PLAYER_TIMING_WINDOW_SYSTEM_INIT,   /* dispmanx_initialize_window_system done*/
+    PLAYER_TIMING_GST_INIT,             /* gst_init done*/
+    PLAYER_TIMING_PLAYER_INIT,          /* player_init done*/
+    PLAYER_TIMING_GET_HANDLER,          /* player_get_handler done*/
+    PLAYER_TIMING_PLAY,                 /* player_play returned*/
+    PLAYER_TIMING_FIRST_STATE_CHANGED,  /* first GstPlayer state-changed*/
+    PLAYER_TIMING_FIRST_MEDIA_INFO,     /* first media-info-updated*/
+    PLAYER_TIMING_FIRST_FRAME,          /* first buffer at the video sink*/
+    PLAYER_TIMING_MAX
+}player_timing_checkpoint_e;
+
+/* player_timing.c*/
+void player_timing_mark(player_timing_checkpoint_e checkpoint);
+gint64 player_timing_get(player_timing_checkpoint_e checkpoint);
+void player_timing_set_report(const char *path);
+void player_timing_finish(void);
+gchar *player_timing_report_json(void);
+int8_t player_timing_write_report(const char *path);
+
+#endif /* __PLAYER_TIMING_H*/
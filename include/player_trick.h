@@ -0,0 +1,48 @@
+/*-------------------------------------------------------------------------
+ Trick modes
+
+ Fast forward and rewind at any rate. Above PLAYER_TRICK_KEY_UNITS_RATE
+ and for every reverse rate the rate seek asks for key frames only
+ (GST_SEEK_FLAG_TRICKMODE_KEY_UNITS), so the decoder skips the frames in
+ between instead of decoding all of them and falling behind the clock;
+ audio is dropped. Up to PLAYER_TRICK_KEY_UNITS_RATE every frame is still
+ decoded.
+
+ Returning to 1x is an accurate seek to the current position, playback
+ goes on from the frame on screen instead of jumping to a key frame.
+
+ The time spent at each rate is accounted with the frames reaching the
+ video sink and the CPU used by the process, which gives the decode load
+ of the rate.
+-------------------------------------------------------------------------*/
+
+#ifndef __PLAYER_TRICK_H
+#define __PLAYER_TRICK_H
+
+#include "player.h"
+
+#define PLAYER_TRICK_KEY_UNITS_RATE 2.0
+#define PLAYER_TRICK_MAX_RATE 64.0
+#define PLAYER_TRICK_MAX_LOADS 16 /* distinct rates accounted per player*/
+
+#define PLAYER_RATE_IS_TRICK(rate) ((rate) < 0.0 || (rate) > PLAYER_TRICK_KEY_UNITS_RATE)
+
+typedef struct
+{
+    gdouble rate;
+    gint64 wall_us;         /* time spent at this rate*/
+    gint64 cpu_us;          /* user + system time of the process meanwhile*/
+    guint64 frames;         /* at the video sink*/
+    gdouble fps;
+    gdouble cpu_percent;    /* of one core*/
+}player_trick_load_t;
+
+/* player_trick.c*/
+int8_t player_set_rate(player_instance_t *player_instance, gdouble rate);
+gdouble player_get_rate(player_instance_t *player_instance);
+int8_t player_step_rate(player_instance_t *player_instance, gboolean forward);
+guint player_trick_get_load(player_instance_t *player_instance, player_trick_load_t *loads, guint max_loads);
+void player_trick_log_load(player_instance_t *player_instance);
+void player_trick_release(player_instance_t *player_instance);
+
+#endif /* __PLAYER_TRICK_H*/
@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ CPU only stand-in for the dispmanx compositor.
+
+ Keeps displays, resources and elements (layer, rects, opacity) in memory,
+ applies updates on submit like the VideoCore does, and can compose the
+ current scene into an ARGB8888 buffer. Select it with
+ I_PLAYER_WINDOW_BACKEND=soft, the display size can be given with
+ I_PLAYER_SOFT_DISPLAY=<width>x<height> (default 1920x1080).
+-------------------------------------------------------------------------*/
+
+#ifndef __SOFT_COMPOSITOR_H
+#define __SOFT_COMPOSITOR_H
+
+#include "player.h"
+#include "dispmanx_backend.h"
+
+#define SOFT_COMPOSITOR_DEFAULT_WIDTH 1920
+#define SOFT_COMPOSITOR_DEFAULT_HEIGHT 1080
+
+/* Colour used for elements without a resource (video surfaces filled by the GPU on a Pi)*/
+#define SOFT_COMPOSITOR_VIDEO_COLOR 0xFF808080
+
+typedef struct
+{
+    int32_t layer;
+    uint8_t opacity;
+    VC_RECT_T dst_rect;
+    VC_RECT_T src_rect;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+}soft_compositor_element_t;
+
+typedef struct
+{
+    guint64 updates_started;
+    guint64 updates_submitted;
+    guint64 element_changes;
+    guint64 source_changes;
+    guint64 frames_composed;
+    guint64 compose_time_us;
+    guint elements;
+    guint resources;
+}soft_compositor_stats_t;
+
+/*soft_compositor.c*/
+void soft_compositor_set_display_size(int32_t width, int32_t height);
+gboolean soft_compositor_get_element(DISPMANX_ELEMENT_HANDLE_T element, soft_compositor_element_t *info);
+int soft_compositor_compose(uint32_t *pixels, uint32_t pitch, int32_t width, int32_t height);
+void soft_compositor_get_stats(soft_compositor_stats_t *stats);
+void soft_compositor_reset_stats(void);
+
+#endif /* __SOFT_COMPOSITOR_H*/
@@ -0,0 +1,75 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#include "player.h"
+#include "dispmanx_backend.h"
+
+/* Thin wrappers over the VideoCore dispmanx API*/
+
+static DISPMANX_ELEMENT_HANDLE_T s_vc_element_add(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t layer, const VC_RECT_T *dst_rect, DISPMANX_RESOURCE_HANDLE_T src,
+    const VC_RECT_T *src_rect, VC_DISPMANX_ALPHA_T *alpha, DISPMANX_TRANSFORM_T transform)
+{
+  return vc_dispmanx_element_add(update, display, layer, dst_rect, src, src_rect,
+      DISPMANX_PROTECTION_NONE, alpha, NULL, transform);
+}
+
+static int s_vc_element_change_attributes(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+    uint32_t change_flags, int32_t layer, uint8_t opacity,
+    const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect)
+{
+  return vc_dispmanx_element_change_attributes(update, element, change_flags, layer, opacity,
+      dst_rect, src_rect, 0, DISPMANX_NO_ROTATE);
+}
+
+static DISPMANX_RESOURCE_HANDLE_T s_vc_resource_create(VC_IMAGE_TYPE_T type, uint32_t width, uint32_t height)
+{
+  uint32_t image_ptr;
+
+  return vc_dispmanx_resource_create(type, width, height, &image_ptr);
+}
+
+static const dispmanx_backend_t s_vc_backend =
+{
+  "dispmanx",
+  TRUE,
+  bcm_host_init,
+  bcm_host_deinit,
+  vc_dispmanx_display_open,
+  vc_dispmanx_display_get_info,
+  vc_dispmanx_display_close,
+  vc_dispmanx_update_start,
+  vc_dispmanx_update_submit_sync,
+  vc_dispmanx_update_submit,
+  s_vc_element_add,
+  s_vc_element_change_attributes,
+  vc_dispmanx_element_change_source,
+  vc_dispmanx_element_remove,
+  s_vc_resource_create,
+  vc_dispmanx_resource_write_data,
+  vc_dispmanx_resource_delete
+};
+
+const dispmanx_backend_t *dispmanx_backend_vc(void)
+{
+  return &s_vc_backend;
+}
@@ -0,0 +1,387 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "player.h"
+#include "dispmanx_window.h"
+#include "dispmanx_update.h"
+#include "dispmanx_frame.h"
+
+typedef enum
+{
+  S_FRAME_FREE = 0,
+  S_FRAME_WRITING,
+  S_FRAME_READY,    /* written, flip not requested yet*/
+  S_FRAME_QUEUED,   /* flip requested, not on screen yet*/
+  S_FRAME_SHOWN
+}s_frame_state_e;
+
+typedef struct
+{
+  dispmanx_frame_renderer_t *renderer;
+  DISPMANX_RESOURCE_HANDLE_T resource;
+  s_frame_state_e state;
+}s_frame_slot_t;
+
+struct dispmanx_frame_renderer
+{
+  GMutex lock;
+  const dispmanx_backend_t *backend;
+  DISPMANX_ELEMENT_HANDLE_T element;
+  VC_IMAGE_TYPE_T type;
+  uint32_t width;
+  uint32_t height;
+  int32_t layer;
+  VC_RECT_T dst_rect;
+  VC_RECT_T src_rect;
+  guint buffers;
+  s_frame_slot_t slots[DISPMANX_FRAME_MAX_BUFFERS];
+  GSource *flip_source;   /* pending s_frame_flip_cb on the player context*/
+  gboolean released;
+  guint8 *staging;        /* producer thread only*/
+  int32_t staging_pitch;
+  gint64 first_shown;
+  gint64 last_shown;
+  dispmanx_frame_stats_t stats;
+};
+
+static void s_frame_flip(dispmanx_frame_renderer_t *renderer);
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* player context, the update carrying the flip to slot is on screen*/
+static void s_frame_shown_cb(gpointer user_data)
+{
+  s_frame_slot_t *slot = (s_frame_slot_t *)user_data;
+  dispmanx_frame_renderer_t *renderer = slot->renderer;
+  gint64 now = g_get_monotonic_time();
+  guint i;
+
+  g_mutex_lock(&renderer->lock);
+  for(i = 0; i < renderer->buffers; i++)
+  {
+    if(&renderer->slots[i] != slot && renderer->slots[i].state == S_FRAME_SHOWN)
+      renderer->slots[i].state = S_FRAME_FREE;
+  }
+  slot->state = S_FRAME_SHOWN;
+  renderer->stats.frames_shown++;
+  if(renderer->first_shown == 0)
+    renderer->first_shown = now;
+  renderer->last_shown = now;
+  g_mutex_unlock(&renderer->lock);
+
+  /* a frame written meanwhile goes out next*/
+  s_frame_flip(renderer);
+  return;
+}
+
+/* player context. One flip is outstanding at a time, so every flip requested reaches the screen
+ * on its own and a frame is only ever replaced before its flip was requested*/
+static void s_frame_flip(dispmanx_frame_renderer_t *renderer)
+{
+  s_frame_slot_t *slot = NULL;
+  guint i;
+
+  g_mutex_lock(&renderer->lock);
+  for(i = 0; i < renderer->buffers && renderer->released == FALSE; i++)
+  {
+    if(renderer->slots[i].state == S_FRAME_QUEUED)
+    {
+      slot = NULL;
+      break;
+    }
+    if(renderer->slots[i].state == S_FRAME_READY)
+      slot = &renderer->slots[i];
+  }
+  if(slot)
+    slot->state = S_FRAME_QUEUED;
+  g_mutex_unlock(&renderer->lock);
+
+  if(slot == NULL)
+    return;
+
+  /* flip and its notification in the same update*/
+  dispmanx_update_begin();
+  dispmanx_update_change_source(renderer->element, slot->resource);
+  dispmanx_update_notify(s_frame_shown_cb, slot);
+  dispmanx_update_end();
+  return;
+}
+
+static gboolean s_frame_flip_cb(gpointer user_data)
+{
+  dispmanx_frame_renderer_t *renderer = (dispmanx_frame_renderer_t *)user_data;
+
+  g_mutex_lock(&renderer->lock);
+  if(renderer->flip_source)
+  {
+    g_source_unref(renderer->flip_source);
+    renderer->flip_source = NULL;
+  }
+  g_mutex_unlock(&renderer->lock);
+
+  s_frame_flip(renderer);
+  return G_SOURCE_REMOVE;
+}
+
+/* player context, the element is gone from the screen*/
+static void s_frame_release_cb(gpointer user_data)
+{
+  dispmanx_frame_renderer_t *renderer = (dispmanx_frame_renderer_t *)user_data;
+  dispmanx_frame_stats_t stats;
+  guint i;
+
+  dispmanx_frame_renderer_get_stats(renderer, &stats);
+  I_LOG_INFO("Frame renderer  : %" G_GUINT64_FORMAT " pushed, %" G_GUINT64_FORMAT " shown (%.1f fps), %" G_GUINT64_FORMAT " dropped, %" G_GUINT64_FORMAT " replaced, copy %.1f MB/s max %" G_GUINT64_FORMAT "us\n",
+      stats.frames_pushed, stats.frames_shown, stats.fps, stats.frames_dropped, stats.frames_replaced, stats.copy_mb_per_s, stats.copy_max_us);
+
+  for(i = 0; i < renderer->buffers; i++)
+  {
+    if(renderer->slots[i].resource)
+      renderer->backend->resource_delete(renderer->slots[i].resource);
+  }
+  g_free(renderer->staging);
+  g_mutex_clear(&renderer->lock);
+  g_free(renderer);
+  return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+dispmanx_frame_renderer_t *dispmanx_frame_renderer_new(int32_t layer, const VC_RECT_T *dst_rect, VC_IMAGE_TYPE_T type,
+    uint32_t width, uint32_t height, guint buffers)
+{
+  const dispmanx_backend_t *backend = dispmanx_get_backend();
+  dispmanx_frame_renderer_t *renderer = NULL;
+  guint i;
+
+  if(backend == NULL || dst_rect == NULL || width == 0 || height == 0)
+  {
+    I_LOG_ERROR("xxxxxxxxxx Invalid Argument xxxxxxxxxx\n");
+    return NULL;
+  }
+
+  renderer = g_new0(dispmanx_frame_renderer_t, 1);
+  g_mutex_init(&renderer->lock);
+  renderer->backend = backend;
+  renderer->type = type;
+  renderer->width = width;
+  renderer->height = height;
+  renderer->layer = layer;
+  renderer->dst_rect = *dst_rect;
+  renderer->buffers = CLAMP(buffers, DISPMANX_FRAME_MIN_BUFFERS, DISPMANX_FRAME_MAX_BUFFERS);
+  vc_dispmanx_rect_set(&renderer->src_rect, 0, 0, width << 16, height << 16);
+
+  for(i = 0; i < renderer->buffers; i++)
+  {
+    renderer->slots[i].renderer = renderer;
+    renderer->slots[i].resource = backend->resource_create(type, width, height);
+    if(renderer->slots[i].resource == 0)
+    {
+      I_LOG_ERROR("xxxxxxxxxx Couldnt Create Frame Resource %ux%u xxxxxxxxxx\n", width, height);
+      goto error;
+    }
+  }
+
+  /* the first resource is on screen from the start, blank*/
+  renderer->element = dispmanx_win_add_resource_element(layer, &renderer->dst_rect, renderer->slots[0].resource, &renderer->src_rect, 255);
+  if(renderer->element == 0)
+  {
+    I_LOG_ERROR("xxxxxxxxxx Couldnt Add Frame Element xxxxxxxxxx\n");
+    goto error;
+  }
+  renderer->slots[0].state = S_FRAME_SHOWN;
+
+  I_LOG_DEBUG("Frame renderer %ux%u with %u buffers on layer %d\n", width, height, renderer->buffers, layer);
+  return renderer;
+
+error:
+  for(i = 0; i < renderer->buffers; i++)
+  {
+    if(renderer->slots[i].resource)
+      backend->resource_delete(renderer->slots[i].resource);
+  }
+  g_mutex_clear(&renderer->lock);
+  g_free(renderer);
+  return NULL;
+}
+
+/* Producer thread. Copies a full frame of the renderer's size and type, FALSE when it was dropped.
+ * The flip is requested from the player context*/
+gboolean dispmanx_frame_renderer_push(dispmanx_frame_renderer_t *renderer, const void *pixels, int32_t pitch)
+{
+  s_frame_slot_t *slot = NULL;
+  const guint8 *source = (const guint8 *)pixels;
+  int32_t source_pitch = pitch;
+  VC_RECT_T rect;
+  gint64 start, copy_us;
+  guint64 bytes;
+  guint i;
+  int result;
+
+  if(renderer == NULL || pixels == NULL || pitch <= 0)
+    return FALSE;
+
+  g_mutex_lock(&renderer->lock);
+  renderer->stats.frames_pushed++;
+  for(i = 0; i < renderer->buffers && slot == NULL; i++)
+  {
+    if(renderer->slots[i].state == S_FRAME_FREE)
+      slot = &renderer->slots[i];
+  }
+  /* a written frame whose flip was not requested yet is overwritten by this one*/
+  for(i = 0; i < renderer->buffers && slot == NULL; i++)
+  {
+    if(renderer->slots[i].state == S_FRAME_READY)
+    {
+      slot = &renderer->slots[i];
+      renderer->stats.frames_replaced++;
+    }
+  }
+  if(slot == NULL || renderer->released)
+  {
+    renderer->stats.frames_dropped++;
+    g_mutex_unlock(&renderer->lock);
+    return FALSE;
+  }
+  slot->state = S_FRAME_WRITING;
+  g_mutex_unlock(&renderer->lock);
+
+  start = g_get_monotonic_time();
+  bytes = (guint64)pitch * renderer->height;
+  if(pitch % DISPMANX_FRAME_PITCH_ALIGN)
+  {
+    int32_t staging_pitch = (pitch + DISPMANX_FRAME_PITCH_ALIGN - 1) & ~(DISPMANX_FRAME_PITCH_ALIGN - 1);
+    uint32_t row;
+
+    if(renderer->staging_pitch != staging_pitch)
+    {
+      g_free(renderer->staging);
+      renderer->staging_pitch = staging_pitch;
+      renderer->staging = g_malloc0((gsize)staging_pitch * renderer->height);
+    }
+    for(row = 0; row < renderer->height; row++)
+      memcpy(renderer->staging + (gsize)row * (gsize)staging_pitch, source + (gsize)row * (gsize)pitch, (gsize)pitch);
+    source = renderer->staging;
+    source_pitch = staging_pitch;
+    bytes *= 2; /* read once into staging, once more by the upload*/
+  }
+  vc_dispmanx_rect_set(&rect, 0, 0, renderer->width, renderer->height);
+  result = renderer->backend->resource_write_data(slot->resource, renderer->type, source_pitch, (void *)source, &rect);
+  copy_us = g_get_monotonic_time() - start;
+
+  g_mutex_lock(&renderer->lock);
+  if(result != 0)
+  {
+    slot->state = S_FRAME_FREE;
+    renderer->stats.frames_dropped++;
+    g_mutex_unlock(&renderer->lock);
+    return FALSE;
+  }
+  renderer->stats.bytes_copied += bytes;
+  renderer->stats.copy_time_us += (guint64)copy_us;
+  if(renderer->stats.copy_max_us < (guint64)copy_us)
+    renderer->stats.copy_max_us = (guint64)copy_us;
+  if(source != pixels)
+    renderer->stats.frames_staged++;
+
+  /* an older frame still waiting for its flip is not worth showing any more*/
+  for(i = 0; i < renderer->buffers; i++)
+  {
+    if(&renderer->slots[i] != slot && renderer->slots[i].state == S_FRAME_READY)
+    {
+      renderer->slots[i].state = S_FRAME_FREE;
+      renderer->stats.frames_replaced++;
+    }
+  }
+  slot->state = S_FRAME_READY;
+
+  if(renderer->flip_source == NULL && renderer->released == FALSE)
+  {
+    renderer->flip_source = g_idle_source_new();
+    g_source_set_priority(renderer->flip_source, G_PRIORITY_HIGH);
+    g_source_set_callback(renderer->flip_source, s_frame_flip_cb, renderer, NULL);
+    g_source_attach(renderer->flip_source, g_main_context_default());
+  }
+  g_mutex_unlock(&renderer->lock);
+  return TRUE;
+}
+
+/* Player context, src_rect in 16.16 frame pixels, see dispmanx_layout_compute*/
+void dispmanx_frame_renderer_set_rects(dispmanx_frame_renderer_t *renderer, const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect)
+{
+  int result;
+
+  if(renderer == NULL || dst_rect == NULL || src_rect == NULL)
+    return;
+
+  renderer->dst_rect = *dst_rect;
+  renderer->src_rect = *src_rect;
+  result = dispmanx_update_change_element(renderer->element, ELEMENT_CHANGE_DEST_RECT | ELEMENT_CHANGE_SRC_RECT,
+      renderer->layer, 255, &renderer->dst_rect, &renderer->src_rect);
+  if(result != 0)
+  {
+    I_LOG_WARNING("!!!!!!!!!! Frame element rects not changed !!!!!!!!!!\n");
+  }
+  return;
+}
+
+void dispmanx_frame_renderer_get_stats(dispmanx_frame_renderer_t *renderer, dispmanx_frame_stats_t *stats)
+{
+  if(renderer == NULL || stats == NULL)
+    return;
+
+  g_mutex_lock(&renderer->lock);
+  *stats = renderer->stats;
+  stats->elapsed_us = renderer->last_shown - renderer->first_shown;
+  g_mutex_unlock(&renderer->lock);
+
+  stats->fps = (stats->elapsed_us > 0) ? ((gdouble)(stats->frames_shown - 1) * G_USEC_PER_SEC / (gdouble)stats->elapsed_us) : 0.0;
+  stats->copy_mb_per_s = (stats->copy_time_us > 0) ? ((gdouble)stats->bytes_copied / (gdouble)stats->copy_time_us) : 0.0;
+  return;
+}
+
+/* Player context, the producer must have stopped. Resources go once the element is off screen*/
+void dispmanx_frame_renderer_free(dispmanx_frame_renderer_t *renderer)
+{
+  if(renderer == NULL)
+    return;
+
+  g_mutex_lock(&renderer->lock);
+  renderer->released = TRUE;
+  if(renderer->flip_source)
+  {
+    g_source_destroy(renderer->flip_source);
+    g_source_unref(renderer->flip_source);
+    renderer->flip_source = NULL;
+  }
+  g_mutex_unlock(&renderer->lock);
+
+  dispmanx_update_begin();
+  dispmanx_update_remove_element(renderer->element, 0);
+  dispmanx_update_notify(s_frame_release_cb, renderer);
+  dispmanx_update_end();
+  return;
+}
@@ -0,0 +1,218 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "player.h"
+#include "dispmanx_layout.h"
+
+typedef enum
+{
+  S_FIT_BOTH,
+  S_FIT_WIDTH,
+  S_FIT_HEIGHT,
+  S_FILL
+}s_layout_fit_e;
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* a * b / c without overflow for the sizes used here, c > 0*/
+static int64_t s_muldiv(int64_t a, int64_t b, int64_t c)
+{
+  return (a * b + c / 2) / c;
+}
+
+/* Scales the region (16.16) into the area, crops the region where the result overflows the area*/
+static void s_layout_fit(const VC_RECT_T *region, uint32_t par_n, uint32_t par_d, const VC_RECT_T *area,
+    s_layout_fit_e fit, int32_t zoom, VC_RECT_T *src_rect, VC_RECT_T *dst_rect)
+{
+  /* display shape of the region, in arbitrary units*/
+  int64_t shape_w = (int64_t)region->width * par_n;
+  int64_t shape_h = (int64_t)region->height * par_d;
+  int64_t out_w, out_h, crop;
+  gboolean by_width;
+
+  /* height when the width fills the area*/
+  out_h = s_muldiv(area->width, shape_h, shape_w);
+  switch(fit)
+  {
+    case S_FIT_WIDTH:
+      by_width = TRUE;
+      break;
+    case S_FIT_HEIGHT:
+      by_width = FALSE;
+      break;
+    case S_FILL:
+      by_width = (out_h >= area->height);
+      break;
+    case S_FIT_BOTH:
+    default:
+      by_width = (out_h <= area->height);
+      break;
+  }
+
+  if(by_width)
+  {
+    out_w = area->width;
+  }
+  else
+  {
+    out_h = area->height;
+    out_w = s_muldiv(area->height, shape_w, shape_h);
+  }
+
+  if(zoom > DISPMANX_LAYOUT_ONE)
+  {
+    out_w = s_muldiv(out_w, zoom, DISPMANX_LAYOUT_ONE);
+    out_h = s_muldiv(out_h, zoom, DISPMANX_LAYOUT_ONE);
+  }
+
+  *src_rect = *region;
+
+  /* what does not fit is cropped from the source, centred*/
+  if(out_w > area->width)
+  {
+    crop = region->width - s_muldiv(region->width, area->width, out_w);
+    src_rect->x += (int32_t)(crop / 2);
+    src_rect->width -= (int32_t)crop;
+    out_w = area->width;
+  }
+  if(out_h > area->height)
+  {
+    crop = region->height - s_muldiv(region->height, area->height, out_h);
+    src_rect->y += (int32_t)(crop / 2);
+    src_rect->height -= (int32_t)crop;
+    out_h = area->height;
+  }
+
+  dst_rect->width = (int32_t)MAX(out_w, 1);
+  dst_rect->height = (int32_t)MAX(out_h, 1);
+  dst_rect->x = area->x + (area->width - dst_rect->width) / 2;
+  dst_rect->y = area->y + (area->height - dst_rect->height) / 2;
+  return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+gboolean dispmanx_layout_compute(const dispmanx_layout_source_t *source, const VC_RECT_T *area,
+    const dispmanx_layout_params_t *params, VC_RECT_T *src_rect, VC_RECT_T *dst_rect)
+{
+  uint32_t par_n, par_d;
+  VC_RECT_T frame;
+  VC_RECT_T region;
+
+  /* 16.16 in an int32_t holds at most DISPMANX_LAYOUT_MAX_SIZE pixels*/
+  if(source == NULL || area == NULL || params == NULL || src_rect == NULL || dst_rect == NULL ||
+      source->width == 0 || source->height == 0 || area->width <= 0 || area->height <= 0 ||
+      source->width > DISPMANX_LAYOUT_MAX_SIZE || source->height > DISPMANX_LAYOUT_MAX_SIZE)
+    return FALSE;
+
+  par_n = (source->par_n && source->par_d) ? source->par_n : 1;
+  par_d = (source->par_n && source->par_d) ? source->par_d : 1;
+
+  frame.x = 0;
+  frame.y = 0;
+  frame.width = (int32_t)(source->width * DISPMANX_LAYOUT_ONE);
+  frame.height = (int32_t)(source->height * DISPMANX_LAYOUT_ONE);
+
+  switch(params->mode)
+  {
+    case PLAYER_AR_STRETCH:
+      *src_rect = frame;
+      *dst_rect = *area;
+      break;
+    case PLAYER_AR_LETTERBOX:
+      s_layout_fit(&frame, par_n, par_d, area, S_FIT_WIDTH, DISPMANX_LAYOUT_ONE, src_rect, dst_rect);
+      break;
+    case PLAYER_AR_PILLARBOX:
+      s_layout_fit(&frame, par_n, par_d, area, S_FIT_HEIGHT, DISPMANX_LAYOUT_ONE, src_rect, dst_rect);
+      break;
+    case PLAYER_AR_CROP:
+      s_layout_fit(&frame, par_n, par_d, area, S_FILL, DISPMANX_LAYOUT_ONE, src_rect, dst_rect);
+      break;
+    case PLAYER_AR_ZOOM:
+      s_layout_fit(&frame, par_n, par_d, area, S_FIT_BOTH, params->zoom, src_rect, dst_rect);
+      break;
+    case PLAYER_AR_CUSTOM:
+      /* clamp the region to the frame, an empty region shows the whole frame*/
+      region.x = CLAMP(params->region.x, 0, frame.width - 1);
+      region.y = CLAMP(params->region.y, 0, frame.height - 1);
+      region.width = MIN(params->region.width, frame.width - region.x);
+      region.height = MIN(params->region.height, frame.height - region.y);
+      if(region.width <= 0 || region.height <= 0)
+        region = frame;
+      s_layout_fit(&region, par_n, par_d, area, S_FIT_BOTH, DISPMANX_LAYOUT_ONE, src_rect, dst_rect);
+      break;
+    case PLAYER_AR_ORIGINAL:
+    default:
+      s_layout_fit(&frame, par_n, par_d, area, S_FIT_BOTH, DISPMANX_LAYOUT_ONE, src_rect, dst_rect);
+      break;
+  }
+  return TRUE;
+}
+
+/* Order of the aspect ratio toggle, custom is only reached through dispmanx_win_set_custom_region*/
+dispmanx_player_aspect_ratio_e dispmanx_layout_next_mode(dispmanx_player_aspect_ratio_e mode)
+{
+  switch(mode)
+  {
+    case PLAYER_AR_ORIGINAL:
+      return PLAYER_AR_STRETCH;
+    case PLAYER_AR_STRETCH:
+      return PLAYER_AR_LETTERBOX;
+    case PLAYER_AR_LETTERBOX:
+      return PLAYER_AR_PILLARBOX;
+    case PLAYER_AR_PILLARBOX:
+      return PLAYER_AR_CROP;
+    case PLAYER_AR_CROP:
+      return PLAYER_AR_ZOOM;
+    case PLAYER_AR_ZOOM:
+    case PLAYER_AR_CUSTOM:
+    default:
+      return PLAYER_AR_ORIGINAL;
+  }
+}
+
+const char *dispmanx_layout_mode_name(dispmanx_player_aspect_ratio_e mode)
+{
+  switch(mode)
+  {
+    case PLAYER_AR_ORIGINAL:
+      return "original";
+    case PLAYER_AR_STRETCH:
+      return "stretch";
+    case PLAYER_AR_LETTERBOX:
+      return "letterbox";
+    case PLAYER_AR_PILLARBOX:
+      return "pillarbox";
+    case PLAYER_AR_CROP:
+      return "crop";
+    case PLAYER_AR_ZOOM:
+      return "zoom";
+    case PLAYER_AR_CUSTOM:
+      return "custom";
+    default:
+      return "unknown";
+  }
+}
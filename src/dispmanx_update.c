@@ -0,0 +1,754 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "player.h"
+#include "dispmanx_update.h"
+
+typedef struct
+{
+  DISPMANX_ELEMENT_HANDLE_T element;
+  gboolean remove;
+  DISPMANX_RESOURCE_HANDLE_T resource; /* deleted after the removal is submitted*/
+  uint32_t change_flags;
+  gboolean change_source;
+  DISPMANX_RESOURCE_HANDLE_T source;   /* shown by the element once submitted*/
+  int32_t layer;
+  uint8_t opacity;
+  VC_RECT_T dst_rect;
+  VC_RECT_T src_rect;
+}dispmanx_pending_change_t;
+
+typedef struct
+{
+  dispmanx_update_done_cb cb;
+  gpointer user_data;
+}dispmanx_update_notify_t;
+
+/* One submitted update, kept until the backend reports it on screen*/
+typedef struct
+{
+  GArray *changes; /* dispmanx_pending_change_t*/
+  GArray *notify;  /* dispmanx_update_notify_t*/
+  gint64 submit_time;
+  gint64 done_time;
+  gboolean async;  /* holds an in flight slot until finalized*/
+}dispmanx_update_job_t;
+
+typedef struct
+{
+  GMutex lock;        /* protects everything below except flush_lock*/
+  GMutex flush_lock;  /* serializes submits so they reach the backend in order*/
+  GCond done_cond;
+  const dispmanx_backend_t *backend;
+  GMainContext *context;
+  GSource *flush_source;
+  GSource *complete_source;
+  GArray *pending;    /* dispmanx_pending_change_t*/
+  GArray *notify;     /* dispmanx_update_notify_t for the next submit*/
+  GQueue completed;   /* dispmanx_update_job_t done by the backend, not yet finalized*/
+  gboolean async;
+  guint max_in_flight;
+  guint in_flight;
+  guint depth;
+  gint64 frame_us;
+  gint64 last_submit;
+  dispmanx_update_stats_t stats;
+}dispmanx_update_t;
+
+static dispmanx_update_t s_update;
+
+static void s_update_flush(void);
+static void s_update_process_completed(void);
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* Caller holds s_update.lock*/
+static dispmanx_pending_change_t *s_update_find(DISPMANX_ELEMENT_HANDLE_T element)
+{
+  guint i;
+
+  for(i = 0; i < s_update.pending->len; i++)
+  {
+    dispmanx_pending_change_t *change = &g_array_index(s_update.pending, dispmanx_pending_change_t, i);
+    if(change->element == element)
+      return change;
+  }
+  return NULL;
+}
+
+static dispmanx_pending_change_t *s_update_get_change(DISPMANX_ELEMENT_HANDLE_T element)
+{
+  dispmanx_pending_change_t *change = s_update_find(element);
+
+  if(change)
+  {
+    s_update.stats.changes_coalesced++;
+  }
+  else
+  {
+    dispmanx_pending_change_t new_change;
+
+    I_ZEROMEM(&new_change, sizeof(new_change));
+    new_change.element = element;
+    g_array_append_val(s_update.pending, new_change);
+    change = &g_array_index(s_update.pending, dispmanx_pending_change_t, s_update.pending->len - 1);
+  }
+  return change;
+}
+
+static gboolean s_update_flush_cb(gpointer user_data)
+{
+  g_mutex_lock(&s_update.lock);
+  if(s_update.flush_source)
+  {
+    g_source_unref(s_update.flush_source);
+    s_update.flush_source = NULL;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  s_update_flush();
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean s_update_complete_cb(gpointer user_data)
+{
+  g_mutex_lock(&s_update.lock);
+  if(s_update.complete_source)
+  {
+    g_source_unref(s_update.complete_source);
+    s_update.complete_source = NULL;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  s_update_process_completed();
+  return G_SOURCE_REMOVE;
+}
+
+/* Decide when the pending changes go out, caller holds s_update.lock.
+ * Returns TRUE if the caller has to flush right away*/
+static gboolean s_update_schedule(void)
+{
+  gint64 now, ready;
+  guint delay_ms;
+
+  if(s_update.depth > 0 || (s_update.pending->len == 0 && s_update.notify->len == 0))
+    return FALSE;
+
+  if(s_update.context == NULL)
+    return TRUE;
+
+  if(s_update.flush_source)
+    return FALSE; /* already due this frame, the change rides along*/
+
+  if(s_update.async && s_update.in_flight >= s_update.max_in_flight)
+    return FALSE; /* rescheduled when an update completes*/
+
+  /* First change after an idle frame goes out now, the rest wait for the next frame*/
+  now = g_get_monotonic_time();
+  ready = s_update.last_submit + s_update.frame_us;
+  delay_ms = (ready > now) ? (guint)((ready - now + 999) / 1000) : 0;
+
+  s_update.flush_source = (delay_ms > 0) ? g_timeout_source_new(delay_ms) : g_idle_source_new();
+  g_source_set_priority(s_update.flush_source, G_PRIORITY_HIGH);
+  g_source_set_callback(s_update.flush_source, s_update_flush_cb, NULL, NULL);
+  g_source_attach(s_update.flush_source, s_update.context);
+  return FALSE;
+}
+
+/* Queue a job on screen for the player context, caller holds s_update.lock*/
+static void s_update_queue_completed(dispmanx_update_job_t *job)
+{
+  g_queue_push_tail(&s_update.completed, job);
+  g_cond_broadcast(&s_update.done_cond);
+
+  if(s_update.context && s_update.complete_source == NULL)
+  {
+    s_update.complete_source = g_idle_source_new();
+    g_source_set_priority(s_update.complete_source, G_PRIORITY_HIGH);
+    g_source_set_callback(s_update.complete_source, s_update_complete_cb, NULL, NULL);
+    g_source_attach(s_update.complete_source, s_update.context);
+  }
+  return;
+}
+
+/* Called by the backend from its own thread, hand the job back to the player context*/
+static void s_update_submit_done(DISPMANX_UPDATE_HANDLE_T update, void *arg)
+{
+  dispmanx_update_job_t *job = (dispmanx_update_job_t *)arg;
+
+  g_mutex_lock(&s_update.lock);
+  job->done_time = g_get_monotonic_time();
+  s_update_queue_completed(job);
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+static void s_update_job_finish(dispmanx_update_job_t *job)
+{
+  const dispmanx_backend_t *backend;
+  gint64 latency = job->done_time - job->submit_time;
+  guint i;
+
+  g_mutex_lock(&s_update.lock);
+  backend = s_update.backend;
+  s_update.stats.submit_time_us += (guint64)latency;
+  if(s_update.stats.submit_max_us < (guint64)latency)
+    s_update.stats.submit_max_us = (guint64)latency;
+  if(s_update.stats.submit_min_us == 0 || s_update.stats.submit_min_us > (guint64)latency)
+    s_update.stats.submit_min_us = (guint64)latency;
+  g_mutex_unlock(&s_update.lock);
+
+  /* Resources can go only after the elements using them are off screen*/
+  for(i = 0; backend && i < job->changes->len; i++)
+  {
+    dispmanx_pending_change_t *change = &g_array_index(job->changes, dispmanx_pending_change_t, i);
+    if(change->remove && change->resource != 0)
+      backend->resource_delete(change->resource);
+  }
+
+  for(i = 0; i < job->notify->len; i++)
+  {
+    dispmanx_update_notify_t *notify = &g_array_index(job->notify, dispmanx_update_notify_t, i);
+    notify->cb(notify->user_data);
+  }
+
+  g_array_free(job->changes, TRUE);
+  g_array_free(job->notify, TRUE);
+  g_free(job);
+  return;
+}
+
+static void s_update_process_completed(void)
+{
+  dispmanx_update_job_t *job;
+  gboolean flush_now = FALSE;
+
+  for(;;)
+  {
+    g_mutex_lock(&s_update.lock);
+    job = g_queue_pop_head(&s_update.completed);
+    if(job && job->async && s_update.in_flight > 0)
+      s_update.in_flight--;
+    g_mutex_unlock(&s_update.lock);
+
+    if(job == NULL)
+      break;
+    s_update_job_finish(job);
+  }
+
+  /* a slot is free again, send whatever piled up meanwhile*/
+  g_mutex_lock(&s_update.lock);
+  if(s_update.pending)
+    flush_now = s_update_schedule();
+  g_mutex_unlock(&s_update.lock);
+
+  if(flush_now)
+    s_update_flush();
+  return;
+}
+
+/* Submit the pending changes, plus n_adds new elements in the same update.
+ * Adds can not wait for a free slot since the caller needs the handles now,
+ * when all slots are taken they go out synchronously behind the queued ones*/
+static void s_update_submit(DISPMANX_DISPLAY_HANDLE_T display, dispmanx_update_element_t *adds, guint n_adds)
+{
+  const dispmanx_backend_t *backend;
+  DISPMANX_UPDATE_HANDLE_T update;
+  dispmanx_update_job_t *job;
+  gboolean async;
+  guint i;
+  int result = 0;
+
+  g_mutex_lock(&s_update.flush_lock);
+
+  g_mutex_lock(&s_update.lock);
+  backend = s_update.backend;
+  if(backend == NULL || s_update.pending == NULL || (s_update.pending->len == 0 && s_update.notify->len == 0 && n_adds == 0))
+  {
+    g_mutex_unlock(&s_update.lock);
+    g_mutex_unlock(&s_update.flush_lock);
+    return;
+  }
+
+  /* Completions are delivered on the context, without one submit synchronously*/
+  async = (s_update.async && s_update.context != NULL);
+  if(async && s_update.in_flight >= s_update.max_in_flight)
+  {
+    if(n_adds == 0)
+    {
+      s_update.stats.submits_deferred++;
+      g_mutex_unlock(&s_update.lock);
+      g_mutex_unlock(&s_update.flush_lock);
+      return;
+    }
+    async = FALSE;
+  }
+
+  job = g_new0(dispmanx_update_job_t, 1);
+  job->changes = s_update.pending;
+  job->notify = s_update.notify;
+  job->async = async;
+  s_update.pending = g_array_new(FALSE, FALSE, sizeof(dispmanx_pending_change_t));
+  s_update.notify = g_array_new(FALSE, FALSE, sizeof(dispmanx_update_notify_t));
+  s_update.stats.changes_requested += n_adds;
+  if(async)
+  {
+    s_update.in_flight++;
+    if(s_update.stats.in_flight_peak < s_update.in_flight)
+      s_update.stats.in_flight_peak = s_update.in_flight;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  update = backend->update_start(0);
+  I_ASSERT(update != 0);
+
+  for(i = 0; i < job->changes->len; i++)
+  {
+    dispmanx_pending_change_t *change = &g_array_index(job->changes, dispmanx_pending_change_t, i);
+
+    if(change->remove)
+      result = backend->element_remove(update, change->element);
+    else
+    {
+      result = 0;
+      if(change->change_source)
+        result = backend->element_change_source(update, change->element, change->source);
+      if(change->change_flags && result == 0)
+        result = backend->element_change_attributes(update, change->element, change->change_flags,
+            change->layer, change->opacity, &change->dst_rect, &change->src_rect);
+    }
+    if(result != 0)
+    {
+      I_LOG_WARNING("!!!!!!!!!! Element %u update failed !!!!!!!!!!\n", change->element);
+    }
+  }
+
+  /* after the queued changes, a new element never sees an older change to its layer*/
+  for(i = 0; i < n_adds; i++)
+  {
+    adds[i].element = backend->element_add(update, display, adds[i].layer, &adds[i].dst_rect, adds[i].resource,
+        &adds[i].src_rect, &adds[i].alpha, adds[i].transform);
+    if(adds[i].element == 0)
+    {
+      I_LOG_WARNING("!!!!!!!!!! Element add on layer %d failed !!!!!!!!!!\n", adds[i].layer);
+    }
+  }
+
+  job->submit_time = g_get_monotonic_time();
+
+  g_mutex_lock(&s_update.lock);
+  s_update.last_submit = job->submit_time;
+  s_update.stats.updates_submitted++;
+  if(async)
+    s_update.stats.updates_async++;
+  g_mutex_unlock(&s_update.lock);
+
+  if(async)
+  {
+    result = backend->update_submit(update, s_update_submit_done, job);
+    I_ASSERT(result == 0);
+    g_mutex_unlock(&s_update.flush_lock);
+  }
+  else
+  {
+    result = backend->update_submit_sync(update);
+    I_ASSERT(result == 0);
+    job->done_time = g_get_monotonic_time();
+    g_mutex_unlock(&s_update.flush_lock);
+
+    /* callers may be on any thread, notifications still run on the player context.
+     * Queued behind the async jobs so they are finalized in submit order*/
+    g_mutex_lock(&s_update.lock);
+    if(s_update.context)
+    {
+      s_update_queue_completed(job);
+      job = NULL;
+    }
+    g_mutex_unlock(&s_update.lock);
+    if(job)
+      s_update_job_finish(job);
+  }
+  return;
+}
+
+static void s_update_flush(void)
+{
+  s_update_submit(0, NULL, 0);
+  return;
+}
+
+/* Async jobs the backend is done with, caller holds s_update.lock*/
+static guint s_update_completed_async(void)
+{
+  GList *link;
+  guint count = 0;
+
+  for(link = s_update.completed.head; link; link = link->next)
+  {
+    if(((dispmanx_update_job_t *)link->data)->async)
+      count++;
+  }
+  return count;
+}
+
+/* Wait for every async update to reach the screen and finalize it on the calling thread*/
+static void s_update_drain(void)
+{
+  g_mutex_lock(&s_update.lock);
+  while(s_update.in_flight > s_update_completed_async())
+    g_cond_wait(&s_update.done_cond, &s_update.lock);
+  g_mutex_unlock(&s_update.lock);
+
+  s_update_process_completed();
+  return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void dispmanx_update_init(const dispmanx_backend_t *backend)
+{
+  const gchar *env = g_getenv("I_PLAYER_DISPLAY_HZ");
+  guint64 hz = env ? g_ascii_strtoull(env, NULL, 10) : 0;
+
+  g_mutex_lock(&s_update.lock);
+  s_update.backend = backend;
+  if(s_update.pending == NULL)
+  {
+    s_update.pending = g_array_new(FALSE, FALSE, sizeof(dispmanx_pending_change_t));
+    s_update.notify = g_array_new(FALSE, FALSE, sizeof(dispmanx_update_notify_t));
+  }
+  if(s_update.frame_us <= 0)
+    s_update.frame_us = (hz > 0) ? (gint64)(G_USEC_PER_SEC / hz) : DISPMANX_UPDATE_DEFAULT_FRAME_US;
+  if(s_update.max_in_flight == 0)
+    s_update.max_in_flight = DISPMANX_UPDATE_DEFAULT_MAX_IN_FLIGHT;
+  I_ZEROMEM(&s_update.stats, sizeof(dispmanx_update_stats_t));
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+void dispmanx_update_shutdown(void)
+{
+  dispmanx_update_set_context(NULL);
+
+  g_mutex_lock(&s_update.lock);
+  I_LOG_INFO("Display updates : %" G_GUINT64_FORMAT " requested, %" G_GUINT64_FORMAT " coalesced, %" G_GUINT64_FORMAT " submitted (%" G_GUINT64_FORMAT " async)\n",
+      s_update.stats.changes_requested, s_update.stats.changes_coalesced, s_update.stats.updates_submitted, s_update.stats.updates_async);
+  if(s_update.stats.updates_submitted)
+  {
+    I_LOG_INFO("Display submit  : min %" G_GUINT64_FORMAT "us avg %" G_GUINT64_FORMAT "us max %" G_GUINT64_FORMAT "us, %" G_GUINT64_FORMAT " deferred, peak %u in flight\n",
+        s_update.stats.submit_min_us, s_update.stats.submit_time_us / s_update.stats.updates_submitted, s_update.stats.submit_max_us,
+        s_update.stats.submits_deferred, s_update.stats.in_flight_peak);
+  }
+  if(s_update.pending)
+  {
+    g_array_free(s_update.pending, TRUE);
+    g_array_free(s_update.notify, TRUE);
+    s_update.pending = NULL;
+    s_update.notify = NULL;
+  }
+  s_update.backend = NULL;
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+/* Context on which deferred flushes and completions run, NULL submits every change synchronously*/
+void dispmanx_update_set_context(GMainContext *context)
+{
+  g_mutex_lock(&s_update.lock);
+  if(s_update.flush_source)
+  {
+    g_source_destroy(s_update.flush_source);
+    g_source_unref(s_update.flush_source);
+    s_update.flush_source = NULL;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  /* nothing may complete on the old context once it is gone*/
+  s_update_drain();
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.complete_source)
+  {
+    g_source_destroy(s_update.complete_source);
+    g_source_unref(s_update.complete_source);
+    s_update.complete_source = NULL;
+  }
+  if(s_update.context)
+    g_main_context_unref(s_update.context);
+  s_update.context = context ? g_main_context_ref(context) : NULL;
+  g_mutex_unlock(&s_update.lock);
+
+  /* Whatever was waiting for the old context goes out now*/
+  dispmanx_update_flush();
+  return;
+}
+
+/* Submit without blocking, keeping at most max_in_flight updates queued in the backend*/
+void dispmanx_update_set_async(gboolean async, guint max_in_flight)
+{
+  g_mutex_lock(&s_update.lock);
+  s_update.async = async;
+  s_update.max_in_flight = (max_in_flight > 0) ? max_in_flight : DISPMANX_UPDATE_DEFAULT_MAX_IN_FLIGHT;
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+void dispmanx_update_set_frame_interval(gint64 frame_us)
+{
+  g_mutex_lock(&s_update.lock);
+  s_update.frame_us = (frame_us > 0) ? frame_us : DISPMANX_UPDATE_DEFAULT_FRAME_US;
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+/* Everything queued until the matching dispmanx_update_end goes out in one update*/
+void dispmanx_update_begin(void)
+{
+  g_mutex_lock(&s_update.lock);
+  s_update.depth++;
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
+
+void dispmanx_update_end(void)
+{
+  gboolean flush_now = FALSE;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.depth > 0)
+    s_update.depth--;
+  if(s_update.pending)
+    flush_now = s_update_schedule();
+  g_mutex_unlock(&s_update.lock);
+
+  if(flush_now)
+    s_update_flush();
+  return;
+}
+
+int dispmanx_update_change_element(DISPMANX_ELEMENT_HANDLE_T element, uint32_t change_flags, int32_t layer, uint8_t opacity,
+    const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect)
+{
+  dispmanx_pending_change_t *change;
+  gboolean flush_now = FALSE;
+  int result = -1;
+
+  if(element == 0)
+    return result;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.pending == NULL)
+    goto safe_exit;
+
+  s_update.stats.changes_requested++;
+  change = s_update_get_change(element);
+  if(change->remove)
+  {
+    result = 0; /* element is going away, nothing to change*/
+    goto safe_exit;
+  }
+
+  /* Latest value wins for every attribute touched*/
+  change->change_flags |= change_flags;
+  if(change_flags & ELEMENT_CHANGE_LAYER)
+    change->layer = layer;
+  if(change_flags & ELEMENT_CHANGE_OPACITY)
+    change->opacity = opacity;
+  if((change_flags & ELEMENT_CHANGE_DEST_RECT) && dst_rect)
+    change->dst_rect = *dst_rect;
+  if((change_flags & ELEMENT_CHANGE_SRC_RECT) && src_rect)
+    change->src_rect = *src_rect;
+
+  /* dispmanx takes layer and opacity with every change, keep the last known ones*/
+  if(!(change->change_flags & ELEMENT_CHANGE_LAYER))
+    change->layer = layer;
+  if(!(change->change_flags & ELEMENT_CHANGE_OPACITY))
+    change->opacity = opacity;
+  if(!(change->change_flags & ELEMENT_CHANGE_DEST_RECT) && dst_rect)
+    change->dst_rect = *dst_rect;
+  if(!(change->change_flags & ELEMENT_CHANGE_SRC_RECT) && src_rect)
+    change->src_rect = *src_rect;
+
+  flush_now = s_update_schedule();
+  result = 0;
+
+safe_exit:
+  g_mutex_unlock(&s_update.lock);
+  if(flush_now)
+    s_update_flush();
+  return result;
+}
+
+/* Latest source wins within a frame, use dispmanx_update_notify to learn when it is on screen*/
+int dispmanx_update_change_source(DISPMANX_ELEMENT_HANDLE_T element, DISPMANX_RESOURCE_HANDLE_T resource)
+{
+  dispmanx_pending_change_t *change;
+  gboolean flush_now = FALSE;
+  int result = -1;
+
+  if(element == 0)
+    return result;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.pending == NULL)
+    goto safe_exit;
+
+  s_update.stats.changes_requested++;
+  change = s_update_get_change(element);
+  if(change->remove == FALSE)
+  {
+    change->change_source = TRUE;
+    change->source = resource;
+  }
+
+  flush_now = s_update_schedule();
+  result = 0;
+
+safe_exit:
+  g_mutex_unlock(&s_update.lock);
+  if(flush_now)
+    s_update_flush();
+  return result;
+}
+
+int dispmanx_update_remove_element(DISPMANX_ELEMENT_HANDLE_T element, DISPMANX_RESOURCE_HANDLE_T resource)
+{
+  dispmanx_pending_change_t *change;
+  gboolean flush_now = FALSE;
+  int result = -1;
+
+  if(element == 0)
+    return result;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.pending == NULL)
+    goto safe_exit;
+
+  /* pending attribute changes are pointless for an element being removed*/
+  s_update.stats.changes_requested++;
+  change = s_update_get_change(element);
+  change->remove = TRUE;
+  change->change_flags = 0;
+  change->change_source = FALSE;
+  if(resource != 0)
+    change->resource = resource;
+
+  flush_now = s_update_schedule();
+  result = 0;
+
+safe_exit:
+  g_mutex_unlock(&s_update.lock);
+  if(flush_now)
+    s_update_flush();
+  return result;
+}
+
+/* cb runs once everything queued so far is on screen, always on the update context when there is one,
+ * whether updates are submitted async or synchronously*/
+void dispmanx_update_notify(dispmanx_update_done_cb cb, gpointer user_data)
+{
+  dispmanx_update_notify_t notify;
+  gboolean flush_now = FALSE;
+
+  if(cb == NULL)
+    return;
+
+  notify.cb = cb;
+  notify.user_data = user_data;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.notify == NULL)
+  {
+    g_mutex_unlock(&s_update.lock);
+    cb(user_data);
+    return;
+  }
+  g_array_append_val(s_update.notify, notify);
+  flush_now = s_update_schedule();
+  g_mutex_unlock(&s_update.lock);
+
+  if(flush_now)
+    s_update_flush();
+  return;
+}
+
+/* Adds the elements in an update of their own, behind everything queued so far.
+ * Element handles are filled in on return, 0 for an element the backend refused*/
+int dispmanx_update_add_elements(DISPMANX_DISPLAY_HANDLE_T display, dispmanx_update_element_t *elements, guint count)
+{
+  guint i;
+
+  if(elements == NULL || count == 0)
+    return -1;
+
+  for(i = 0; i < count; i++)
+    elements[i].element = 0;
+
+  g_mutex_lock(&s_update.lock);
+  if(s_update.flush_source)
+  {
+    g_source_destroy(s_update.flush_source);
+    g_source_unref(s_update.flush_source);
+    s_update.flush_source = NULL;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  s_update_submit(display, elements, count);
+
+  for(i = 0; i < count; i++)
+  {
+    if(elements[i].element == 0)
+      return -1;
+  }
+  return 0;
+}
+
+/* Submit whatever is pending right now from the calling thread*/
+void dispmanx_update_flush(void)
+{
+  g_mutex_lock(&s_update.lock);
+  if(s_update.flush_source)
+  {
+    g_source_destroy(s_update.flush_source);
+    g_source_unref(s_update.flush_source);
+    s_update.flush_source = NULL;
+  }
+  g_mutex_unlock(&s_update.lock);
+
+  s_update_flush();
+  return;
+}
+
+void dispmanx_update_get_stats(dispmanx_update_stats_t *stats)
+{
+  if(stats == NULL)
+    return;
+
+  g_mutex_lock(&s_update.lock);
+  memcpy(stats, &s_update.stats, sizeof(dispmanx_update_stats_t));
+  g_mutex_unlock(&s_update.lock);
+  return;
+}
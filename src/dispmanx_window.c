@@ -29,20 +29,65 @@ SOFTWARE */
 
 #include "player.h"
 #include "dispmanx_window.h"
+#include "dispmanx_backend.h"
+#include "dispmanx_update.h"
+#include "dispmanx_layout.h"
 
 static dispmanx_display_t s_dispmanx;
+static const dispmanx_backend_t *s_backend = NULL;
 
+static const dispmanx_backend_t *s_dispmanx_lookup_backend(const char *name);
+static const dispmanx_backend_t *s_dispmanx_default_backend(void);
 static void dispmanx_win_create_background(player_instance_t *player_instance, int32_t layer, uint32_t bg_color);
-static void dispmanx_win_add_background_element(dispmanx_background_t *bg, DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_UPDATE_HANDLE_T update);
+static void dispmanx_win_fill_background_element(const dispmanx_background_t *bg, dispmanx_update_element_t *add);
     
+static const dispmanx_backend_t *s_dispmanx_lookup_backend(const char *name)
+{
+  if(name == NULL)
+    return NULL;
+#if I_PLAYER_HAVE_DISPMANX
+  if(strcmp(name, dispmanx_backend_vc()->name) == 0)
+    return dispmanx_backend_vc();
+#endif
+  if(strcmp(name, dispmanx_backend_soft()->name) == 0)
+    return dispmanx_backend_soft();
+
+  return NULL;
+}
+
+/* I_PLAYER_WINDOW_BACKEND overrides the build default*/
+static const dispmanx_backend_t *s_dispmanx_default_backend(void)
+{
+  const dispmanx_backend_t *backend = NULL;
+  const char *name = g_getenv("I_PLAYER_WINDOW_BACKEND");
+
+  if(name)
+  {
+    backend = s_dispmanx_lookup_backend(name);
+    if(backend == NULL)
+    {
+      I_LOG_WARNING("!!!!!!!!!! Unknown Window Backend %s !!!!!!!!!!\n", name);
+    }
+  }
+
+  if(backend == NULL)
+  {
+#if I_PLAYER_HAVE_DISPMANX
+    backend = dispmanx_backend_vc();
+#else
+    backend = dispmanx_backend_soft();
+#endif
+  }
+  return backend;
+}
+
 static void dispmanx_win_create_background(player_instance_t *player_instance, int32_t layer, uint32_t bg_color)
 {
-  uint32_t image_ptr;
   uint16_t color = (uint16_t)bg_color;
   VC_IMAGE_TYPE_T type = VC_IMAGE_RGBA16;
   VC_RECT_T dst_rect;
 
-  player_instance->bg.resource = vc_dispmanx_resource_create(type, 1, 1, &image_ptr);
+  player_instance->bg.resource = s_backend->resource_create(type, 1, 1);
   if(player_instance->bg.resource == 0)
     return;
 
@@ -50,7 +95,7 @@ static void dispmanx_win_create_background(player_instance_t *player_instance, i
 
   player_instance->bg.layer = layer;
 
-  vc_dispmanx_resource_write_data(player_instance->bg.resource,
+  s_backend->resource_write_data(player_instance->bg.resource,
       type,
       sizeof(color),
       &color,
@@ -58,40 +103,28 @@ static void dispmanx_win_create_background(player_instance_t *player_instance, i
   return;
 }
 
-static void dispmanx_win_add_background_element(dispmanx_background_t *bg, DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_UPDATE_HANDLE_T update)
+static void dispmanx_win_fill_background_element(const dispmanx_background_t *bg, dispmanx_update_element_t *add)
 {
-  VC_RECT_T src_rect;
-  VC_RECT_T dst_rect;
-  VC_DISPMANX_ALPHA_T alpha =
-  {   
-    DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS, 
-    bg->opacity,
-    0   
-  };  
-
-  vc_dispmanx_rect_set(&src_rect, 0, 0, 1, 1); 
-  vc_dispmanx_rect_set(&dst_rect, 0, 0, 0, 0); 
-
-  bg->element = vc_dispmanx_element_add(update,
-      display,
-      bg->layer,
-      &dst_rect,
-      bg->resource,
-      &src_rect,
-      DISPMANX_PROTECTION_NONE,
-      &alpha,
-      NULL,
-      DISPMANX_NO_ROTATE);
+  I_ZEROMEM(add, sizeof(dispmanx_update_element_t));
+  add->layer = bg->layer;
+  add->resource = bg->resource;
+  add->alpha.flags = DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS;
+  add->alpha.opacity = bg->opacity;
+  add->transform = DISPMANX_NO_ROTATE;
+  vc_dispmanx_rect_set(&add->src_rect, 0, 0, 1, 1);
+  vc_dispmanx_rect_set(&add->dst_rect, 0, 0, 0, 0);
   return;
 }
 
 void dispmanx_win_show_background_element(dispmanx_background_t *bg, gboolean show)
 {
-  DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
   VC_RECT_T src_rect;
   VC_RECT_T dst_rect;
   int result = 0;
 
+  if(bg->element == 0)
+    return;
+
   if(show == TRUE)
     bg->opacity = 255;
   else /* Hide*/
@@ -100,19 +133,13 @@ void dispmanx_win_show_background_element(dispmanx_background_t *bg, gboolean sh
   vc_dispmanx_rect_set(&src_rect, 0, 0, 1, 1); 
   vc_dispmanx_rect_set(&dst_rect, 0, 0, 0, 0); 
 
-  result = vc_dispmanx_element_change_attributes(update,
-      bg->element,
+  result = dispmanx_update_change_element(bg->element,
       ELEMENT_CHANGE_OPACITY,
       bg->layer,
       bg->opacity,
       &dst_rect,
-      &src_rect,
-      0,
-      DISPMANX_NO_ROTATE);
-
-  assert(result == 0);
+      &src_rect);
 
-  result = vc_dispmanx_update_submit_sync(update);
   assert(result == 0);
 
   return;
@@ -122,24 +149,42 @@ void dispmanx_win_destroy_background_element(dispmanx_background_t *bg)
 {
   int result = 0;
 
-  DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
-  assert(update != 0); 
+  if(bg->element == 0)
+    return;
 
-  result = vc_dispmanx_element_remove(update, bg->element);
+  /* resource is deleted once the removal has reached the display*/
+  result = dispmanx_update_remove_element(bg->element, bg->resource);
   assert(result == 0); 
 
-  result = vc_dispmanx_update_submit_sync(update);
-  assert(result == 0); 
+  bg->element = 0;
+  bg->resource = 0;
+
+  return;	
+}
 
-  result = vc_dispmanx_resource_delete(bg->resource);
+/* Hidden windows keep their element and keep being rendered into, so showing one again is a single opacity change*/
+void dispmanx_win_show_video_element(dispmanx_window_t *vid_win, gboolean show)
+{
+  int result = 0;
+
+  if(vid_win == NULL || vid_win->vid_window.element == 0)
+    return;
+
+  vid_win->opacity = (show == TRUE) ? 255 : 0;
+
+  result = dispmanx_update_change_element(vid_win->vid_window.element,
+      ELEMENT_CHANGE_OPACITY,
+      vid_win->vid_layer,
+      vid_win->opacity,
+      NULL,
+      NULL);
   assert(result == 0);
 
-  return;	
+  return;
 }
 
 void dispmanx_win_move(dispmanx_window_t *vid_win, gint x, gint y)
 {
-  DISPMANX_UPDATE_HANDLE_T update = 0;
   VC_RECT_T result_dest;
   gint new_x = 0;
   gint new_y = 0;
@@ -181,30 +226,21 @@ void dispmanx_win_move(dispmanx_window_t *vid_win, gint x, gint y)
   
   if( first || memcmp(&(vid_win->dst_rect), &result_dest, sizeof(VC_RECT_T)) ) /* Dont have to update if values have not changed*/
   {
+    /* only the position changes, src_rect keeps the crop of the current layout*/
     memcpy(&(vid_win->dst_rect), &result_dest, sizeof(VC_RECT_T));
-  
-    vid_win->src_rect.x = 0;
-    vid_win->src_rect.y = 0;
-    vid_win->src_rect.width = (int32_t)vid_win->vid_width << 16; 
-    vid_win->src_rect.height = (int32_t)vid_win->vid_height << 16;
 
 
     I_LOG_INFO("Moving from %d %d %d %d ==> %d %d %d %d\n",
         vid_win->src_rect.x, vid_win->src_rect.y , vid_win->src_rect.width >> 16, vid_win->src_rect.height >> 16,
         vid_win->dst_rect.x, vid_win->dst_rect.y , vid_win->dst_rect.width, vid_win->dst_rect.height);
   
-    update = vc_dispmanx_update_start(0);
-    result = vc_dispmanx_element_change_attributes(update,
-        vid_win->vid_window.element,
+    result = dispmanx_update_change_element(vid_win->vid_window.element,
         ELEMENT_CHANGE_DEST_RECT,
         vid_win->vid_layer,
-        255,
+        vid_win->opacity,
         &(vid_win->dst_rect),
-        &(vid_win->src_rect),
-        0,
-        DISPMANX_NO_ROTATE);
+        &(vid_win->src_rect));
     assert(result == 0);
-    vc_dispmanx_update_submit_sync(update);
     first = 0;
   }
   else
@@ -217,92 +253,177 @@ void dispmanx_win_move(dispmanx_window_t *vid_win, gint x, gint y)
 
 void dispmanx_win_set_fullscreen(dispmanx_window_t *vid_win, gboolean fullscreen)
 {
-  DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
   int result = -1;
+  dispmanx_layout_source_t source;
+  dispmanx_layout_params_t params;
+  VC_RECT_T area;
 
-  VC_RECT_T result_dest;
+  source.width = vid_win->vid_width;
+  source.height = vid_win->vid_height;
+  source.par_n = vid_win->par_n;
+  source.par_d = vid_win->par_d;
+
+  params.mode = vid_win->ar;
+  params.zoom = vid_win->zoom;
+  params.region = vid_win->custom_region;
 
   if(fullscreen == TRUE)
   {
-    if(vid_win->ar == PLAYER_AR_STRETCH)
-    {
-      result_dest.x = 0;
-      result_dest.y = 0;
-      result_dest.width = s_dispmanx.info.width;
-      result_dest.height = s_dispmanx.info.height;
-    }
-    else /* use default aspect ratio from source*/
-    {
-      gdouble src_ratio, dst_ratio;
-      src_ratio = (gdouble) vid_win->vid_width / vid_win->vid_height;
-      dst_ratio = (gdouble) s_dispmanx.info.width / s_dispmanx.info.height;
-      if (src_ratio > dst_ratio)
-      {
-        result_dest.width = s_dispmanx.info.width;
-        result_dest.height =(int32_t)(s_dispmanx.info.width / src_ratio);
-        result_dest.x = 0;
-        result_dest.y = (s_dispmanx.info.height - result_dest.height) / 2;
-      }
-      else if (src_ratio < dst_ratio)
-      {
-        result_dest.width = (int32_t)(s_dispmanx.info.height * src_ratio);
-        result_dest.height = s_dispmanx.info.height;
-        result_dest.x = (s_dispmanx.info.width - result_dest.width) / 2;
-        result_dest.y = 0;
-      }
-      else
-      {
-        result_dest.x = 0;
-        result_dest.y = 0;
-        result_dest.width = s_dispmanx.info.width;
-        result_dest.height = s_dispmanx.info.height;
-      } 
-    }
-    memcpy(&(vid_win->dst_rect), &result_dest, sizeof(VC_RECT_T));
-
+    vc_dispmanx_rect_set(&area, 0, 0, (uint32_t)s_dispmanx.info.width, (uint32_t)s_dispmanx.info.height);
     vid_win->in_fullscreen = TRUE;
   }
-  else /* Exit fullscreen , display with actual resolution at the center of the screen*/
+  else /* Exit fullscreen , display with actual resolution (pixel aspect corrected), the aspect ratio mode applies inside that area*/
   {
-    vid_win->dst_rect.x = (int32_t)(((guint)s_dispmanx.info.width - vid_win->vid_width) / 2) ;
-    vid_win->dst_rect.y = (int32_t)(((guint)s_dispmanx.info.height - vid_win->vid_height) / 2);
-    vid_win->dst_rect.width = (int32_t)vid_win->vid_width;
-    vid_win->dst_rect.height = (int32_t)vid_win->vid_height;
-
+    uint32_t width = vid_win->vid_width;
+    uint32_t height = vid_win->vid_height;
+    int32_t centre_x = s_dispmanx.info.width / 2;
+    int32_t centre_y = s_dispmanx.info.height / 2;
+
+    if(vid_win->par_n && vid_win->par_d)
+      width = (uint32_t)(((guint64)width * vid_win->par_n + vid_win->par_d / 2) / vid_win->par_d);
+    width = MIN(width, (uint32_t)s_dispmanx.info.width);
+    height = MIN(height, (uint32_t)s_dispmanx.info.height);
+
+    /* a window already on screen stays where it was moved to, the layout centres dst_rect in the area*/
+    if(vid_win->in_fullscreen == FALSE && vid_win->dst_rect.width > 0 && vid_win->dst_rect.height > 0)
+    {
+      centre_x = vid_win->dst_rect.x + vid_win->dst_rect.width / 2;
+      centre_y = vid_win->dst_rect.y + vid_win->dst_rect.height / 2;
+    }
+    centre_x = CLAMP(centre_x, (int32_t)width / 2, s_dispmanx.info.width - (int32_t)(width - width / 2));
+    centre_y = CLAMP(centre_y, (int32_t)height / 2, s_dispmanx.info.height - (int32_t)(height - height / 2));
+    vc_dispmanx_rect_set(&area, (uint32_t)(centre_x - (int32_t)width / 2), (uint32_t)(centre_y - (int32_t)height / 2), width, height);
     vid_win->in_fullscreen = FALSE;
   }
 
-  vid_win->src_rect.x = 0;
-  vid_win->src_rect.y = 0;
-  vid_win->src_rect.width = (int32_t)(vid_win->vid_width << 16); 
-  vid_win->src_rect.height = (int32_t)(vid_win->vid_height << 16);
-  
+  if(dispmanx_layout_compute(&source, &area, &params, &(vid_win->src_rect), &(vid_win->dst_rect)) == FALSE)
+  {
+    I_LOG_WARNING("!!!!!!!!!! No Video Size Yet, Layout Skipped !!!!!!!!!!\n");
+    return;
+  }
+
+  /* The layout is in video pixels, but the element's source is the EGL window surface the sink
+   * scales every frame onto (vid_window size, the screen size). Map the crop into surface pixels,
+   * this is a change of units and not a second scaling of the picture*/
+  if(vid_win->vid_window.width > 0 && vid_win->vid_window.height > 0)
+  {
+    vid_win->src_rect.x = (int32_t)(((int64_t)vid_win->src_rect.x * vid_win->vid_window.width) / (int64_t)vid_win->vid_width);
+    vid_win->src_rect.width = (int32_t)(((int64_t)vid_win->src_rect.width * vid_win->vid_window.width) / (int64_t)vid_win->vid_width);
+    vid_win->src_rect.y = (int32_t)(((int64_t)vid_win->src_rect.y * vid_win->vid_window.height) / (int64_t)vid_win->vid_height);
+    vid_win->src_rect.height = (int32_t)(((int64_t)vid_win->src_rect.height * vid_win->vid_window.height) / (int64_t)vid_win->vid_height);
+  }
 
-  I_LOG_INFO("Scaling from %d %d %d %d ==> %d %d %d %d\n",
+  I_LOG_INFO("Scaling [%s] from %d %d %d %d ==> %d %d %d %d\n", dispmanx_layout_mode_name(params.mode),
       vid_win->src_rect.x >> 16, vid_win->src_rect.y >> 16, vid_win->src_rect.width >> 16, vid_win->src_rect.height >> 16,
       vid_win->dst_rect.x, vid_win->dst_rect.y , vid_win->dst_rect.width, vid_win->dst_rect.height);
 
-  result = vc_dispmanx_element_change_attributes(update,
-      vid_win->vid_window.element,
-      ELEMENT_CHANGE_DEST_RECT,
+  result = dispmanx_update_change_element(vid_win->vid_window.element,
+      ELEMENT_CHANGE_DEST_RECT | ELEMENT_CHANGE_SRC_RECT,
       vid_win->vid_layer,
-      255,
+      vid_win->opacity,
       &(vid_win->dst_rect),
-      &(vid_win->src_rect),
-      0,
-      DISPMANX_NO_ROTATE);
+      &(vid_win->src_rect));
   assert(result == 0);
-  vc_dispmanx_update_submit_sync(update);
 
   return;
 }
 
+/* zoom in 16.16, switches to PLAYER_AR_ZOOM*/
+void dispmanx_win_set_zoom(dispmanx_window_t *vid_win, int32_t zoom)
+{
+  vid_win->zoom = MAX(zoom, DISPMANX_LAYOUT_ONE);
+  vid_win->ar = PLAYER_AR_ZOOM;
+  dispmanx_win_set_fullscreen(vid_win, vid_win->in_fullscreen);
+  return;
+}
+
+/* region in 16.16 source pixels, switches to PLAYER_AR_CUSTOM*/
+void dispmanx_win_set_custom_region(dispmanx_window_t *vid_win, const VC_RECT_T *region)
+{
+  vid_win->custom_region = *region;
+  vid_win->ar = PLAYER_AR_CUSTOM;
+  dispmanx_win_set_fullscreen(vid_win, vid_win->in_fullscreen);
+  return;
+}
+
+gboolean dispmanx_set_backend(const char *name)
+{
+  const dispmanx_backend_t *backend = NULL;
+  gboolean status = FALSE;
+
+  if( s_dispmanx.display > 0)
+  {
+    I_LOG_WARNING("!!!!!!!!!! Backend Cannot Be Changed After Display Is Initialized !!!!!!!!!!\n");
+    goto safe_exit;
+  }
+
+  backend = s_dispmanx_lookup_backend(name);
+  if(backend == NULL)
+  {
+    I_LOG_ERROR("xxxxxxxxxx Unknown Window Backend %s xxxxxxxxxx\n", name ? name : "(null)");
+    goto safe_exit;
+  }
+
+  s_backend = backend;
+  status = TRUE;
+
+safe_exit:
+  return status;
+}
+
+const char *dispmanx_get_backend_name(void)
+{
+  return s_backend ? s_backend->name : NULL;
+}
+
+const dispmanx_backend_t *dispmanx_get_backend(void)
+{
+  return s_backend;
+}
+
+/* Element showing a resource of its own (not an EGL surface), added behind the queued changes*/
+DISPMANX_ELEMENT_HANDLE_T dispmanx_win_add_resource_element(int32_t layer, const VC_RECT_T *dst_rect,
+    DISPMANX_RESOURCE_HANDLE_T resource, const VC_RECT_T *src_rect, uint8_t opacity)
+{
+  dispmanx_update_element_t add;
+
+  if(s_backend == NULL || s_dispmanx.display == 0 || dst_rect == NULL || src_rect == NULL)
+    return 0;
+
+  I_ZEROMEM(&add, sizeof(add));
+  add.layer = layer;
+  add.dst_rect = *dst_rect;
+  add.resource = resource;
+  add.src_rect = *src_rect;
+  add.alpha.flags = DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS;
+  add.alpha.opacity = opacity;
+  add.transform = DISPMANX_NO_ROTATE;
+  dispmanx_update_add_elements(s_dispmanx.display, &add, 1);
+  return add.element;
+}
+
+void dispmanx_get_display_size(int32_t *width, int32_t *height)
+{
+  if(width)
+    *width = s_dispmanx.info.width;
+  if(height)
+    *height = s_dispmanx.info.height;
+  return;
+}
+
 void dispmanx_shutdown_window_system()
 {
   I_LOG_WARNING("---------- UN-IMPLEMENTED ----------\n");
   /* TODO remove background and video layer elements*/
-  vc_dispmanx_display_close( s_dispmanx.display );
-  bcm_host_deinit();
+  if(s_backend == NULL)
+    return;
+
+  /* push out anything still waiting for a frame*/
+  dispmanx_update_shutdown();
+
+  s_backend->display_close( s_dispmanx.display );
+  s_backend->deinit();
+  s_dispmanx.display = 0;
 
   return;
 }
@@ -320,17 +441,22 @@ gboolean dispmanx_initialize_window_system()
     goto safe_exit;
   }
 
-  bcm_host_init();
+  if(s_backend == NULL)
+    s_backend = s_dispmanx_default_backend();
 
-  I_LOG_DEBUG("Opening display... %u\n", screen);
-  s_dispmanx.display = vc_dispmanx_display_open(screen);
+  s_backend->init();
+
+  I_LOG_DEBUG("Opening display... %u [%s]\n", screen, s_backend->name);
+  s_dispmanx.display = s_backend->display_open(screen);
   I_ASSERT(s_dispmanx.display != 0);
 
-  ret = vc_dispmanx_display_get_info(s_dispmanx.display, &s_dispmanx.info);
+  ret = s_backend->display_get_info(s_dispmanx.display, &s_dispmanx.info);
   I_ASSERT(ret == 0);
 
   I_LOG_DEBUG("Opened Display [%d x %d]\n", s_dispmanx.info.width, s_dispmanx.info.height);
 
+  dispmanx_update_init(s_backend);
+
   status = TRUE;
 
 safe_exit:
@@ -349,12 +475,8 @@ void dispmanx_win_set_aspect_ratio(player_instance_t *player_instance, dispmanx_
     goto safe_exit;
   }
 
-  if(player_instance->vid_win.in_fullscreen)
-    dispmanx_win_set_fullscreen(&player_instance->vid_win, true); /* call fullscreen to reflect new Aspect ratio*/
-  else
-  {
-    I_LOG_DEBUG("Aspect Ratio is adjusted only in fullscreen.. saving the value for now\n");
-  }
+  /* lay the window out again to reflect the new aspect ratio, fullscreen or not*/
+  dispmanx_win_set_fullscreen(&player_instance->vid_win, player_instance->vid_win.in_fullscreen);
 
 safe_exit:
   return;
@@ -362,22 +484,24 @@ safe_exit:
 
 gboolean dispmanx_create_video_window(player_instance_t *player_instance)
 {
-  DISPMANX_UPDATE_HANDLE_T dispman_update;
+  dispmanx_update_element_t adds[2];
   gboolean ret = FALSE;
 
-  int32_t screen = 0;
-  VC_DISPMANX_ALPHA_T alpha = { DISPMANX_FLAGS_ALPHA_FROM_SOURCE | DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS, 
-    255, /*alpha 0->255*/
-    0 };
-
   if(player_instance == NULL)
   {
     I_LOG_ERROR("xxxxxxxxxx Invalid Argument xxxxxxxxxx\n");
     goto safe_exit;
   }
 
-  /* create background to add at layer -1, i.e before video layer*/
-  dispmanx_win_create_background(player_instance, -1, 0x000F);
+  /* Layers come from the player manager, unmanaged windows keep video at 0 and background at -1*/
+  if(player_instance->player_handler == 0)
+  {
+    player_instance->vid_win.vid_layer = 0;
+    player_instance->bg.layer = -1;
+  }
+
+  /* create background just below the video layer*/
+  dispmanx_win_create_background(player_instance, player_instance->bg.layer, 0x000F);
 
   player_instance->vid_win.dst_rect.x = 0;
   player_instance->vid_win.dst_rect.y = 0;
@@ -389,28 +513,54 @@ gboolean dispmanx_create_video_window(player_instance_t *player_instance)
   player_instance->vid_win.src_rect.width = s_dispmanx.info.width << 16; 
   player_instance->vid_win.src_rect.height = s_dispmanx.info.height << 16; 
 
-  dispman_update = vc_dispmanx_update_start(screen);
-
   /* Add background element*/
-  dispmanx_win_add_background_element(&player_instance->bg, s_dispmanx.display, dispman_update);
-
-  /* Add video element at layer 0*/
-  player_instance->vid_win.vid_layer = 0;
+  dispmanx_win_fill_background_element(&player_instance->bg, &adds[0]);
+
+  /* Add video element on its own layer*/
+  I_ZEROMEM(&adds[1], sizeof(dispmanx_update_element_t));
+  adds[1].layer = player_instance->vid_win.vid_layer;
+  adds[1].dst_rect = player_instance->vid_win.dst_rect;
+  adds[1].resource = 0;
+  adds[1].src_rect = player_instance->vid_win.src_rect;
+  adds[1].alpha.flags = DISPMANX_FLAGS_ALPHA_FROM_SOURCE | DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS;
+  adds[1].alpha.opacity = 255; /*alpha 0->255*/
+  adds[1].transform = DISPMANX_SNAPSHOT_FILL;
+
+  /* both go out in one update, behind whatever other windows have queued*/
+  dispmanx_update_add_elements(s_dispmanx.display, adds, 2);
+  player_instance->bg.element = adds[0].element;
 
   /* Form EGL_DISPMANX_WINDOW_T using the Dispmanx window*/
-  player_instance->vid_win.vid_window.element =  vc_dispmanx_element_add(dispman_update, s_dispmanx.display,
-      player_instance->vid_win.vid_layer/*layer*/, &player_instance->vid_win.dst_rect, 0/*src*/,
-      &player_instance->vid_win.src_rect, DISPMANX_PROTECTION_NONE, 
-      &alpha/*alpha*/, 0/*clamp*/, DISPMANX_SNAPSHOT_FILL/*0*//*transform*/);
+  player_instance->vid_win.vid_window.element = adds[1].element;
+  player_instance->vid_win.opacity = 255;
+  player_instance->vid_win.zoom = DISPMANX_LAYOUT_ONE;
   player_instance->vid_win.vid_window.width = s_dispmanx.info.width;
   player_instance->vid_win.vid_window.height = s_dispmanx.info.height;
 
-  /* save the window handle*/
-  player_instance->video_window_handle = (gpointer)(&(player_instance->vid_win.vid_window));
+  /* save the window handle, only a real dispmanx element can be rendered into by the sink*/
+  if(s_backend->native_window)
+    player_instance->video_window_handle = (gpointer)(&(player_instance->vid_win.vid_window));
+  else
+    player_instance->video_window_handle = NULL;
 
-  vc_dispmanx_update_submit_sync(dispman_update);
   ret = TRUE;
 
 safe_exit:
   return ret;
 }
+
+void dispmanx_destroy_video_window(player_instance_t *player_instance)
+{
+  int result = 0;
+
+  if(player_instance == NULL || player_instance->vid_win.vid_window.element == 0)
+    return;
+
+  /* video element has no resource of its own*/
+  result = dispmanx_update_remove_element(player_instance->vid_win.vid_window.element, 0);
+  assert(result == 0);
+
+  player_instance->vid_win.vid_window.element = 0;
+  player_instance->video_window_handle = NULL;
+  return;
+}
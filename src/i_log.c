@@ -0,0 +1,389 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <syslog.h>
+#include <sys/eventfd.h>
+
+#include <player.h>
+
+/* Every thread that logs gets its own single producer / single consumer
+ * ring, the writer thread is the only consumer of all of them. A producer
+ * only touches its ring and, when the writer may be asleep, an eventfd.
+ * Rings of exited threads are handed to the next new thread once drained,
+ * so their number stays bounded by the number of live threads.*/
+
+#define I_LOG_WRITER_POLL_MS 100 /* fallback wake up, the eventfd normally wakes the writer*/
+
+typedef struct
+{
+    const char *file;
+    const char *func;
+    int line;
+    int level;
+    char msg[I_LOG_MSG_SIZE];
+}i_log_record_t;
+
+typedef struct i_log_ring
+{
+    struct i_log_ring *next;
+    gint head;     /* consumer position, free running*/
+    gint tail;     /* producer position, free running*/
+    gint in_use;   /* owned by a live thread*/
+    gint dropped;
+    i_log_record_t records[I_LOG_RING_SLOTS];
+}i_log_ring_t;
+
+typedef enum
+{
+    I_LOG_SINK_STDOUT = 0,
+    I_LOG_SINK_FILE,
+    I_LOG_SINK_SYSLOG
+}i_log_sink_e;
+
+static void s_log_ring_release(gpointer data);
+
+static i_log_ring_t *s_rings = NULL; /* lock free list, rings are never freed while running*/
+static GPrivate s_thread_ring = G_PRIVATE_INIT(s_log_ring_release);
+static gint s_running = 0;
+static gint s_writers = 0;   /* threads inside i_log_write past the s_running check*/
+static int s_wake_fd = -1;
+static GThread *s_writer = NULL;
+static i_log_sink_e s_sink = I_LOG_SINK_STDOUT;
+static FILE *s_out = NULL;
+static gboolean s_colour = FALSE;
+static GMutex s_dropped_lock;
+static guint64 s_dropped_total = 0;
+
+static const char *s_level_names[] = { "", "[FATAL]", "[ERROR]", "[WARN]", "[INFO]", "[DEBUG]", "[TRACE]" };
+static const char *s_level_colours[] = { "", "\e[0;31m", "\e[0;31m", "\e[0;33m", "\e[0;32m", "\e[0;36m", "\e[0;34m" };
+static const int s_level_syslog[] = { LOG_DEBUG, LOG_CRIT, LOG_ERR, LOG_WARNING, LOG_INFO, LOG_DEBUG, LOG_DEBUG };
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* thread exit, the writer still drains what is left*/
+static void s_log_ring_release(gpointer data)
+{
+    i_log_ring_t *ring = (i_log_ring_t *) data;
+
+    g_atomic_int_set(&ring->in_use, 0);
+    return;
+}
+
+static i_log_ring_t *s_log_get_ring(void)
+{
+    i_log_ring_t *ring = g_private_get(&s_thread_ring);
+
+    if (ring)
+        return ring;
+
+    /* re-use a drained ring of an exited thread*/
+    for (ring = g_atomic_pointer_get(&s_rings); ring; ring = ring->next)
+    {
+        if (g_atomic_int_get(&ring->head) == g_atomic_int_get(&ring->tail) &&
+                g_atomic_int_compare_and_exchange(&ring->in_use, 0, 1))
+            break;
+    }
+
+    if (ring == NULL)
+    {
+        ring = g_new0(i_log_ring_t, 1);
+        ring->in_use = 1;
+        do
+        {
+            ring->next = g_atomic_pointer_get(&s_rings);
+        } while (!g_atomic_pointer_compare_and_exchange(&s_rings, ring->next, ring));
+    }
+
+    g_private_set(&s_thread_ring, ring);
+    return ring;
+}
+
+static void s_log_wake_writer(void)
+{
+    uint64_t one = 1;
+
+    /* non blocking, a saturated counter already means "wake up"*/
+    if (write(s_wake_fd, &one, sizeof(one)) < 0)
+        return;
+    return;
+}
+
+static void s_log_output(const i_log_record_t *record)
+{
+    int level = (record->level >= I_LOG_LEVEL_FATAL && record->level <= I_LOG_LEVEL_TRACE) ? record->level : I_LOG_LEVEL_TRACE;
+
+    if (s_sink == I_LOG_SINK_SYSLOG)
+    {
+        syslog(s_level_syslog[level], "%s -> %s(%d) : %s", record->file, record->func, record->line, record->msg);
+    }
+    else if (s_colour == FALSE)
+    {
+        fprintf(s_out, "%-9s : %s -> %s(%d) : %s", s_level_names[level], record->file, record->func, record->line, record->msg);
+    }
+    else if (level <= I_LOG_LEVEL_WARNING)
+    {
+        /* errors keep the whole line coloured*/
+        fprintf(s_out, "%s%-9s : %s -> %s(%d) : %s\e[0m", s_level_colours[level], s_level_names[level],
+                record->file, record->func, record->line, record->msg);
+    }
+    else
+    {
+        fprintf(s_out, "%s%-9s :\e[0m %s -> %s(%d) : %s", s_level_colours[level], s_level_names[level],
+                record->file, record->func, record->line, record->msg);
+    }
+    return;
+}
+
+/* Writer thread, or i_log_shutdown once the writer is gone*/
+static gboolean s_log_drain(void)
+{
+    i_log_ring_t *ring;
+    gboolean wrote = FALSE;
+
+    for (ring = g_atomic_pointer_get(&s_rings); ring; ring = ring->next)
+    {
+        gint head = g_atomic_int_get(&ring->head);
+        gint dropped;
+
+        while (head != g_atomic_int_get(&ring->tail))
+        {
+            s_log_output(&ring->records[(guint)head & (I_LOG_RING_SLOTS - 1)]);
+            head++;
+            g_atomic_int_set(&ring->head, head); /* slot may be reused from here*/
+            wrote = TRUE;
+        }
+
+        dropped = g_atomic_int_get(&ring->dropped);
+        if (dropped)
+        {
+            g_atomic_int_add(&ring->dropped, -dropped);
+
+            i_log_record_t note;
+
+            I_ZEROMEM(&note, sizeof(note));
+            note.level = I_LOG_LEVEL_WARNING;
+            note.file = __FILE__;
+            note.func = __func__;
+            note.line = __LINE__;
+            g_snprintf(note.msg, sizeof(note.msg), "!!!!!!!!!! %d log records dropped, ring full !!!!!!!!!!\n", dropped);
+            s_log_output(&note);
+            g_mutex_lock(&s_dropped_lock);
+            s_dropped_total += (guint64)dropped;
+            g_mutex_unlock(&s_dropped_lock);
+            wrote = TRUE;
+        }
+    }
+
+    if (wrote && s_out)
+        fflush(s_out);
+    return wrote;
+}
+
+static gpointer s_log_writer(gpointer data)
+{
+    struct pollfd wake = { s_wake_fd, POLLIN, 0 };
+
+    while (g_atomic_int_get(&s_running))
+    {
+        if (poll(&wake, 1, I_LOG_WRITER_POLL_MS) > 0)
+        {
+            uint64_t count;
+            if (read(s_wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+                break;
+        }
+        s_log_drain();
+    }
+
+    /* shutdown, write out what is left*/
+    while (s_log_drain())
+        ;
+    return NULL;
+}
+
+static void s_log_open_sink(void)
+{
+    const gchar *sink = g_getenv("I_PLAYER_LOG");
+
+    s_sink = I_LOG_SINK_STDOUT;
+    s_out = stdout;
+    if (sink && g_str_has_prefix(sink, "file:"))
+    {
+        FILE *file = fopen(sink + strlen("file:"), "a");
+        if (file)
+        {
+            s_sink = I_LOG_SINK_FILE;
+            s_out = file;
+        }
+        else
+            fprintf(stderr, "i_log : couldnt open %s : %s, logging to stdout\n", sink + strlen("file:"), g_strerror(errno));
+    }
+    else if (g_strcmp0(sink, "syslog") == 0)
+    {
+        s_sink = I_LOG_SINK_SYSLOG;
+        s_out = NULL;
+        openlog("i_player", LOG_PID, LOG_USER);
+    }
+    s_colour = (s_sink == I_LOG_SINK_STDOUT && isatty(fileno(stdout)));
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void i_log_init(void)
+{
+    if (g_atomic_int_get(&s_running))
+        return;
+
+    s_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s_wake_fd < 0)
+    {
+        fprintf(stderr, "i_log : eventfd failed : %s, logging synchronously\n", g_strerror(errno));
+        return;
+    }
+
+    s_log_open_sink();
+    g_atomic_int_set(&s_running, 1);
+    s_writer = g_thread_try_new("LogWriter", s_log_writer, NULL, NULL);
+    if (s_writer == NULL)
+    {
+        g_atomic_int_set(&s_running, 0);
+        close(s_wake_fd);
+        s_wake_fd = -1;
+    }
+    return;
+}
+
+/* Flushes every record logged before the call*/
+void i_log_shutdown(void)
+{
+    FILE *out = s_out;
+    i_log_sink_e sink = s_sink;
+
+    if (s_writer == NULL)
+        return;
+
+    /* new records are written directly from here on*/
+    g_atomic_int_set(&s_running, 0);
+    s_log_wake_writer();
+    g_thread_join(s_writer);
+    s_writer = NULL;
+
+    /* threads which got past the check before it changed may still be publishing and
+     * waking the writer, the fd stays open until they are out*/
+    while (g_atomic_int_get(&s_writers) > 0)
+        g_thread_yield();
+    while (s_log_drain())
+        ;
+
+    close(s_wake_fd);
+    s_wake_fd = -1;
+
+    s_sink = I_LOG_SINK_STDOUT;
+    s_out = stdout;
+    s_colour = isatty(fileno(stdout));
+    if (sink == I_LOG_SINK_FILE)
+        fclose(out);
+    else if (sink == I_LOG_SINK_SYSLOG)
+        closelog();
+    return;
+}
+
+void i_log_write(int level, const char *file, const char *func, int line, const char *format, ...)
+{
+    i_log_record_t *record = NULL;
+    i_log_ring_t *ring = NULL;
+    va_list args;
+    gint head, tail;
+
+    /* counted before the check, so i_log_shutdown can wait for this record*/
+    g_atomic_int_inc(&s_writers);
+    if (!g_atomic_int_get(&s_running))
+    {
+        /* no writer, behave like the old printf macros*/
+        i_log_record_t direct;
+
+        va_start(args, format);
+        g_vsnprintf(direct.msg, sizeof(direct.msg), format, args);
+        va_end(args);
+        direct.file = file;
+        direct.func = func;
+        direct.line = line;
+        direct.level = level;
+        if (s_out == NULL)
+        {
+            s_out = stdout;
+            s_colour = isatty(fileno(stdout));
+        }
+        g_atomic_int_add(&s_writers, -1);
+        s_log_output(&direct);
+        return;
+    }
+
+    ring = s_log_get_ring();
+    tail = ring->tail; /* only this thread writes it*/
+    head = g_atomic_int_get(&ring->head);
+    if ((guint)(tail - head) >= I_LOG_RING_SLOTS)
+    {
+        g_atomic_int_inc(&ring->dropped);
+        g_atomic_int_add(&s_writers, -1);
+        return;
+    }
+
+    record = &ring->records[(guint)tail & (I_LOG_RING_SLOTS - 1)];
+    record->file = file;
+    record->func = func;
+    record->line = line;
+    record->level = level;
+    va_start(args, format);
+    g_vsnprintf(record->msg, sizeof(record->msg), format, args);
+    va_end(args);
+
+    g_atomic_int_set(&ring->tail, tail + 1); /* publish*/
+
+    /* The writer drains until head catches up with tail. If it already had,
+     * it may be asleep and has to be told about this record*/
+    if (g_atomic_int_get(&ring->head) == tail)
+        s_log_wake_writer();
+    g_atomic_int_add(&s_writers, -1);
+    return;
+}
+
+/* Records dropped on full rings since start, as seen by the writer*/
+uint64_t i_log_get_dropped(void)
+{
+    uint64_t dropped;
+
+    g_mutex_lock(&s_dropped_lock);
+    dropped = s_dropped_total;
+    g_mutex_unlock(&s_dropped_lock);
+    return dropped;
+}
@@ -0,0 +1,275 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_buffering.h>
+
+/* GstPlayFlags is private to playbin*/
+#define S_PLAY_FLAG_DOWNLOAD (1 << 7)
+
+struct player_buffering
+{
+    GMutex lock;
+    player_buffering_config_t config;
+    gulong element_added_id;
+    gulong message_id;
+    gint64 first_report;        /* monotonic us, 0 until the first report*/
+    gint64 stall_start;         /* 0 while not buffering*/
+    player_buffering_stats_t stats;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+static gboolean s_buffering_is_queue(GstElement *element)
+{
+    GstElementFactory *factory = gst_element_get_factory (element);
+    const gchar *name = (factory) ? GST_OBJECT_NAME (factory) : NULL;
+
+    return (g_strcmp0 (name, "queue2") == 0 || g_strcmp0 (name, "multiqueue") == 0);
+}
+
+static void s_buffering_set_watermarks(struct player_buffering *buffering, GstElement *queue)
+{
+    g_object_set (queue, "low-watermark", (gdouble)buffering->config.low_percent / 100.0,
+            "high-watermark", (gdouble)buffering->config.high_percent / 100.0, NULL);
+    I_LOG_DEBUG("Buffering watermarks %d %% / %d %% on %s\n", buffering->config.low_percent,
+            buffering->config.high_percent, GST_OBJECT_NAME (queue));
+    return;
+}
+
+/* streaming or application thread, uridecodebin and decodebin add their queues on demand*/
+static void s_buffering_element_added_cb(GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer user_data)
+{
+    struct player_buffering *buffering = (struct player_buffering *) user_data;
+
+    if (s_buffering_is_queue(element))
+    {
+        g_mutex_lock(&buffering->lock);
+        s_buffering_set_watermarks(buffering, element);
+        g_mutex_unlock(&buffering->lock);
+    }
+    return;
+}
+
+/* GstPlayer thread, GstPlayer does the pause and resume on the same messages*/
+static void s_buffering_message_cb(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    struct player_buffering *buffering = (struct player_buffering *) user_data;
+    gint64 now = g_get_monotonic_time();
+    gint percent = 0;
+
+    gst_message_parse_buffering (message, &percent);
+
+    g_mutex_lock(&buffering->lock);
+    if (buffering->first_report == 0)
+        buffering->first_report = now;
+    buffering->stats.percent = percent;
+
+    if (buffering->stats.initial_us < 0)
+    {
+        /* initial fill, not a stall*/
+        if (percent >= 100)
+            buffering->stats.initial_us = now - buffering->first_report;
+        buffering->stats.buffering = (percent < 100);
+    }
+    else if (percent < 100)
+    {
+        if (buffering->stall_start == 0)
+        {
+            buffering->stall_start = now;
+            buffering->stats.stalls++;
+            buffering->stats.buffering = TRUE;
+            I_LOG_WARNING("!!!!!!!!!! Stall %" G_GUINT64_FORMAT " at %d %% !!!!!!!!!!\n", buffering->stats.stalls, percent);
+        }
+        if (percent < buffering->stats.min_percent)
+            buffering->stats.min_percent = percent;
+    }
+    else if (buffering->stall_start)
+    {
+        gint64 stall_us = now - buffering->stall_start;
+
+        buffering->stats.stall_time_us += stall_us;
+        if (stall_us > buffering->stats.longest_stall_us)
+            buffering->stats.longest_stall_us = stall_us;
+        buffering->stall_start = 0;
+        buffering->stats.buffering = FALSE;
+        I_LOG_INFO("========== Stall over after %" G_GINT64_FORMAT " ms ==========\n", stall_us / 1000);
+    }
+    g_mutex_unlock(&buffering->lock);
+    return;
+}
+
+/* for a configuration changed on a running player*/
+static void s_buffering_update_queues(struct player_buffering *buffering, GstElement *pipeline)
+{
+    GstIterator *iter = gst_bin_iterate_recurse (GST_BIN (pipeline));
+    GValue item = G_VALUE_INIT;
+    GstIteratorResult result;
+
+    /* setting the watermarks twice is harmless, a resync starts over*/
+    while ((result = gst_iterator_next (iter, &item)) != GST_ITERATOR_DONE && result != GST_ITERATOR_ERROR)
+    {
+        if (result == GST_ITERATOR_RESYNC)
+        {
+            gst_iterator_resync (iter);
+            continue;
+        }
+        if (s_buffering_is_queue(g_value_get_object (&item)))
+            s_buffering_set_watermarks(buffering, g_value_get_object (&item));
+        g_value_reset (&item);
+    }
+    g_value_unset (&item);
+    gst_iterator_free (iter);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_buffering_config_init(player_buffering_config_t *config)
+{
+    if (config == NULL)
+        return;
+
+    config->buffer_size = PLAYER_BUFFERING_DEFAULT_SIZE;
+    config->buffer_duration = PLAYER_BUFFERING_DEFAULT_DURATION;
+    config->low_percent = PLAYER_BUFFERING_DEFAULT_LOW;
+    config->high_percent = PLAYER_BUFFERING_DEFAULT_HIGH;
+    config->download = FALSE;
+    return;
+}
+
+/* Before player_play for the sizes and download to apply to the first uri, watermarks also apply later*/
+int8_t player_buffering_configure(player_instance_t *player_instance, const player_buffering_config_t *config)
+{
+    struct player_buffering *buffering = NULL;
+    guint flags = 0;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && config != NULL &&
+                    config->low_percent >= 0 && config->low_percent < config->high_percent && config->high_percent <= 100), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    buffering = player_instance->buffering;
+    if (buffering == NULL)
+    {
+        buffering = g_new0(struct player_buffering, 1);
+        g_mutex_init(&buffering->lock);
+        buffering->stats.initial_us = -1;
+        buffering->stats.percent = 100;
+        buffering->stats.min_percent = 100;
+        buffering->element_added_id = g_signal_connect (player_instance->pipeline, "deep-element-added",
+                G_CALLBACK (s_buffering_element_added_cb), buffering);
+        buffering->message_id = g_signal_connect (player_instance->bus, "message::buffering",
+                G_CALLBACK (s_buffering_message_cb), buffering);
+        player_instance->buffering = buffering;
+    }
+
+    g_mutex_lock(&buffering->lock);
+    buffering->config = *config;
+    s_buffering_update_queues(buffering, player_instance->pipeline);
+    g_mutex_unlock(&buffering->lock);
+
+    if (config->buffer_size >= 0)
+        g_object_set (player_instance->pipeline, "buffer-size", config->buffer_size, NULL);
+    if (config->buffer_duration >= 0)
+        g_object_set (player_instance->pipeline, "buffer-duration", config->buffer_duration, NULL);
+
+    g_object_get (player_instance->pipeline, "flags", &flags, NULL);
+    flags = (config->download) ? (flags | S_PLAY_FLAG_DOWNLOAD) : (flags & ~(guint)S_PLAY_FLAG_DOWNLOAD);
+    g_object_set (player_instance->pipeline, "flags", flags, NULL);
+
+    I_LOG_DEBUG("Buffering : %d bytes, %" G_GINT64_FORMAT " ms, watermarks %d %% / %d %%%s\n", config->buffer_size,
+            (config->buffer_duration >= 0) ? (config->buffer_duration / (gint64)GST_MSECOND) : -1,
+            config->low_percent, config->high_percent, (config->download) ? ", download" : "");
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Call once GstPlayer is stopped, logs the statistics*/
+void player_buffering_release(player_instance_t *player_instance)
+{
+    struct player_buffering *buffering = NULL;
+
+    if (player_instance == NULL || player_instance->buffering == NULL)
+        return;
+
+    player_buffering_log_stats(player_instance);
+
+    buffering = player_instance->buffering;
+    g_signal_handler_disconnect (player_instance->pipeline, buffering->element_added_id);
+    g_signal_handler_disconnect (player_instance->bus, buffering->message_id);
+    player_instance->buffering = NULL;
+
+    g_mutex_clear(&buffering->lock);
+    g_free(buffering);
+    return;
+}
+
+int8_t player_buffering_get_stats(player_instance_t *player_instance, player_buffering_stats_t *stats)
+{
+    struct player_buffering *buffering = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->buffering != NULL && stats != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    buffering = player_instance->buffering;
+    g_mutex_lock(&buffering->lock);
+    *stats = buffering->stats;
+    if (buffering->stall_start)
+    {
+        gint64 stall_us = g_get_monotonic_time() - buffering->stall_start;
+
+        stats->stall_time_us += stall_us;
+        stats->longest_stall_us = MAX(stats->longest_stall_us, stall_us);
+    }
+    g_mutex_unlock(&buffering->lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_buffering_log_stats(player_instance_t *player_instance)
+{
+    player_buffering_stats_t stats;
+
+    if (player_buffering_get_stats(player_instance, &stats) != 0)
+        return;
+
+    I_LOG_INFO("========== Buffering [%s] ==========\n", player_instance->player_name);
+    I_LOG_INFO("initial fill %" G_GINT64_FORMAT " ms, %" G_GUINT64_FORMAT " stalls for %" G_GINT64_FORMAT " ms (longest %" G_GINT64_FORMAT " ms), lowest level %d %%\n",
+            (stats.initial_us >= 0) ? stats.initial_us / 1000 : -1, stats.stalls, stats.stall_time_us / 1000,
+            stats.longest_stall_us / 1000, stats.min_percent);
+    return;
+}
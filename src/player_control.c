@@ -0,0 +1,756 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <player.h>
+#include <player_control.h>
+#include <player_seek.h>
+#include <player_trick.h>
+#include <player_dispatch.h>
+#include <dispmanx_window.h>
+
+/* Control server.
+ * A listening socket and one socket per client, all non blocking and
+ * watched on the main context. Whatever a read returns is appended to the
+ * client's input and every complete frame in it is pushed to the command
+ * dispatcher in order, malformed ones too so their replies keep their place.
+ * The replies are appended to the client's output as the commands complete
+ * and written once the socket takes them. A client with too many commands
+ * in flight or too many unsent replies is not read until they drain.*/
+
+G_STATIC_ASSERT (sizeof(player_control_header_t) == 12);
+G_STATIC_ASSERT (sizeof(player_control_ack_t) == 16);
+
+#define S_CONTROL_READ_SIZE 4096
+
+/* dispatch data of every command*/
+typedef struct
+{
+    guint client_id;
+    gboolean binary;
+    uint8_t op;
+    uint32_t seq;
+    gchar *seq_text;
+    gboolean ran;           /* status is the command's own, not that of the one it was merged into*/
+    player_control_status_e status;
+    gint32 value;
+    GString *detail;
+}player_control_reply_t;
+
+typedef struct
+{
+    gint fd;
+    guint id;
+    GIOChannel *channel;
+    guint in_id;
+    guint out_id;
+    GByteArray *in;
+    GByteArray *out;
+    guint in_flight;        /* pushed, not completed*/
+    gboolean closing;       /* protocol error, close once the replies are out*/
+    gboolean eof;           /* nothing more to read, close once the replies are out*/
+    gboolean processing;    /* inside s_control_client_process*/
+}player_control_client_t;
+
+typedef struct
+{
+    gint fd;
+    gchar *path;
+    GIOChannel *channel;
+    guint accept_id;
+    GList *clients;
+    guint next_client_id;
+    uint32_t default_handle;
+    player_control_stats_t stats;
+}player_control_t;
+
+typedef struct
+{
+    const gchar *name;
+    player_control_op_e op;
+    guint n_args;
+    player_dispatch_merge_e merge;  /* with the same command for the same player right before it*/
+}player_control_name_t;
+
+static const player_control_name_t s_control_names[] =
+{
+    { "play", PLAYER_CONTROL_OP_PLAY, 0, PLAYER_DISPATCH_MERGE_NONE },
+    { "pause", PLAYER_CONTROL_OP_PAUSE, 0, PLAYER_DISPATCH_MERGE_LAST },
+    { "resume", PLAYER_CONTROL_OP_RESUME, 0, PLAYER_DISPATCH_MERGE_LAST },
+    { "toggle", PLAYER_CONTROL_OP_TOGGLE_PAUSE, 0, PLAYER_DISPATCH_MERGE_TOGGLE },
+    { "stop", PLAYER_CONTROL_OP_STOP, 0, PLAYER_DISPATCH_MERGE_LAST },
+    { "seek", PLAYER_CONTROL_OP_SEEK, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "skip", PLAYER_CONTROL_OP_SKIP, 1, PLAYER_DISPATCH_MERGE_SUM },
+    { "rate", PLAYER_CONTROL_OP_RATE, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "volume", PLAYER_CONTROL_OP_VOLUME, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "volume-step", PLAYER_CONTROL_OP_VOLUME_STEP, 1, PLAYER_DISPATCH_MERGE_SUM },
+    { "fullscreen", PLAYER_CONTROL_OP_FULLSCREEN, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "move", PLAYER_CONTROL_OP_MOVE, 2, PLAYER_DISPATCH_MERGE_SUM },
+    { "aspect", PLAYER_CONTROL_OP_ASPECT, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "background", PLAYER_CONTROL_OP_BACKGROUND, 1, PLAYER_DISPATCH_MERGE_LAST },
+    { "uri", PLAYER_CONTROL_OP_URI, 0, PLAYER_DISPATCH_MERGE_LAST },
+    { "list", PLAYER_CONTROL_OP_LIST, 0, PLAYER_DISPATCH_MERGE_NONE }
+};
+
+static const gchar *s_control_aspect_names[] =
+{
+    NULL, "original", "stretch", "letterbox", "pillarbox", "crop", "zoom"
+};
+
+static const gchar *s_control_status_names[] =
+{
+    "ok", "failed", "no-player", "bad-command"
+};
+
+static player_control_t s_control = { -1, NULL, NULL, 0, NULL, 0, 0, { 0 } };
+
+static gboolean s_control_client_cb(GIOChannel *source, GIOCondition condition, gpointer user_data);
+static gboolean s_control_client_out_cb(GIOChannel *source, GIOCondition condition, gpointer user_data);
+static void s_control_client_process(player_control_client_t *client);
+static gboolean s_control_client_flush(player_control_client_t *client);
+
+/* ********** All Static Functions Defined Here ***********/
+
+static gboolean s_control_is_windowed(player_instance_t *player_instance)
+{
+    return (player_instance->headless == NULL && player_instance->frames == NULL);
+}
+
+static gboolean s_control_client_backed_up(player_control_client_t *client)
+{
+    return (client->out->len >= PLAYER_CONTROL_MAX_PENDING || client->in_flight >= PLAYER_CONTROL_MAX_IN_FLIGHT);
+}
+
+static player_control_status_e s_control_execute(player_instance_t *player_instance, const player_dispatch_command_t *command,
+        gint32 *value, GString *detail)
+{
+    uint32_t handles[PLAYER_MAX_INSTANCES];
+    gdouble volume = 0.0;
+    guint count, i;
+    int8_t result = 0;
+
+    if (command->kind == PLAYER_CONTROL_OP_LIST)
+    {
+        count = player_manager_get_handles(handles, PLAYER_MAX_INSTANCES);
+        for (i = 0; i < count && detail; i++)
+            g_string_append_printf(detail, (i) ? ",%u" : "%u", handles[i]);
+        *value = (gint32)count;
+        return PLAYER_CONTROL_OK;
+    }
+
+    if (player_instance == NULL)
+        return PLAYER_CONTROL_NO_PLAYER;
+
+    switch (command->kind)
+    {
+        case PLAYER_CONTROL_OP_PLAY:
+            result = player_play(player_instance);
+            break;
+        case PLAYER_CONTROL_OP_PAUSE:
+            if (player_instance->desired_state == GST_STATE_PLAYING)
+                result = player_toggle_pause(player_instance);
+            break;
+        case PLAYER_CONTROL_OP_RESUME:
+            if (player_instance->desired_state != GST_STATE_PLAYING)
+                result = player_toggle_pause(player_instance);
+            break;
+        case PLAYER_CONTROL_OP_TOGGLE_PAUSE:
+            result = player_toggle_pause(player_instance);
+            break;
+        case PLAYER_CONTROL_OP_STOP:
+            result = player_stop(player_instance);
+            break;
+        case PLAYER_CONTROL_OP_SEEK:
+            result = player_seek_to(player_instance, command->args[0] * (gint64)GST_MSECOND);
+            break;
+        case PLAYER_CONTROL_OP_SKIP:
+            result = player_seek_relative(player_instance, command->args[0] * (gint64)GST_MSECOND);
+            break;
+        case PLAYER_CONTROL_OP_RATE:
+            if (command->args[0] == 0)
+                return PLAYER_CONTROL_BAD_COMMAND;
+            result = player_set_rate(player_instance, (gdouble)command->args[0] / 1000.0);
+            break;
+        case PLAYER_CONTROL_OP_VOLUME:
+        case PLAYER_CONTROL_OP_VOLUME_STEP:
+            if (command->kind == PLAYER_CONTROL_OP_VOLUME)
+                g_object_get (player_instance->player, "volume", &volume, NULL);
+            play_set_relative_volume(player_instance, ((gdouble)command->args[0] / 100.0) - volume);
+            break;
+        case PLAYER_CONTROL_OP_FULLSCREEN:
+            if (!s_control_is_windowed(player_instance))
+                return PLAYER_CONTROL_FAILED;
+            dispmanx_win_set_fullscreen(&player_instance->vid_win, (command->args[0] != 0));
+            break;
+        case PLAYER_CONTROL_OP_MOVE:
+            if (!s_control_is_windowed(player_instance) || player_instance->vid_win.in_fullscreen)
+                return PLAYER_CONTROL_FAILED;
+            dispmanx_win_move(&player_instance->vid_win, (gint)command->args[0], (gint)command->args[1]);
+            break;
+        case PLAYER_CONTROL_OP_ASPECT:
+            if (command->args[0] < PLAYER_AR_ORIGINAL || command->args[0] > PLAYER_AR_ZOOM)
+                return PLAYER_CONTROL_BAD_COMMAND;
+            if (!s_control_is_windowed(player_instance))
+                return PLAYER_CONTROL_FAILED;
+            dispmanx_win_set_aspect_ratio(player_instance, (dispmanx_player_aspect_ratio_e)command->args[0]);
+            break;
+        case PLAYER_CONTROL_OP_BACKGROUND:
+            if (!s_control_is_windowed(player_instance))
+                return PLAYER_CONTROL_FAILED;
+            dispmanx_win_show_background_element(&player_instance->bg, (command->args[0] != 0));
+            break;
+        case PLAYER_CONTROL_OP_URI:
+            if (command->text == NULL || command->text[0] == '\0')
+                return PLAYER_CONTROL_BAD_COMMAND;
+            /* the old uri is retired, the streaming thread may still read it*/
+            if (player_playlist_set_uri(player_instance, command->text) != 0)
+                return PLAYER_CONTROL_FAILED;
+            result = player_play(player_instance);
+            break;
+        default:
+            return PLAYER_CONTROL_BAD_COMMAND;
+    }
+
+    *value = 0;
+    return (result == 0) ? PLAYER_CONTROL_OK : PLAYER_CONTROL_FAILED;
+}
+
+static player_control_client_t *s_control_find_client(guint client_id)
+{
+    GList *item = NULL;
+
+    for (item = s_control.clients; item; item = item->next)
+    {
+        if (((player_control_client_t *) item->data)->id == client_id)
+            return (player_control_client_t *) item->data;
+    }
+    return NULL;
+}
+
+static void s_control_reply_free(gpointer data)
+{
+    player_control_reply_t *reply = (player_control_reply_t *) data;
+
+    g_free(reply->seq_text);
+    if (reply->detail)
+        g_string_free(reply->detail, TRUE);
+    g_free(reply);
+    return;
+}
+
+/* player context, for the command standing for its run*/
+static int8_t s_control_exec_cb(player_instance_t *player_instance, player_dispatch_command_t *command)
+{
+    player_control_reply_t *reply = (player_control_reply_t *) command->data;
+
+    reply->status = s_control_execute(player_instance, command, &reply->value, reply->detail);
+    reply->ran = TRUE;
+    return (reply->status == PLAYER_CONTROL_OK) ? 0 : -1;
+}
+
+/* player context, in push order*/
+static void s_control_done_cb(player_dispatch_command_t *command, int8_t result, gint64 latency_us)
+{
+    player_control_reply_t *reply = (player_control_reply_t *) command->data;
+    player_control_client_t *client = s_control_find_client(reply->client_id);
+    player_control_ack_t ack;
+    gchar *text = NULL;
+
+    if (!reply->ran)
+        reply->status = (result == 0) ? PLAYER_CONTROL_OK : PLAYER_CONTROL_FAILED;
+
+    s_control.stats.commands++;
+    if (reply->status != PLAYER_CONTROL_OK)
+        s_control.stats.errors++;
+    s_control.stats.latency_total_us += latency_us;
+    s_control.stats.latency_max_us = MAX(s_control.stats.latency_max_us, latency_us);
+
+    /* gone meanwhile*/
+    if (client == NULL)
+        return;
+
+    client->in_flight--;
+    if (reply->binary)
+    {
+        ack.magic = PLAYER_CONTROL_MAGIC;
+        ack.op = reply->op;
+        ack.status = (uint8_t)reply->status;
+        ack.reserved = 0;
+        ack.seq = GUINT32_TO_LE(reply->seq);
+        ack.latency_us = GUINT32_TO_LE((uint32_t)MIN(latency_us, (gint64)G_MAXUINT32));
+        ack.value = GINT32_TO_LE(reply->value);
+        g_byte_array_append(client->out, (const guint8 *)&ack, sizeof(ack));
+    }
+    else
+    {
+        text = g_strdup_printf("%s %s %" G_GINT64_FORMAT "%s%s\n", reply->seq_text, s_control_status_names[reply->status], latency_us,
+                (reply->detail && reply->detail->len) ? " " : "", (reply->detail) ? reply->detail->str : "");
+        g_byte_array_append(client->out, (const guint8 *)text, (guint)strlen(text));
+        g_free(text);
+    }
+
+    /* completed right away by a dispatcher which is not running, the caller flushes*/
+    if (client->processing)
+        return;
+
+    /* input held back for the commands in flight*/
+    if (!s_control_client_backed_up(client) && client->in->len && !client->closing)
+        s_control_client_process(client);
+    s_control_client_flush(client);
+    return;
+}
+
+/* Takes reply, the command keeps its place in the order even when it is malformed (exec NULL)*/
+static void s_control_push(player_control_client_t *client, player_dispatch_command_t *command, player_control_reply_t *reply)
+{
+    if (command == NULL)
+        command = player_dispatch_command_new(0, 0, PLAYER_DISPATCH_MERGE_NONE, NULL);
+    if (command->exec == NULL)
+    {
+        reply->status = PLAYER_CONTROL_BAD_COMMAND;
+        reply->ran = TRUE;
+    }
+    if (command->handle == 0)
+        command->handle = s_control.default_handle;
+
+    reply->client_id = client->id;
+    command->data = reply;
+    command->data_free = s_control_reply_free;
+    command->done = s_control_done_cb;
+    /* stamped as its frame is parsed, a pipelined command does not inherit the wait of the ones before it*/
+    command->queued_time = g_get_monotonic_time();
+    client->in_flight++;
+    player_dispatch_push(command);
+    return;
+}
+
+/* "<seq> <handle> <command> [args]", the line is modified*/
+static void s_control_handle_line(player_control_client_t *client, gchar *line)
+{
+    player_dispatch_command_t *command = NULL;
+    player_control_reply_t *reply = NULL;
+    const player_control_name_t *name = NULL;
+    gchar *tokens[3 + PLAYER_CONTROL_MAX_ARGS];
+    gchar *cursor = line, *end = NULL;
+    guint n_tokens = 0, i, ar;
+    uint32_t handle;
+
+    while (n_tokens < G_N_ELEMENTS(tokens) && *cursor)
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+            cursor++;
+        if (*cursor == '\0')
+            break;
+        tokens[n_tokens++] = cursor;
+        /* the uri is the rest of the line*/
+        if (n_tokens == 4 && g_strcmp0(tokens[2], "uri") == 0)
+            break;
+        while (*cursor && *cursor != ' ' && *cursor != '\t')
+            cursor++;
+        if (*cursor)
+            *cursor++ = '\0';
+    }
+    if (n_tokens == 0)
+        return;
+
+    reply = g_new0(player_control_reply_t, 1);
+    reply->seq_text = g_strdup(tokens[0]);
+    if (n_tokens < 3)
+        goto push;
+
+    handle = (uint32_t)g_ascii_strtoull(tokens[1], &end, 10);
+    if (*end != '\0')
+        goto push;
+    for (i = 0; i < G_N_ELEMENTS(s_control_names) && name == NULL; i++)
+    {
+        if (g_strcmp0(tokens[2], s_control_names[i].name) == 0)
+            name = &s_control_names[i];
+    }
+    if (name == NULL || n_tokens - 3 < name->n_args)
+        goto push;
+
+    command = player_dispatch_command_new(handle, name->op, name->merge, s_control_exec_cb);
+    if (name->op == PLAYER_CONTROL_OP_URI && n_tokens == 4)
+        command->text = g_strdup(tokens[3]);
+    if (name->op == PLAYER_CONTROL_OP_LIST)
+        reply->detail = g_string_new(NULL);
+    for (i = 0; i < name->n_args; i++)
+    {
+        if (name->op == PLAYER_CONTROL_OP_RATE)
+            command->args[i] = (gint64)(g_ascii_strtod(tokens[3 + i], &end) * 1000.0);
+        else if (name->op == PLAYER_CONTROL_OP_ASPECT && !g_ascii_isdigit(tokens[3 + i][0]))
+        {
+            for (ar = PLAYER_AR_ORIGINAL; ar < G_N_ELEMENTS(s_control_aspect_names); ar++)
+            {
+                if (g_ascii_strcasecmp(tokens[3 + i], s_control_aspect_names[ar]) == 0)
+                    command->args[i] = ar;
+            }
+            end = tokens[3 + i] + strlen(tokens[3 + i]);
+        }
+        else
+            command->args[i] = g_ascii_strtoll(tokens[3 + i], &end, 10);
+        /* replied to as a bad command, in its place*/
+        if (*end != '\0')
+            command->exec = NULL;
+    }
+
+push:
+    s_control_push(client, command, reply);
+    return;
+}
+
+/* header and payload are complete*/
+static void s_control_handle_binary(player_control_client_t *client, const guint8 *frame)
+{
+    player_dispatch_command_t *command = NULL;
+    player_control_reply_t *reply = g_new0(player_control_reply_t, 1);
+    const player_control_name_t *name = NULL;
+    player_control_header_t header;
+    const guint8 *payload = frame + sizeof(header);
+    guint length, i;
+    int32_t arg;
+
+    memcpy(&header, frame, sizeof(header));
+    length = GUINT16_FROM_LE(header.length);
+    reply->binary = TRUE;
+    reply->op = header.op;
+    reply->seq = GUINT32_FROM_LE(header.seq);
+
+    for (i = 0; i < G_N_ELEMENTS(s_control_names) && name == NULL; i++)
+    {
+        if (s_control_names[i].op == (player_control_op_e)header.op)
+            name = &s_control_names[i];
+    }
+    if (name == NULL || length < name->n_args * sizeof(int32_t))
+        goto push;
+
+    command = player_dispatch_command_new(GUINT32_FROM_LE(header.handle), name->op, name->merge, s_control_exec_cb);
+    if (name->op == PLAYER_CONTROL_OP_URI)
+        command->text = g_strndup((const gchar *)payload, length);
+    for (i = 0; i < name->n_args; i++)
+    {
+        memcpy(&arg, payload + (i * sizeof(int32_t)), sizeof(int32_t));
+        command->args[i] = (gint32)GINT32_FROM_LE(arg);
+    }
+
+push:
+    s_control_push(client, command, reply);
+    return;
+}
+
+static void s_control_client_close(player_control_client_t *client)
+{
+    I_LOG_DEBUG("Control client %u closed\n", client->id);
+    s_control.clients = g_list_remove(s_control.clients, client);
+    if (client->in_id)
+        g_source_remove(client->in_id);
+    if (client->out_id)
+        g_source_remove(client->out_id);
+    g_io_channel_unref(client->channel);
+    close(client->fd);
+    g_byte_array_free(client->in, TRUE);
+    g_byte_array_free(client->out, TRUE);
+    g_free(client);
+    return;
+}
+
+/* Every complete frame in the input, in order, until the client backs up*/
+static void s_control_client_process(player_control_client_t *client)
+{
+    player_control_header_t header;
+    guint offset = 0, length;
+    guint8 *newline = NULL;
+
+    client->processing = TRUE;
+    while (offset < client->in->len && !client->closing && !s_control_client_backed_up(client))
+    {
+        guint8 *frame = client->in->data + offset;
+        guint available = client->in->len - offset;
+
+        if (frame[0] == PLAYER_CONTROL_MAGIC)
+        {
+            if (available < sizeof(header))
+                break;
+            memcpy(&header, frame, sizeof(header));
+            length = (guint)sizeof(header) + GUINT16_FROM_LE(header.length);
+            if (GUINT16_FROM_LE(header.length) > PLAYER_CONTROL_MAX_FRAME)
+            {
+                client->closing = TRUE;
+                break;
+            }
+            if (available < length)
+                break;
+            s_control_handle_binary(client, frame);
+        }
+        else
+        {
+            newline = memchr(frame, '\n', available);
+            if (newline == NULL)
+            {
+                if (available > PLAYER_CONTROL_MAX_FRAME)
+                    client->closing = TRUE;
+                break;
+            }
+            length = (guint)(newline - frame) + 1;
+            *newline = '\0';
+            if (newline > frame && newline[-1] == '\r')
+                newline[-1] = '\0';
+            s_control_handle_line(client, (gchar *)frame);
+        }
+        offset += length;
+    }
+
+    if (offset)
+        g_byte_array_remove_range(client->in, 0, offset);
+    client->processing = FALSE;
+    if (client->closing)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Control client %u sent an oversized frame, closing !!!!!!!!!!\n", client->id);
+        s_control.stats.protocol_errors++;
+    }
+    return;
+}
+
+/* Writes what the socket takes, the rest waits for G_IO_OUT. FALSE once the client is gone*/
+static gboolean s_control_client_flush(player_control_client_t *client)
+{
+    ssize_t written;
+
+    while (client->out->len)
+    {
+        written = send(client->fd, client->out->data, client->out->len, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (written <= 0)
+        {
+            s_control_client_close(client);
+            return FALSE;
+        }
+        g_byte_array_remove_range(client->out, 0, (guint)written);
+    }
+
+    /* a partial frame left after the peer stopped sending can not complete*/
+    if ((client->closing || client->eof) && client->out->len == 0 && client->in_flight == 0)
+    {
+        s_control_client_close(client);
+        return FALSE;
+    }
+    if (client->out->len && client->out_id == 0)
+        client->out_id = g_io_add_watch(client->channel, G_IO_OUT | G_IO_HUP | G_IO_ERR, s_control_client_out_cb, client);
+
+    /* not read while backed up*/
+    if (s_control_client_backed_up(client) || client->closing || client->eof)
+    {
+        if (client->in_id)
+            g_source_remove(client->in_id);
+        client->in_id = 0;
+    }
+    else if (client->in_id == 0)
+        client->in_id = g_io_add_watch(client->channel, G_IO_IN | G_IO_HUP | G_IO_ERR, s_control_client_cb, client);
+    return TRUE;
+}
+
+static gboolean s_control_client_out_cb(GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    player_control_client_t *client = (player_control_client_t *) user_data;
+
+    client->out_id = 0;
+    if (condition & (G_IO_HUP | G_IO_ERR))
+    {
+        s_control_client_close(client);
+        return FALSE;
+    }
+    if (!s_control_client_flush(client))
+        return FALSE;
+
+    /* input held back by the replies*/
+    if (!s_control_client_backed_up(client) && client->in->len && !client->closing)
+    {
+        s_control_client_process(client);
+        s_control_client_flush(client);
+    }
+    return FALSE;
+}
+
+static gboolean s_control_client_cb(GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    player_control_client_t *client = (player_control_client_t *) user_data;
+    guint8 buffer[S_CONTROL_READ_SIZE];
+    gboolean hung_up = FALSE;
+    ssize_t count;
+
+    /* everything waiting, so a burst of pipelined commands is one wakeup*/
+    for (;;)
+    {
+        count = recv(client->fd, buffer, sizeof(buffer), 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count > 0)
+        {
+            g_byte_array_append(client->in, buffer, (guint)count);
+            if (client->in->len > 4 * PLAYER_CONTROL_MAX_PENDING)
+                break;
+            continue;
+        }
+        hung_up = (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK));
+        break;
+    }
+
+    /* replies still go out after the peer shut its side down*/
+    client->eof = hung_up;
+    s_control_client_process(client);
+
+    if (!s_control_client_flush(client))
+        return FALSE;
+    /* flush removed this watch*/
+    return (client->in_id != 0);
+}
+
+static gboolean s_control_accept_cb(GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    player_control_client_t *client = NULL;
+    gint fd;
+
+    while ((fd = accept4(s_control.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        if (g_list_length(s_control.clients) >= PLAYER_CONTROL_MAX_CLIENTS)
+        {
+            I_LOG_WARNING("!!!!!!!!!! Control client refused [max %d] !!!!!!!!!!\n", PLAYER_CONTROL_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+
+        client = g_new0(player_control_client_t, 1);
+        client->fd = fd;
+        client->id = ++s_control.next_client_id;
+        client->in = g_byte_array_new();
+        client->out = g_byte_array_new();
+        client->channel = g_io_channel_unix_new(fd);
+        client->in_id = g_io_add_watch(client->channel, G_IO_IN | G_IO_HUP | G_IO_ERR, s_control_client_cb, client);
+        s_control.clients = g_list_prepend(s_control.clients, client);
+        s_control.stats.clients++;
+        I_LOG_DEBUG("Control client %u connected\n", client->id);
+    }
+    return TRUE;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Listens on socket_path, a stale socket there is replaced. default_handle serves handle 0*/
+int8_t player_control_start(const char *socket_path, uint32_t default_handle)
+{
+    struct sockaddr_un address;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (socket_path != NULL && strlen(socket_path) < sizeof(address.sun_path)), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    if (s_control.fd >= 0)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Control Server Is Running Already !!!!!!!!!! %s\n", s_control.path);
+        goto safe_exit;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    g_strlcpy(address.sun_path, socket_path, sizeof(address.sun_path));
+
+    s_control.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s_control.fd < 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Create Control Socket : %s xxxxxxxxxx\n", g_strerror(errno));
+        goto safe_exit;
+    }
+    unlink(socket_path);
+    if (bind(s_control.fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(s_control.fd, PLAYER_CONTROL_MAX_CLIENTS) != 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Listen On %s : %s xxxxxxxxxx\n", socket_path, g_strerror(errno));
+        close(s_control.fd);
+        s_control.fd = -1;
+        goto safe_exit;
+    }
+    /* the player is controlled by its own user only*/
+    chmod(socket_path, S_IRUSR | S_IWUSR);
+
+    s_control.path = g_strdup(socket_path);
+    s_control.default_handle = default_handle;
+    s_control.channel = g_io_channel_unix_new(s_control.fd);
+    s_control.accept_id = g_io_add_watch(s_control.channel, G_IO_IN, s_control_accept_cb, NULL);
+    I_LOG_INFO("========== Control server on %s ==========\n", socket_path);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* The player handle 0 stands for, e.g. after a pool switch*/
+void player_control_set_default(uint32_t handle)
+{
+    s_control.default_handle = handle;
+    return;
+}
+
+void player_control_stop(void)
+{
+    if (s_control.fd < 0)
+        return;
+
+    while (s_control.clients)
+        s_control_client_close((player_control_client_t *) s_control.clients->data);
+
+    g_source_remove(s_control.accept_id);
+    s_control.accept_id = 0;
+    g_io_channel_unref(s_control.channel);
+    s_control.channel = NULL;
+    close(s_control.fd);
+    s_control.fd = -1;
+    unlink(s_control.path);
+    g_free(s_control.path);
+    s_control.path = NULL;
+
+    if (s_control.stats.commands)
+        I_LOG_INFO("========== Control : %" G_GUINT64_FORMAT " clients, %" G_GUINT64_FORMAT " commands (%" G_GUINT64_FORMAT " failed), latency mean %" G_GINT64_FORMAT " us max %" G_GINT64_FORMAT " us ==========\n",
+                s_control.stats.clients, s_control.stats.commands, s_control.stats.errors,
+                s_control.stats.latency_total_us / (gint64)s_control.stats.commands, s_control.stats.latency_max_us);
+    return;
+}
+
+void player_control_get_stats(player_control_stats_t *stats)
+{
+    if (stats)
+        *stats = s_control.stats;
+    return;
+}
@@ -0,0 +1,318 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_dispatch.h>
+
+/* Vyukov's intrusive MPSC queue.
+ * Producers swap themselves in as the head and then link the previous head
+ * to themselves, the consumer walks from the tail. Between the swap and the
+ * link a producer has made the queue briefly look shorter than it is, the
+ * consumer then yields until the link is there. A stub node keeps the queue
+ * from ever being empty, so no pointer is shared by producer and consumer.
+ *
+ * Only the consumer touches tail, stats and the run being merged. The
+ * drains of the player context are the consumer, player_dispatch_shutdown
+ * takes over once that context is no longer run.*/
+
+typedef struct
+{
+    player_dispatch_command_t *head;    /* last pushed, producers*/
+    player_dispatch_command_t *tail;    /* next to pop, consumer*/
+    player_dispatch_command_t stub;
+    gint scheduled;                     /* a drain is pending on the context*/
+    GMainContext *context;
+    player_dispatch_stats_t stats;
+}player_dispatch_t;
+
+static player_dispatch_t s_dispatch;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static void s_dispatch_enqueue(player_dispatch_command_t *command)
+{
+    player_dispatch_command_t *previous = NULL;
+
+    g_atomic_pointer_set(&command->next, NULL);
+    do
+    {
+        previous = g_atomic_pointer_get(&s_dispatch.head);
+    } while (!g_atomic_pointer_compare_and_exchange(&s_dispatch.head, previous, command));
+    g_atomic_pointer_set(&previous->next, command);
+    return;
+}
+
+/* consumer only, NULL when empty*/
+static player_dispatch_command_t *s_dispatch_dequeue(void)
+{
+    player_dispatch_command_t *tail, *next;
+
+    for (;;)
+    {
+        tail = s_dispatch.tail;
+        next = g_atomic_pointer_get(&tail->next);
+        if (tail == &s_dispatch.stub)
+        {
+            if (next == NULL)
+            {
+                /* a producer may be between its swap and its link*/
+                if (g_atomic_pointer_get(&s_dispatch.head) == tail)
+                    return NULL;
+                g_thread_yield();
+                continue;
+            }
+            s_dispatch.tail = next;
+            tail = next;
+            next = g_atomic_pointer_get(&next->next);
+        }
+        if (next)
+        {
+            s_dispatch.tail = next;
+            return tail;
+        }
+        if (g_atomic_pointer_get(&s_dispatch.head) != tail)
+        {
+            g_thread_yield();
+            continue;
+        }
+
+        /* tail is the last one, the stub goes behind it so it can be taken*/
+        s_dispatch_enqueue(&s_dispatch.stub);
+        next = g_atomic_pointer_get(&tail->next);
+        if (next)
+        {
+            s_dispatch.tail = next;
+            return tail;
+        }
+        g_thread_yield();
+    }
+}
+
+static void s_dispatch_command_free(player_dispatch_command_t *command)
+{
+    if (command->data_free)
+        command->data_free(command->data);
+    g_free(command->text);
+    g_free(command);
+    return;
+}
+
+static gboolean s_dispatch_can_merge(const player_dispatch_command_t *run, const player_dispatch_command_t *command)
+{
+    return (run->merge != PLAYER_DISPATCH_MERGE_NONE && run->merge == command->merge &&
+            run->kind == command->kind && run->handle == command->handle);
+}
+
+/* Runs the command standing for the run, then completes all of them in push order*/
+static void s_dispatch_run(player_dispatch_command_t *run, player_dispatch_command_t *last, guint length)
+{
+    player_dispatch_command_t *command = NULL, *next = NULL;
+    player_instance_t *player_instance = (run->handle) ? player_manager_lookup(run->handle) : NULL;
+    int8_t result = 0;
+    gint64 now, latency;
+
+    switch (run->merge)
+    {
+        case PLAYER_DISPATCH_MERGE_LAST:
+            command = last;
+            break;
+        case PLAYER_DISPATCH_MERGE_TOGGLE:
+            command = (length % 2) ? run : NULL;
+            break;
+        default:
+            command = run;
+            break;
+    }
+
+    if (command && command->exec)
+    {
+        result = command->exec(player_instance, command);
+        s_dispatch.stats.executed++;
+    }
+    s_dispatch.stats.merged += length - ((command) ? 1 : 0);
+
+    now = g_get_monotonic_time();
+    for (command = run; command; command = next)
+    {
+        next = command->run_next;
+        latency = now - command->queued_time;
+        s_dispatch.stats.latency_total_us += latency;
+        s_dispatch.stats.latency_max_us = MAX(s_dispatch.stats.latency_max_us, latency);
+        if (command->done)
+            command->done(command, result, latency);
+        s_dispatch_command_free(command);
+    }
+    return;
+}
+
+/* player context*/
+static gboolean s_dispatch_drain_cb(gpointer user_data)
+{
+    player_dispatch_command_t *command = NULL, *run = NULL, *last = NULL;
+    guint length = 0, batch = 0, i;
+
+    /* pushes from here on schedule another drain*/
+    g_atomic_int_set(&s_dispatch.scheduled, 0);
+    s_dispatch.stats.drains++;
+
+    while (batch < PLAYER_DISPATCH_MAX_BATCH && (command = s_dispatch_dequeue()) != NULL)
+    {
+        batch++;
+        command->run_next = NULL;
+        if (run && s_dispatch_can_merge(run, command))
+        {
+            if (run->merge == PLAYER_DISPATCH_MERGE_SUM)
+            {
+                for (i = 0; i < PLAYER_DISPATCH_MAX_ARGS; i++)
+                    run->args[i] += command->args[i];
+            }
+            last->run_next = command;
+            last = command;
+            length++;
+            continue;
+        }
+
+        if (run)
+            s_dispatch_run(run, last, length);
+        run = last = command;
+        length = 1;
+    }
+    if (run)
+        s_dispatch_run(run, last, length);
+
+    s_dispatch.stats.pushed += batch;
+    s_dispatch.stats.max_batch = MAX(s_dispatch.stats.max_batch, batch);
+
+    /* a flood is handled a batch per iteration, the other sources still run in between*/
+    return (batch == PLAYER_DISPATCH_MAX_BATCH) ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Commands run on context, the player context*/
+void player_dispatch_init(GMainContext *context)
+{
+    if (s_dispatch.context)
+        return;
+
+    s_dispatch.stub.next = NULL;
+    s_dispatch.head = &s_dispatch.stub;
+    s_dispatch.tail = &s_dispatch.stub;
+    s_dispatch.scheduled = 0;
+    s_dispatch.context = g_main_context_ref(context);
+    return;
+}
+
+/* Once the player context is no longer run, commands still queued are completed with -1*/
+void player_dispatch_shutdown(void)
+{
+    player_dispatch_command_t *command = NULL;
+
+    if (s_dispatch.context == NULL)
+        return;
+
+    while ((command = s_dispatch_dequeue()) != NULL)
+    {
+        s_dispatch.stats.pushed++;
+        if (command->done)
+            command->done(command, -1, g_get_monotonic_time() - command->queued_time);
+        s_dispatch_command_free(command);
+    }
+
+    player_dispatch_log_stats();
+    g_main_context_unref(s_dispatch.context);
+    s_dispatch.context = NULL;
+    return;
+}
+
+/* Zeroed command, fill in args, text, done and data before pushing*/
+player_dispatch_command_t *player_dispatch_command_new(uint32_t handle, guint kind, player_dispatch_merge_e merge, player_dispatch_exec_cb exec)
+{
+    player_dispatch_command_t *command = g_new0(player_dispatch_command_t, 1);
+
+    command->handle = handle;
+    command->kind = kind;
+    command->merge = merge;
+    command->exec = exec;
+    return command;
+}
+
+/* Any thread, the dispatcher owns the command from here on*/
+void player_dispatch_push(player_dispatch_command_t *command)
+{
+    GSource *source = NULL;
+
+    if (command == NULL)
+        return;
+
+    if (s_dispatch.context == NULL)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Dispatcher Not Initialized, command dropped !!!!!!!!!!\n");
+        if (command->done)
+            command->done(command, -1, 0);
+        s_dispatch_command_free(command);
+        return;
+    }
+
+    if (command->queued_time == 0)
+        command->queued_time = g_get_monotonic_time();
+    s_dispatch_enqueue(command);
+
+    /* one wakeup per burst*/
+    if (g_atomic_int_compare_and_exchange(&s_dispatch.scheduled, 0, 1))
+    {
+        source = g_idle_source_new();
+        g_source_set_priority(source, G_PRIORITY_DEFAULT);
+        g_source_set_callback(source, s_dispatch_drain_cb, NULL, NULL);
+        g_source_attach(source, s_dispatch.context);
+        g_source_unref(source);
+    }
+    return;
+}
+
+void player_dispatch_get_stats(player_dispatch_stats_t *stats)
+{
+    if (stats)
+        *stats = s_dispatch.stats;
+    return;
+}
+
+void player_dispatch_log_stats(void)
+{
+    player_dispatch_stats_t *stats = &s_dispatch.stats;
+
+    if (stats->pushed == 0)
+        return;
+
+    I_LOG_INFO("========== Dispatcher : %" G_GUINT64_FORMAT " commands, %" G_GUINT64_FORMAT " run, %" G_GUINT64_FORMAT " merged, %" G_GUINT64_FORMAT " drains (largest %u) ==========\n",
+            stats->pushed, stats->executed, stats->merged, stats->drains, stats->max_batch);
+    I_LOG_INFO("push to done : mean %" G_GINT64_FORMAT " us, max %" G_GINT64_FORMAT " us\n",
+            stats->latency_total_us / (gint64)stats->pushed, stats->latency_max_us);
+    return;
+}
@@ -0,0 +1,302 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <dispmanx_window.h>
+#include <dispmanx_layout.h>
+#include <player_frames.h>
+
+struct player_frames
+{
+    GMutex lock;
+    player_instance_t *player_instance;
+    guint buffers;
+    GstElement *sink;
+    gulong new_sample_id;
+    dispmanx_frame_renderer_t *renderer;
+    dispmanx_frame_stats_t retired;     /* totals of renderers replaced on a size change*/
+    uint32_t width;                     /* size of the renderer*/
+    uint32_t height;
+    uint32_t want_width;                /* size of the last sample*/
+    uint32_t want_height;
+    uint32_t par_n;
+    uint32_t par_d;
+    guint build_source_id;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+static void s_frames_add_stats(dispmanx_frame_stats_t *total, const dispmanx_frame_stats_t *stats)
+{
+    total->frames_pushed += stats->frames_pushed;
+    total->frames_shown += stats->frames_shown;
+    total->frames_dropped += stats->frames_dropped;
+    total->frames_replaced += stats->frames_replaced;
+    total->frames_staged += stats->frames_staged;
+    total->bytes_copied += stats->bytes_copied;
+    total->copy_time_us += stats->copy_time_us;
+    total->copy_max_us = MAX(total->copy_max_us, stats->copy_max_us);
+    total->elapsed_us += stats->elapsed_us;
+    return;
+}
+
+static void s_frames_drop_renderer(struct player_frames *frames)
+{
+    dispmanx_frame_stats_t stats;
+
+    if (frames->renderer == NULL)
+        return;
+
+    dispmanx_frame_renderer_get_stats(frames->renderer, &stats);
+    s_frames_add_stats(&frames->retired, &stats);
+    dispmanx_frame_renderer_free(frames->renderer);
+    frames->renderer = NULL;
+    return;
+}
+
+/* player context, called with the lock held*/
+static gboolean s_frames_build_renderer(struct player_frames *frames, uint32_t width, uint32_t height)
+{
+    dispmanx_window_t *vid_win = &frames->player_instance->vid_win;
+    dispmanx_layout_source_t source;
+    dispmanx_layout_params_t params;
+    VC_RECT_T area, src_rect, dst_rect;
+    int32_t display_width = 0, display_height = 0;
+
+    dispmanx_get_display_size(&display_width, &display_height);
+    vc_dispmanx_rect_set(&area, 0, 0, (uint32_t)display_width, (uint32_t)display_height);
+    source.width = width;
+    source.height = height;
+    source.par_n = frames->par_n;
+    source.par_d = frames->par_d;
+    params.mode = (vid_win->ar) ? vid_win->ar : PLAYER_AR_ORIGINAL;
+    params.zoom = vid_win->zoom;
+    params.region = vid_win->custom_region;
+    if (dispmanx_layout_compute(&source, &area, &params, &src_rect, &dst_rect) == FALSE)
+        return FALSE;
+
+    frames->renderer = dispmanx_frame_renderer_new(vid_win->vid_layer, &dst_rect, VC_IMAGE_RGBA32, width, height, frames->buffers);
+    if (frames->renderer == NULL)
+        return FALSE;
+    dispmanx_frame_renderer_set_rects(frames->renderer, &dst_rect, &src_rect);
+
+    frames->width = width;
+    frames->height = height;
+
+    I_LOG_INFO("========== Frame upload %ux%u, %u buffers%s ==========\n", width, height, frames->buffers,
+            ((width * 4) % DISPMANX_FRAME_PITCH_ALIGN) ? ", staged for pitch alignment" : "");
+    return TRUE;
+}
+
+/* player context, element creation goes through the ordered update queue from here*/
+static gboolean s_frames_build_cb(gpointer user_data)
+{
+    struct player_frames *frames = (struct player_frames *) user_data;
+
+    g_mutex_lock(&frames->lock);
+    frames->build_source_id = 0;
+    if (frames->renderer == NULL || frames->width != frames->want_width || frames->height != frames->want_height)
+    {
+        s_frames_drop_renderer(frames);
+        if (s_frames_build_renderer(frames, frames->want_width, frames->want_height) == FALSE)
+            I_LOG_ERROR("xxxxxxxxxx Couldnt Create Frame Renderer %ux%u xxxxxxxxxx\n", frames->want_width, frames->want_height);
+    }
+    g_mutex_unlock(&frames->lock);
+    return G_SOURCE_REMOVE;
+}
+
+/* appsink streaming thread*/
+static GstFlowReturn s_frames_new_sample_cb(GstElement *appsink, gpointer user_data)
+{
+    struct player_frames *frames = (struct player_frames *) user_data;
+    GstSample *sample = NULL;
+    GstStructure *structure = NULL;
+    GstBuffer *buffer = NULL;
+    GstMapInfo map;
+    gint width = 0, height = 0, par_n = 1, par_d = 1;
+    int32_t pitch;
+
+    g_signal_emit_by_name (appsink, "pull-sample", &sample);
+    if (sample == NULL)
+        return GST_FLOW_EOS;
+
+    structure = gst_caps_get_structure (gst_sample_get_caps (sample), 0);
+    buffer = gst_sample_get_buffer (sample);
+    if (!gst_structure_get_int (structure, "width", &width) || !gst_structure_get_int (structure, "height", &height) ||
+            width <= 0 || height <= 0 || buffer == NULL)
+    {
+        gst_sample_unref (sample);
+        return GST_FLOW_OK;
+    }
+    gst_structure_get_fraction (structure, "pixel-aspect-ratio", &par_n, &par_d);
+    pitch = width * 4;
+
+    g_mutex_lock(&frames->lock);
+    if (frames->want_width != (uint32_t)width || frames->want_height != (uint32_t)height)
+    {
+        frames->want_width = (uint32_t)width;
+        frames->want_height = (uint32_t)height;
+        frames->par_n = (uint32_t)par_n;
+        frames->par_d = (uint32_t)par_d;
+    }
+    /* the renderer adds its element and flips through the update queue, which belongs to the player context*/
+    if ((frames->renderer == NULL || frames->width != frames->want_width || frames->height != frames->want_height) &&
+            frames->build_source_id == 0)
+        frames->build_source_id = g_idle_add (s_frames_build_cb, frames);
+
+    if (frames->renderer == NULL || frames->width != (uint32_t)width || frames->height != (uint32_t)height)
+    {
+        frames->retired.frames_pushed++;
+        frames->retired.frames_dropped++;
+    }
+    else if (gst_buffer_map (buffer, &map, GST_MAP_READ))
+    {
+        if (map.size >= (gsize)pitch * (gsize)height)
+            dispmanx_frame_renderer_push(frames->renderer, map.data, pitch);
+        gst_buffer_unmap (buffer, &map);
+    }
+    g_mutex_unlock(&frames->lock);
+
+    gst_sample_unref (sample);
+    return GST_FLOW_OK;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Called by player_get_frame_handler before the first play*/
+int8_t player_frames_setup(player_instance_t *player_instance, guint buffers)
+{
+    struct player_frames *frames = NULL;
+    GstElement *sink = NULL;
+    GstCaps *caps = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && player_instance->frames == NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    sink = gst_element_factory_make ("appsink", NULL);
+    if (sink == NULL)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Create appsink xxxxxxxxxx\n");
+        goto safe_exit;
+    }
+
+    /* playbin converts to the renderer's format, one queued sample is enough with the pool behind it*/
+    caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "RGBA", NULL);
+    g_object_set (sink, "caps", caps, "sync", TRUE, "max-buffers", 1, "emit-signals", TRUE, NULL);
+    gst_caps_unref (caps);
+
+    frames = g_new0(struct player_frames, 1);
+    g_mutex_init(&frames->lock);
+    frames->player_instance = player_instance;
+    frames->buffers = CLAMP(buffers, DISPMANX_FRAME_MIN_BUFFERS, DISPMANX_FRAME_MAX_BUFFERS);
+    frames->sink = gst_object_ref (sink);
+    frames->new_sample_id = g_signal_connect (sink, "new-sample", G_CALLBACK (s_frames_new_sample_cb), frames);
+
+    /* playbin takes the floating reference*/
+    g_object_set (player_instance->pipeline, "video-sink", sink, NULL);
+    player_instance->frames = frames;
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* The pipeline must be stopped, the renderer is freed once its element is off screen*/
+void player_frames_release(player_instance_t *player_instance)
+{
+    struct player_frames *frames = NULL;
+
+    if (player_instance == NULL || player_instance->frames == NULL)
+        return;
+
+    frames = player_instance->frames;
+    g_signal_handler_disconnect (frames->sink, frames->new_sample_id);
+    gst_object_unref (frames->sink);
+
+    g_mutex_lock(&frames->lock);
+    if (frames->build_source_id)
+        g_source_remove(frames->build_source_id);
+    frames->build_source_id = 0;
+    s_frames_drop_renderer(frames);
+    g_mutex_unlock(&frames->lock);
+    player_instance->frames = NULL;
+
+    g_mutex_clear(&frames->lock);
+    g_free(frames);
+    return;
+}
+
+/* Totals over every renderer of the player*/
+int8_t player_frames_get_stats(player_instance_t *player_instance, dispmanx_frame_stats_t *stats)
+{
+    struct player_frames *frames = NULL;
+    dispmanx_frame_stats_t current;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->frames != NULL && stats != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    frames = player_instance->frames;
+    g_mutex_lock(&frames->lock);
+    *stats = frames->retired;
+    if (frames->renderer)
+    {
+        dispmanx_frame_renderer_get_stats(frames->renderer, &current);
+        s_frames_add_stats(stats, &current);
+    }
+    g_mutex_unlock(&frames->lock);
+
+    stats->fps = (stats->elapsed_us > 0 && stats->frames_shown > 1) ?
+        ((gdouble)(stats->frames_shown - 1) * G_USEC_PER_SEC / (gdouble)stats->elapsed_us) : 0.0;
+    stats->copy_mb_per_s = (stats->copy_time_us > 0) ? ((gdouble)stats->bytes_copied / (gdouble)stats->copy_time_us) : 0.0;
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_frames_log_stats(player_instance_t *player_instance)
+{
+    dispmanx_frame_stats_t stats;
+
+    if (player_frames_get_stats(player_instance, &stats) != 0)
+        return;
+
+    I_LOG_INFO("========== Frame upload [%s] ==========\n", player_instance->player_name);
+    I_LOG_INFO("pushed %" G_GUINT64_FORMAT ", shown %" G_GUINT64_FORMAT " (%.1f fps), dropped %" G_GUINT64_FORMAT ", replaced %" G_GUINT64_FORMAT ", staged %" G_GUINT64_FORMAT "\n",
+            stats.frames_pushed, stats.frames_shown, stats.fps, stats.frames_dropped, stats.frames_replaced, stats.frames_staged);
+    I_LOG_INFO("copied %.1f MB at %.1f MB/s, average %.0f us max %" G_GUINT64_FORMAT " us per frame\n",
+            (gdouble)stats.bytes_copied / (1024 * 1024), stats.copy_mb_per_s,
+            (stats.frames_pushed > stats.frames_dropped) ? ((gdouble)stats.copy_time_us / (gdouble)(stats.frames_pushed - stats.frames_dropped)) : 0.0,
+            stats.copy_max_us);
+    return;
+}
@@ -0,0 +1,385 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_geometry.h>
+#include <dispmanx_window.h>
+#include <dispmanx_update.h>
+
+/* The probe runs on the streaming thread, the window is only touched on the
+ * player context. The apply source and every pending on screen notification
+ * hold a reference, so the struct outlives player_geometry_release until the
+ * display update it queued has completed.
+ * The first buffer after a change waits for the apply, bounded so that a
+ * context blocked on the pipeline (a state change to NULL) is never deadlocked.*/
+#define S_GEOMETRY_HOLD_US (50 * G_TIME_SPAN_MILLISECOND)
+
+struct player_geometry
+{
+    gint ref_count;
+    GMutex lock;
+    GCond applied;
+    player_instance_t *player_instance; /* NULL once released*/
+    GstElement *sink;
+    GstPad *pad;
+    gulong probe_id;
+    GSource *apply_source;      /* pending window change*/
+    guint64 caps_serial;        /* bumped by every change*/
+    guint64 applied_serial;     /* caps_serial the window was laid out for*/
+
+    /* latest caps, written by the probe*/
+    guint width;
+    guint height;
+    guint par_n;
+    guint par_d;
+    gint64 caps_time;
+
+    player_geometry_stats_t stats;
+};
+
+typedef struct
+{
+    struct player_geometry *geometry;
+    gint64 caps_time;
+}player_geometry_notify_t;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static struct player_geometry *s_geometry_ref(struct player_geometry *geometry)
+{
+    g_atomic_int_inc (&geometry->ref_count);
+    return geometry;
+}
+
+static void s_geometry_unref(gpointer data)
+{
+    struct player_geometry *geometry = (struct player_geometry *) data;
+
+    if (!g_atomic_int_dec_and_test (&geometry->ref_count))
+        return;
+    g_cond_clear(&geometry->applied);
+    g_mutex_clear(&geometry->lock);
+    g_free(geometry);
+    return;
+}
+
+/* update context, the change queued with this notification is on screen*/
+static void s_geometry_on_screen_cb(gpointer user_data)
+{
+    player_geometry_notify_t *notify = (player_geometry_notify_t *) user_data;
+    struct player_geometry *geometry = notify->geometry;
+    gint64 latency = g_get_monotonic_time() - notify->caps_time;
+
+    g_mutex_lock(&geometry->lock);
+    if (geometry->stats.first_caps_to_window_us < 0)
+        geometry->stats.first_caps_to_window_us = latency;
+    geometry->stats.last_caps_to_window_us = latency;
+    geometry->stats.total_caps_to_window_us += latency;
+    geometry->stats.max_caps_to_window_us = MAX(geometry->stats.max_caps_to_window_us, latency);
+    geometry->stats.changes_on_screen++;
+    g_mutex_unlock(&geometry->lock);
+
+    I_LOG_DEBUG("Window geometry on screen %" G_GINT64_FORMAT " us after caps\n", latency);
+    s_geometry_unref(geometry);
+    g_free(notify);
+    return;
+}
+
+/* player context*/
+static gboolean s_geometry_apply_cb(gpointer user_data)
+{
+    struct player_geometry *geometry = (struct player_geometry *) user_data;
+    player_instance_t *player_instance = NULL;
+    dispmanx_window_t *vid_win = NULL;
+    player_geometry_notify_t *notify = NULL;
+
+    g_mutex_lock(&geometry->lock);
+    if (geometry->apply_source)
+        g_source_unref (geometry->apply_source);
+    geometry->apply_source = NULL;
+    player_instance = geometry->player_instance;
+    if (player_instance == NULL)
+    {
+        g_mutex_unlock(&geometry->lock);
+        return G_SOURCE_REMOVE;
+    }
+
+    vid_win = &player_instance->vid_win;
+    if (vid_win->vid_width == geometry->width && vid_win->vid_height == geometry->height &&
+            vid_win->par_n == geometry->par_n && vid_win->par_d == geometry->par_d)
+    {
+        geometry->stats.unchanged++;
+        geometry->applied_serial = geometry->caps_serial;
+        g_cond_broadcast(&geometry->applied);
+        g_mutex_unlock(&geometry->lock);
+        return G_SOURCE_REMOVE;
+    }
+
+    I_LOG_DEBUG("Window geometry from caps : %ux%u par %u/%u ==> %ux%u par %u/%u\n",
+            vid_win->vid_width, vid_win->vid_height, vid_win->par_n, vid_win->par_d,
+            geometry->width, geometry->height, geometry->par_n, geometry->par_d);
+    vid_win->vid_width = geometry->width;
+    vid_win->vid_height = geometry->height;
+    vid_win->par_n = geometry->par_n;
+    vid_win->par_d = geometry->par_d;
+    geometry->stats.changes++;
+
+    notify = g_new0(player_geometry_notify_t, 1);
+    notify->geometry = s_geometry_ref(geometry);
+    notify->caps_time = geometry->caps_time;
+
+    /* source and destination rectangles in one update, queued before the held buffer is let through*/
+    dispmanx_update_begin();
+    dispmanx_win_set_fullscreen(vid_win, TRUE);
+    dispmanx_update_end();
+    geometry->applied_serial = geometry->caps_serial;
+    g_cond_broadcast(&geometry->applied);
+    g_mutex_unlock(&geometry->lock);
+
+    dispmanx_update_notify(s_geometry_on_screen_cb, notify);
+    return G_SOURCE_REMOVE;
+}
+
+/* streaming thread, called with the lock held*/
+static void s_geometry_set_caps(struct player_geometry *geometry, GstCaps *caps)
+{
+    GstStructure *structure = NULL;
+    gint width = 0, height = 0, par_n = 1, par_d = 1;
+
+    if (caps == NULL || gst_caps_get_size (caps) == 0)
+        return;
+
+    structure = gst_caps_get_structure (caps, 0);
+    if (!gst_structure_get_int (structure, "width", &width) || !gst_structure_get_int (structure, "height", &height) ||
+            width <= 0 || height <= 0)
+        return;
+    if (!gst_structure_get_fraction (structure, "pixel-aspect-ratio", &par_n, &par_d) || par_n <= 0 || par_d <= 0)
+        par_n = par_d = 1;
+
+    geometry->stats.caps_events++;
+    if (geometry->width == (guint)width && geometry->height == (guint)height &&
+            geometry->par_n == (guint)par_n && geometry->par_d == (guint)par_d)
+        return;
+
+    geometry->width = (guint)width;
+    geometry->height = (guint)height;
+    geometry->par_n = (guint)par_n;
+    geometry->par_d = (guint)par_d;
+    geometry->caps_time = g_get_monotonic_time();
+    geometry->caps_serial++;
+
+    /* a burst of caps before the context runs is applied once, with the last one*/
+    if (geometry->apply_source == NULL && geometry->player_instance)
+    {
+        geometry->apply_source = g_idle_source_new ();
+        g_source_set_priority (geometry->apply_source, G_PRIORITY_HIGH);
+        g_source_set_callback (geometry->apply_source, s_geometry_apply_cb, s_geometry_ref(geometry), s_geometry_unref);
+        g_source_attach (geometry->apply_source, g_main_context_default());
+    }
+    return;
+}
+
+/* streaming thread, the first buffer after a change waits until the window change is queued*/
+static void s_geometry_hold_buffer(struct player_geometry *geometry)
+{
+    gint64 deadline;
+
+    g_mutex_lock(&geometry->lock);
+    if (geometry->applied_serial != geometry->caps_serial && geometry->player_instance)
+    {
+        deadline = g_get_monotonic_time() + S_GEOMETRY_HOLD_US;
+        geometry->stats.buffers_held++;
+        while (geometry->applied_serial != geometry->caps_serial && geometry->player_instance)
+        {
+            if (!g_cond_wait_until (&geometry->applied, &geometry->lock, deadline))
+            {
+                geometry->stats.hold_timeouts++;
+                break;
+            }
+        }
+    }
+    g_mutex_unlock(&geometry->lock);
+    return;
+}
+
+static GstPadProbeReturn s_geometry_caps_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_geometry *geometry = (struct player_geometry *) user_data;
+    GstEvent *event = NULL;
+    GstCaps *caps = NULL;
+
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        s_geometry_hold_buffer(geometry);
+        return GST_PAD_PROBE_OK;
+    }
+
+    event = GST_PAD_PROBE_INFO_EVENT (info);
+    if (GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+        return GST_PAD_PROBE_OK;
+
+    gst_event_parse_caps (event, &caps);
+    g_mutex_lock(&geometry->lock);
+    s_geometry_set_caps(geometry, caps);
+    g_mutex_unlock(&geometry->lock);
+    return GST_PAD_PROBE_OK;
+}
+
+static void s_geometry_detach_sink(struct player_geometry *geometry)
+{
+    if (geometry->pad)
+    {
+        gst_pad_remove_probe (geometry->pad, geometry->probe_id);
+        gst_object_unref (geometry->pad);
+        geometry->pad = NULL;
+        geometry->probe_id = 0;
+    }
+    if (geometry->sink)
+    {
+        gst_object_unref (geometry->sink);
+        geometry->sink = NULL;
+    }
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+int8_t player_geometry_setup(player_instance_t *player_instance)
+{
+    struct player_geometry *geometry = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->headless == NULL && player_instance->frames == NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    ret_status = 0;
+    if (player_instance->geometry)
+        goto safe_exit;
+
+    geometry = g_new0(struct player_geometry, 1);
+    geometry->ref_count = 1;
+    g_mutex_init(&geometry->lock);
+    g_cond_init(&geometry->applied);
+    geometry->player_instance = player_instance;
+    geometry->stats.first_caps_to_window_us = -1;
+    player_instance->geometry = geometry;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Any thread, the sink may be replaced when playbin rebuilds its sinks*/
+void player_geometry_attach_sink(player_instance_t *player_instance, GstElement *video_sink)
+{
+    struct player_geometry *geometry = NULL;
+    GstPad *pad = NULL;
+
+    if (player_instance == NULL || player_instance->geometry == NULL || video_sink == NULL)
+        return;
+
+    geometry = player_instance->geometry;
+    if (geometry->sink == video_sink)
+        return;
+
+    pad = gst_element_get_static_pad (video_sink, "sink");
+    if (pad == NULL)
+        return;
+
+    s_geometry_detach_sink(geometry);
+    geometry->sink = gst_object_ref (video_sink);
+    geometry->pad = pad;
+    geometry->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_BUFFER,
+            s_geometry_caps_probe, geometry, NULL);
+    return;
+}
+
+void player_geometry_get_stats(player_instance_t *player_instance, player_geometry_stats_t *stats)
+{
+    if (stats == NULL)
+        return;
+
+    memset(stats, 0, sizeof(player_geometry_stats_t));
+    stats->first_caps_to_window_us = -1;
+    if (player_instance == NULL || player_instance->geometry == NULL)
+        return;
+
+    g_mutex_lock(&player_instance->geometry->lock);
+    *stats = player_instance->geometry->stats;
+    g_mutex_unlock(&player_instance->geometry->lock);
+    return;
+}
+
+void player_geometry_log_stats(player_instance_t *player_instance)
+{
+    player_geometry_stats_t stats;
+
+    player_geometry_get_stats(player_instance, &stats);
+    if (stats.caps_events == 0)
+        return;
+
+    I_LOG_INFO("========== Window geometry : %" G_GUINT64_FORMAT " caps, %" G_GUINT64_FORMAT " changes, %" G_GUINT64_FORMAT " already laid out ==========\n",
+            stats.caps_events, stats.changes, stats.unchanged);
+    I_LOG_INFO("buffers held for the layout : %" G_GUINT64_FORMAT ", of which timed out %" G_GUINT64_FORMAT "\n",
+            stats.buffers_held, stats.hold_timeouts);
+    if (stats.changes_on_screen)
+        I_LOG_INFO("caps to window on screen : first %" G_GINT64_FORMAT " us, mean %" G_GINT64_FORMAT " us, max %" G_GINT64_FORMAT " us\n",
+                stats.first_caps_to_window_us, stats.total_caps_to_window_us / (gint64)stats.changes_on_screen,
+                stats.max_caps_to_window_us);
+    return;
+}
+
+/* After the pipeline is stopped and before the window is destroyed*/
+void player_geometry_release(player_instance_t *player_instance)
+{
+    struct player_geometry *geometry = NULL;
+
+    if (player_instance == NULL || player_instance->geometry == NULL)
+        return;
+
+    player_geometry_log_stats(player_instance);
+
+    geometry = player_instance->geometry;
+    player_instance->geometry = NULL;
+    s_geometry_detach_sink(geometry);
+
+    g_mutex_lock(&geometry->lock);
+    geometry->player_instance = NULL;
+    g_cond_broadcast(&geometry->applied);
+    if (geometry->apply_source)
+    {
+        g_source_destroy (geometry->apply_source);
+        g_source_unref (geometry->apply_source);
+        geometry->apply_source = NULL;
+    }
+    g_mutex_unlock(&geometry->lock);
+
+    s_geometry_unref(geometry);
+    return;
+}
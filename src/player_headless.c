@@ -0,0 +1,267 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_headless.h>
+
+struct player_headless
+{
+    GMutex lock;
+    player_headless_sink_e sink_type;
+    GstPad *video_pad;
+    gulong video_probe_id;
+    GstPad *source_pad;
+    gulong source_probe_id;
+    gulong source_setup_id;
+    gint64 first_frame_time;
+    gint64 last_frame_time;
+    GstClockTime first_pts;
+    GstClockTime last_end;      /* pts + duration of the newest frame*/
+    guint64 frames;
+    guint64 decoded_bytes;
+    guint64 input_bytes;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* video streaming thread*/
+static GstPadProbeReturn s_headless_video_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_headless *headless = (struct player_headless *) user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&headless->lock);
+    if (headless->frames == 0)
+        headless->first_frame_time = now;
+    headless->last_frame_time = now;
+    headless->frames++;
+    headless->decoded_bytes += gst_buffer_get_size (buffer);
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+    {
+        if (!GST_CLOCK_TIME_IS_VALID (headless->first_pts))
+            headless->first_pts = GST_BUFFER_PTS (buffer);
+        headless->last_end = GST_BUFFER_PTS (buffer) +
+            (GST_BUFFER_DURATION_IS_VALID (buffer) ? GST_BUFFER_DURATION (buffer) : 0);
+    }
+    g_mutex_unlock(&headless->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* source streaming thread*/
+static GstPadProbeReturn s_headless_source_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_headless *headless = (struct player_headless *) user_data;
+    gsize size = 0;
+
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+        size = gst_buffer_list_calculate_size (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+    else
+        size = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+
+    g_mutex_lock(&headless->lock);
+    headless->input_bytes += size;
+    g_mutex_unlock(&headless->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* playbin creates a new source for every uri*/
+static void s_headless_source_setup_cb(GstElement *playbin, GstElement *source, struct player_headless *headless)
+{
+    GstPad *pad = gst_element_get_static_pad (source, "src");
+
+    if (pad == NULL)
+    {
+        I_LOG_DEBUG("Source %s has no static src pad, input bytes are not counted\n", GST_OBJECT_NAME (source));
+        return;
+    }
+
+    if (headless->source_pad)
+    {
+        gst_pad_remove_probe (headless->source_pad, headless->source_probe_id);
+        gst_object_unref (headless->source_pad);
+    }
+    headless->source_pad = pad;
+    headless->source_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+            s_headless_source_probe, headless, NULL);
+    return;
+}
+
+/* appsink streaming thread, take the frame like a consumer would*/
+static GstFlowReturn s_headless_new_sample_cb(GstElement *appsink, gpointer user_data)
+{
+    GstSample *sample = NULL;
+
+    g_signal_emit_by_name (appsink, "pull-sample", &sample);
+    if (sample == NULL)
+        return GST_FLOW_EOS;
+    gst_sample_unref (sample);
+    return GST_FLOW_OK;
+}
+
+static GstElement *s_headless_make_video_sink(player_headless_sink_e sink_type)
+{
+    GstElement *sink = NULL;
+
+    if (sink_type == PLAYER_HEADLESS_APPSINK)
+    {
+        sink = gst_element_factory_make ("appsink", NULL);
+        if (sink)
+        {
+            g_object_set (sink, "sync", FALSE, "emit-signals", TRUE, NULL);
+            g_signal_connect (sink, "new-sample", G_CALLBACK (s_headless_new_sample_cb), NULL);
+            return sink;
+        }
+        I_LOG_WARNING("!!!!!!!!!! No appsink, using fakesink !!!!!!!!!!\n");
+    }
+
+    sink = gst_element_factory_make ("fakesink", NULL);
+    if (sink)
+        g_object_set (sink, "sync", FALSE, NULL);
+    return sink;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Called by player_get_headless_handler before the first play*/
+int8_t player_headless_setup(player_instance_t *player_instance, player_headless_sink_e sink_type)
+{
+    struct player_headless *headless = NULL;
+    GstElement *video_sink = NULL, *audio_sink = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && player_instance->headless == NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    video_sink = s_headless_make_video_sink(sink_type);
+    audio_sink = gst_element_factory_make ("fakesink", NULL);
+    if (video_sink == NULL || audio_sink == NULL)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Create Headless Sinks xxxxxxxxxx\n");
+        if (video_sink)
+            gst_object_unref (gst_object_ref_sink (video_sink));
+        if (audio_sink)
+            gst_object_unref (gst_object_ref_sink (audio_sink));
+        goto safe_exit;
+    }
+    g_object_set (audio_sink, "sync", FALSE, NULL);
+
+    headless = g_new0(struct player_headless, 1);
+    g_mutex_init(&headless->lock);
+    headless->sink_type = sink_type;
+    headless->first_pts = GST_CLOCK_TIME_NONE;
+    headless->last_end = GST_CLOCK_TIME_NONE;
+
+    headless->video_pad = gst_element_get_static_pad (video_sink, "sink");
+    headless->video_probe_id = gst_pad_add_probe (headless->video_pad, GST_PAD_PROBE_TYPE_BUFFER, s_headless_video_probe, headless, NULL);
+    headless->source_setup_id = g_signal_connect (player_instance->pipeline, "source-setup", G_CALLBACK (s_headless_source_setup_cb), headless);
+
+    /* playbin takes the floating references*/
+    g_object_set (player_instance->pipeline, "video-sink", video_sink, "audio-sink", audio_sink, NULL);
+    player_instance->headless = headless;
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_headless_release(player_instance_t *player_instance)
+{
+    struct player_headless *headless = NULL;
+
+    if (player_instance == NULL || player_instance->headless == NULL)
+        return;
+
+    headless = player_instance->headless;
+    if (headless->source_setup_id)
+        g_signal_handler_disconnect (player_instance->pipeline, headless->source_setup_id);
+    if (headless->source_pad)
+    {
+        gst_pad_remove_probe (headless->source_pad, headless->source_probe_id);
+        gst_object_unref (headless->source_pad);
+    }
+    gst_pad_remove_probe (headless->video_pad, headless->video_probe_id);
+    gst_object_unref (headless->video_pad);
+    player_instance->headless = NULL;
+
+    g_mutex_clear(&headless->lock);
+    g_free(headless);
+    return;
+}
+
+int8_t player_headless_get_stats(player_instance_t *player_instance, player_headless_stats_t *stats)
+{
+    struct player_headless *headless = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->headless != NULL && stats != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    headless = player_instance->headless;
+    I_ZEROMEM(stats, sizeof(player_headless_stats_t));
+
+    g_mutex_lock(&headless->lock);
+    stats->frames = headless->frames;
+    stats->decoded_bytes = headless->decoded_bytes;
+    stats->input_bytes = headless->input_bytes;
+    stats->elapsed_us = headless->last_frame_time - headless->first_frame_time;
+    if (GST_CLOCK_TIME_IS_VALID (headless->first_pts) && headless->last_end > headless->first_pts)
+        stats->stream_time_us = (gint64)GST_TIME_AS_USECONDS (headless->last_end - headless->first_pts);
+    g_mutex_unlock(&headless->lock);
+
+    /* the first frame opens the interval, it is not counted as a decoded interval*/
+    if (stats->elapsed_us > 0)
+    {
+        stats->fps = (gdouble)(stats->frames - 1) * G_USEC_PER_SEC / (gdouble)stats->elapsed_us;
+        stats->realtime_factor = (gdouble)stats->stream_time_us / (gdouble)stats->elapsed_us;
+    }
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_headless_log_stats(player_instance_t *player_instance)
+{
+    player_headless_stats_t stats;
+
+    if (player_headless_get_stats(player_instance, &stats) != 0)
+        return;
+
+    I_LOG_INFO("========== Decode throughput [%s] ==========\n", player_instance->player_name);
+    I_LOG_INFO("frames %" G_GUINT64_FORMAT " in %.3f s : %.1f fps, %.2fx real time, decoded %.1f MB, input %.1f MB (%.2f Mbit/s)\n",
+            stats.frames, (gdouble)stats.elapsed_us / G_USEC_PER_SEC, stats.fps, stats.realtime_factor,
+            (gdouble)stats.decoded_bytes / (1024 * 1024), (gdouble)stats.input_bytes / (1024 * 1024),
+            (stats.elapsed_us > 0) ? ((gdouble)stats.input_bytes * 8 / (gdouble)stats.elapsed_us) : 0.0);
+    return;
+}
@@ -36,6 +36,20 @@ SOFTWARE */
 
 #include <player.h>
 #include <dispmanx_window.h>
+#include <dispmanx_update.h>
+#include <dispmanx_layout.h>
+#include <player_timing.h>
+#include <player_stats.h>
+#include <player_monitor.h>
+#include <player_headless.h>
+#include <player_frames.h>
+#include <player_buffering.h>
+#include <player_seek.h>
+#include <player_trick.h>
+#include <player_thumbs.h>
+#include <player_media_cache.h>
+#include <player_geometry.h>
+#include <player_dispatch.h>
 
 /* static function*/
 
@@ -45,16 +59,14 @@ static GThread *s_player_context_thread = NULL;
 
 /* ********** All Static Functions Defined Here ***********/
 
-/* gmain loop thread*/
+/* gmain loop thread, the loop is owned by player_init/player_stop_loop*/
 static gpointer s_player_loop(gpointer data)
 {
-    s_player_main_loop = g_main_loop_new (NULL, FALSE);
+    GMainLoop *main_loop = (GMainLoop *) data;
 
-    I_LOG_DEBUG("Run Player Loop : %p\n", s_player_main_loop);
-    g_main_loop_run (s_player_main_loop); /* Blocked until g_main_quit is called*/
-    I_LOG_DEBUG("Exit Player Loop : %p\n", s_player_main_loop);
-    g_main_loop_unref (s_player_main_loop);
-    s_player_main_loop = NULL;
+    I_LOG_DEBUG("Run Player Loop : %p\n", main_loop);
+    g_main_loop_run (main_loop); /* Blocked until g_main_quit is called*/
+    I_LOG_DEBUG("Exit Player Loop : %p\n", main_loop);
     return NULL;
 }
 
@@ -80,6 +92,164 @@ static gchar *play_uri_get_display_name (player_instance_t *player_instance, con
 	return uri_location;
 }
 
+typedef void (*player_position_updated_cb)(GstPlayer *player, GstClockTime pos, player_instance_t *player_instance);
+
+/* Replaces the GstPlayer position-updated signal, one position query per tick and only while playing*/
+static gboolean s_position_tick (gpointer user_data)
+{
+    player_instance_t *player_instance = (player_instance_t *) user_data;
+    gint64 position = -1;
+
+    if (player_query_position (player_instance, &position) == 0)
+        ((player_position_updated_cb) player_instance->position_updated_cb) (player_instance->player, (GstClockTime) position, player_instance);
+    return G_SOURCE_CONTINUE;
+}
+
+static void s_position_updates_start (player_instance_t *player_instance)
+{
+    if (player_instance->position_source_id || player_instance->position_interval_ms == 0 || player_instance->position_updated_cb == NULL)
+        return;
+    player_instance->position_source_id = g_timeout_add (player_instance->position_interval_ms, s_position_tick, player_instance);
+    return;
+}
+
+static void s_position_updates_stop (player_instance_t *player_instance)
+{
+    if (player_instance->position_source_id)
+    {
+        g_source_remove (player_instance->position_source_id);
+        player_instance->position_source_id = 0;
+    }
+    return;
+}
+
+static void s_state_changed_cb (GstPlayer * player, GstPlayerState state, player_instance_t *player_instance)
+{
+    player_timing_mark(PLAYER_TIMING_FIRST_STATE_CHANGED);
+
+    player_instance->player_state = state;
+    if (state == GST_PLAYER_STATE_PLAYING)
+        s_position_updates_start (player_instance);
+    else
+        s_position_updates_stop (player_instance);
+    return;
+}
+
+static void s_duration_changed_cb (GstPlayer * player, GstClockTime duration, player_instance_t *player_instance)
+{
+    player_instance->duration = GST_CLOCK_TIME_IS_VALID (duration) ? (gint64) duration : -1;
+    return;
+}
+
+/* What the next run of this uri needs to lay the window out before pre-roll*/
+static void s_media_cache_store (player_instance_t *player_instance, GstPlayerMediaInfo * info)
+{
+    GstPlayerVideoInfo *video = gst_player_get_current_video_track (player_instance->player);
+    GList *streams = NULL;
+    player_media_info_t cached;
+    gchar *uri = NULL;
+
+    memset(&cached, 0, sizeof(player_media_info_t));
+    cached.duration = player_instance->duration;
+    cached.seekable = player_instance->seek_enabled;
+    for (streams = gst_player_media_info_get_video_streams (info); streams; streams = streams->next)
+        cached.video_tracks++;
+    for (streams = gst_player_media_info_get_audio_streams (info); streams; streams = streams->next)
+        cached.audio_tracks++;
+    for (streams = gst_player_media_info_get_subtitle_streams (info); streams; streams = streams->next)
+        cached.subtitle_tracks++;
+    if (video)
+    {
+        cached.width = (guint)gst_player_video_info_get_width (video);
+        cached.height = (guint)gst_player_video_info_get_height (video);
+        gst_player_video_info_get_pixel_aspect_ratio (video, &cached.par_n, &cached.par_d);
+        gst_player_video_info_get_framerate (video, &cached.fps_n, &cached.fps_d);
+        g_object_unref (video);
+    }
+    /* nothing known yet, a later update will carry it*/
+    if (cached.width == 0 || cached.height == 0)
+        return;
+
+    /* GstPlayer's media info keeps the first uri after a gapless switch*/
+    uri = player_playlist_dup_current_uri (player_instance);
+    if (uri == NULL)
+        return;
+    player_media_cache_store (uri, &cached);
+    g_free (uri);
+    if (player_instance->media_cache_layout_time)
+    {
+        player_media_cache_add_saved (g_get_monotonic_time() - player_instance->media_cache_layout_time);
+        player_instance->media_cache_layout_time = 0;
+    }
+    return;
+}
+
+static void s_media_info_cb (GstPlayer * player, GstPlayerMediaInfo * info, player_instance_t *player_instance)
+{
+    GstClockTime duration = gst_player_media_info_get_duration (info);
+
+    player_timing_mark(PLAYER_TIMING_FIRST_MEDIA_INFO);
+
+    if (GST_CLOCK_TIME_IS_VALID (duration))
+        player_instance->duration = (gint64) duration;
+    player_instance->seek_enabled = gst_player_media_info_is_seekable (info);
+    s_media_cache_store (player_instance, info);
+    return;
+}
+
+/* Lays the window out for a uri played before, media_info_cb then finds nothing to change*/
+static void s_media_cache_pre_size (player_instance_t *player_instance)
+{
+    player_media_info_t cached;
+
+    player_instance->media_cache_layout_time = 0;
+    if (player_instance->headless || player_instance->frames || player_instance->vid_win.vid_window.element == 0)
+        return;
+    if (!player_media_cache_lookup (player_instance->src_uri, &cached) || cached.width == 0 || cached.height == 0)
+        return;
+
+    if (cached.duration >= 0)
+        player_instance->duration = cached.duration;
+    player_instance->seek_enabled = cached.seekable;
+    if (player_instance->vid_win.vid_width == cached.width && player_instance->vid_win.vid_height == cached.height &&
+            player_instance->vid_win.par_n == cached.par_n && player_instance->vid_win.par_d == cached.par_d)
+        return;
+
+    I_LOG_DEBUG("Pre-sizing window from the media info cache : %ux%u par %u/%u\n", cached.width, cached.height, cached.par_n, cached.par_d);
+    player_instance->vid_win.vid_width = cached.width;
+    player_instance->vid_win.vid_height = cached.height;
+    player_instance->vid_win.par_n = cached.par_n;
+    player_instance->vid_win.par_d = cached.par_d;
+    dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
+    player_instance->media_cache_layout_time = g_get_monotonic_time();
+    return;
+}
+
+static GstPadProbeReturn s_timing_first_frame_probe (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    player_timing_mark(PLAYER_TIMING_FIRST_FRAME);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/* streaming or application thread, whoever builds the sink*/
+static void s_deep_element_added_cb (GstBin *bin, GstBin *sub_bin, GstElement *element, player_instance_t *player_instance)
+{
+    if (player_timing_get(PLAYER_TIMING_FIRST_FRAME) < 0 && player_element_is_video_sink(element))
+    {
+        GstPad *pad = gst_element_get_static_pad (element, "sink");
+        if (pad)
+        {
+            gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, s_timing_first_frame_probe, NULL, NULL);
+            gst_object_unref (pad);
+        }
+    }
+    if (player_instance->stats && player_element_is_video_sink(element))
+        player_stats_attach_sink(player_instance, element);
+    if (player_instance->geometry && player_element_is_video_sink(element))
+        player_geometry_attach_sink(player_instance, element);
+    return;
+}
+
 /* ********** All Local Functions[ Visible outside this file but used only inside this package] Defined Here ***********/
 
 /* ********** All Global Functions Defined Here ***********/
@@ -95,6 +265,7 @@ int8_t player_play(player_instance_t *player_instance)
 	uri_location = play_uri_get_display_name (player_instance, player_instance->src_uri);
 	I_LOG_DEBUG("Now playing %s\n", uri_location);
 
+	s_media_cache_pre_size (player_instance);
 	g_object_set (player_instance->player, "uri", player_instance->src_uri, NULL);
 	gst_player_play (player_instance->player);
 
@@ -117,6 +288,7 @@ int8_t player_toggle_pause(player_instance_t *player_instance)
     if (player_instance->desired_state == GST_STATE_PLAYING)
     {
         player_instance->desired_state = GST_STATE_PAUSED;
+        s_position_updates_stop (player_instance); /* no ticks until state-changed reports PLAYING again*/
         gst_player_pause (player_instance->player);
     }
     else
@@ -148,22 +320,19 @@ safe_exit:
 
 void player_relative_seek (player_instance_t *player_instance, gdouble percent)
 {
-	gint64 dur = -1, pos = -1;
+	gint64 dur = -1;
 
 	g_return_if_fail (percent >= -1.0 && percent <= 1.0);
 
-	g_object_get (player_instance->player, "position", &pos, "duration", &dur, NULL);
-
+	dur = player_instance->duration;
 	if (dur <= 0)
 	{
 		I_LOG_WARNING("!!!!!!!!!! Could Not Seek !!!!!!!!!!\n");
 		return;
 	}
 
-	pos = pos + (gint64)((gdouble)dur * percent);
-	if (pos < 0)
-		pos = 0;
-	gst_player_seek (player_instance->player, (GstClockTime)pos);
+	/* coalesced with the other seeks of a burst, see player_seek.h*/
+	player_seek_relative (player_instance, (gint64)((gdouble)dur * percent));
 	return;
 }
 
@@ -237,12 +406,9 @@ int8_t player_toggle_aspect_ratio(player_instance_t *player_instance)
                     ret_status, /* On error return this*/
                     -1); /* with this value*/
                     
-    /* Toggle between PLAYER_AR_ORIGINAL & PLAYER_AR_STRETCH*/
+    /* Cycle through the layout modes, see dispmanx_layout_next_mode*/
     I_LOG_TRACE("Key r Pressed Window is FullSCreen %d\n", player_instance->vid_win.in_fullscreen);
-    if(player_instance->vid_win.ar == PLAYER_AR_STRETCH)
-        dispmanx_win_set_aspect_ratio(player_instance, PLAYER_AR_ORIGINAL);
-    else
-        dispmanx_win_set_aspect_ratio(player_instance, PLAYER_AR_STRETCH);
+    dispmanx_win_set_aspect_ratio(player_instance, dispmanx_layout_next_mode(player_instance->vid_win.ar));
 
     ret_status = 0;
     
@@ -250,7 +416,9 @@ safe_exit:
 	return ret_status;
 }
 
-int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance)
+/* headless_sink and frame_buffers 0 build the usual dispmanx window and overlay renderer*/
+static int8_t s_player_new(const char *src_uri, const char *dest_uri, player_headless_sink_e headless_sink, guint frame_buffers,
+        i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance)
 {
     player_instance_t *new_player_instance = NULL;
 
@@ -269,9 +437,28 @@ int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_si
         I_LOG_FATAL("xxxxxxxxxx Malloc Failed xxxxxxxxxx\n");
         goto safe_exit;
     }
+
+    /* Handle and display layers for this instance*/
+    if (player_manager_register(new_player_instance) != 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Register Player xxxxxxxxxx\n");
+        g_free(new_player_instance);
+        new_player_instance = NULL;
+        goto safe_exit;
+    }
+
+    player_playlist_init(new_player_instance);
   
 	/* create video renderer */
-  	if (dispmanx_create_video_window(new_player_instance) == FALSE)
+    if (headless_sink)
+    {
+        I_LOG_DEBUG("Headless player, no window and no renderer\n");
+    }
+    else if (frame_buffers)
+    {
+        I_LOG_DEBUG("Frame upload player, no window and no renderer\n");
+    }
+  	else if (dispmanx_create_video_window(new_player_instance) == FALSE)
 	{   
 		I_LOG_ERROR("xxxxxxxxxx Couldnt Create Player Window xxxxxxxxxx\n");
 	}
@@ -280,7 +467,11 @@ int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_si
 		I_LOG_DEBUG("Rcived  window handle : %p\n", new_player_instance->video_window_handle);
 	}
 
-    new_player_instance->renderer = gst_player_video_overlay_video_renderer_new (new_player_instance->video_window_handle);
+    if (headless_sink == 0 && frame_buffers == 0)
+    {
+        new_player_instance->renderer = gst_player_video_overlay_video_renderer_new (new_player_instance->video_window_handle);
+        player_geometry_setup(new_player_instance);
+    }
 
     /* Create gst player */
 	new_player_instance->player = gst_player_new (new_player_instance->renderer, gst_player_g_main_context_signal_dispatcher_new(NULL));
@@ -292,29 +483,46 @@ int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_si
         goto safe_exit;
     }
 
+    if (headless_sink && player_headless_setup(new_player_instance, headless_sink) != 0)
+        goto safe_exit;
+    if (frame_buffers && player_frames_setup(new_player_instance, frame_buffers) != 0)
+        goto safe_exit;
+
     /* Initialize with default values*/
 
-	if (gst_uri_is_valid (src_uri))
-		new_player_instance->src_uri = g_strdup(src_uri);
-	else
-    {
-        I_LOG_WARNING("!!!!!!!!!! Invalid URI... Fixing It !!!!!!!!!! %s\n", src_uri);
-		new_player_instance->src_uri = gst_filename_to_uri (src_uri, NULL);
-    }
+	new_player_instance->src_uri = player_make_uri(src_uri);
 
 	I_LOG_INFO("============ %s\n", new_player_instance->src_uri); 
 
     new_player_instance->dest_uri = (dest_uri) ? g_strdup(dest_uri) : NULL; /* TODO For future use*/
 	new_player_instance->desired_state = GST_STATE_PLAYING;
     new_player_instance->volume = 1.0;
+    new_player_instance->rate = 1.0;
+    new_player_instance->duration = -1;
+    new_player_instance->player_state = GST_PLAYER_STATE_STOPPED;
+
+    /* GstPlayer's own position timer is off, positions are polled per instance by s_position_tick*/
+    new_player_instance->position_interval_ms = PLAYER_POSITION_UPDATE_DEFAULT_MS;
+    new_player_instance->position_last_second = -1;
+    {
+        GstStructure *config = gst_player_get_config (new_player_instance->player);
+        gst_player_config_set_position_update_interval (config, 0);
+        gst_player_set_config (new_player_instance->player, config);
+    }
 
    	play_set_relative_volume (new_player_instance, new_player_instance->volume - 1.0);
 
+    g_signal_connect (new_player_instance->player, "state-changed", G_CALLBACK (s_state_changed_cb), new_player_instance);
+    g_signal_connect (new_player_instance->player, "duration-changed", G_CALLBACK (s_duration_changed_cb), new_player_instance);
+    g_signal_connect (new_player_instance->player, "media-info-updated", G_CALLBACK (s_media_info_cb), new_player_instance);
+    g_signal_connect (new_player_instance->pipeline, "deep-element-added", G_CALLBACK (s_deep_element_added_cb), new_player_instance);
+    player_monitor_start(new_player_instance);
+
     /* register signal handlers*/
     if(sig_handlers)
     {
-        if(sig_handlers->position_updated_cb)
-		  	g_signal_connect (new_player_instance->player, "position-updated", G_CALLBACK (sig_handlers->position_updated_cb), new_player_instance);
+        /* called from s_position_tick instead of the position-updated signal*/
+        new_player_instance->position_updated_cb = sig_handlers->position_updated_cb;
         if(sig_handlers->state_changed_cb)    
             g_signal_connect (new_player_instance->player, "state-changed", G_CALLBACK (sig_handlers->state_changed_cb), new_player_instance); 
         if(sig_handlers->buffering_cb)
@@ -333,27 +541,69 @@ int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_si
 safe_exit:
     if(ret_status != 0)
     {
-        player_release(*player_instance);
-        *player_instance = NULL;
+        player_release(new_player_instance);
+        if(player_instance)
+            *player_instance = NULL;
     }
     return ret_status;
 }
 
+int8_t player_get_handler(const char *src_uri, const char *dest_uri, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance)
+{
+    return s_player_new(src_uri, dest_uri, 0, 0, sig_handlers, player_instance);
+}
+
+/* No display at all, see player_headless.h*/
+int8_t player_get_headless_handler(const char *src_uri, player_headless_sink_e sink_type, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance)
+{
+    return s_player_new(src_uri, NULL, sink_type, 0, sig_handlers, player_instance);
+}
+
+/* Frames copied into a pool of dispmanx resources, see player_frames.h*/
+int8_t player_get_frame_handler(const char *src_uri, guint buffers, i_player_signal_handlers_t *sig_handlers, player_instance_t **player_instance)
+{
+    return s_player_new(src_uri, NULL, 0, MAX(buffers, 1), sig_handlers, player_instance);
+}
+
 void player_release(player_instance_t *player_instance)
 {
     if(player_instance)
     {
         I_LOG_INFO("~~~~~~~~~~ Freeing Player [%s] ~~~~~~~~~~\n", player_instance->player_name ? player_instance->player_name: "Unknown Player");
      
+        s_position_updates_stop (player_instance);
+
 		if (player_instance->player)
 		{
             play_reset(player_instance);
 			gst_player_stop (player_instance->player);
 			gst_object_unref (player_instance->player);
 		}
+
+        /* streaming threads are stopped, nothing can switch entries anymore*/
+        player_playlist_release(player_instance);
+        player_stats_disable(player_instance);
+        player_monitor_stop(player_instance);
+        player_buffering_release(player_instance);
+        player_seek_release(player_instance);
+        player_trick_release(player_instance);
+        player_thumbs_release(player_instance);
+        player_geometry_release(player_instance);
    
-        dispmanx_win_show_background_element(&player_instance->bg, FALSE);
-        dispmanx_win_destroy_background_element(&player_instance->bg);
+        /* hide and remove in a single display update*/
+        if (player_instance->headless == NULL && player_instance->frames == NULL)
+        {
+            dispmanx_update_begin();
+            dispmanx_win_show_background_element(&player_instance->bg, FALSE);
+            dispmanx_win_destroy_background_element(&player_instance->bg);
+            dispmanx_destroy_video_window(player_instance);
+            dispmanx_update_end();
+        }
+        player_headless_release(player_instance);
+        player_frames_release(player_instance);
+
+        /* layers and handle are free for the next player*/
+        player_manager_unregister(player_instance);
 
         if(player_instance->bus)
             gst_object_unref (player_instance->bus);
@@ -369,18 +619,122 @@ void player_release(player_instance_t *player_instance)
     return;
 }
 
+/* Plain file names are turned into file:// uris*/
+gchar *player_make_uri(const char *location)
+{
+    gchar *uri = NULL;
+
+    if (location == NULL)
+        return NULL;
+
+    if (gst_uri_is_valid (location))
+        uri = g_strdup(location);
+    else
+    {
+        I_LOG_WARNING("!!!!!!!!!! Invalid URI... Fixing It !!!!!!!!!! %s\n", location);
+        uri = gst_filename_to_uri (location, NULL);
+    }
+    return uri;
+}
+
+/* Sink pad of the video sink playbin is using, NULL until the sink is created. Unref when done*/
+GstPad *player_get_video_sink_pad(player_instance_t *player_instance)
+{
+    GstElement *video_sink = NULL;
+    GstPad *pad = NULL;
+
+    if (player_instance == NULL || player_instance->pipeline == NULL)
+        return NULL;
+
+    g_object_get (player_instance->pipeline, "video-sink", &video_sink, NULL);
+    if (video_sink)
+    {
+        pad = gst_element_get_static_pad (video_sink, "sink");
+        gst_object_unref (video_sink);
+    }
+    return pad;
+}
+
+gboolean player_element_is_video_sink(GstElement *element)
+{
+    GstElementFactory *factory = NULL;
+    const gchar *klass = NULL;
+
+    if (element == NULL || !GST_OBJECT_FLAG_IS_SET (element, GST_ELEMENT_FLAG_SINK))
+        return FALSE;
+
+    factory = gst_element_get_factory (element);
+    if (factory)
+        klass = gst_element_factory_get_metadata (factory, GST_ELEMENT_METADATA_KLASS);
+
+    return (klass && strstr (klass, "Sink") && strstr (klass, "Video"));
+}
+
+/* 0 turns position updates off. Takes effect immediately, also while playing*/
+int8_t player_set_position_update_interval(player_instance_t *player_instance, guint interval_ms)
+{
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    s_position_updates_stop (player_instance);
+    player_instance->position_interval_ms = interval_ms;
+    if (player_instance->player_state == GST_PLAYER_STATE_PLAYING)
+        s_position_updates_start (player_instance);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Pull API, a single position query on the pipeline*/
+int8_t player_query_position(player_instance_t *player_instance, gint64 *position)
+{
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && position != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    if (gst_element_query_position (player_instance->pipeline, GST_FORMAT_TIME, position))
+        ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Cached, -1 while unknown*/
+gint64 player_get_duration(player_instance_t *player_instance)
+{
+    return (player_instance) ? player_instance->duration : -1;
+}
+
 void player_init()
 {
 
+    s_player_main_loop = g_main_loop_new (NULL, FALSE);
     s_player_context_thread = g_thread_try_new ("PlayerLoopThread",
                                 s_player_loop,
-                                NULL,
+                                s_player_main_loop,
 							   	NULL);
     I_LOG_DEBUG("Player Loop Thread Created : %p\n", s_player_context_thread);
+
+    /* window changes are batched and submitted once per frame from the player context,
+     * without blocking it for vsync*/
+    dispmanx_update_set_async(TRUE, DISPMANX_UPDATE_DEFAULT_MAX_IN_FLIGHT);
+    dispmanx_update_set_context(g_main_context_default());
+    /* keyboard, control socket and signal handlers all hand their commands to the player context*/
+    player_dispatch_init(g_main_context_default());
+    player_media_cache_init();
 	return;
 }
 
-void player_shutdown()
+/* Quits and joins PlayerLoopThread. Call it before releasing players, the control socket or the
+ * pool: from here on nothing is dispatched on the default context, so no callback can run on what
+ * is being freed. Window changes are submitted synchronously afterwards*/
+void player_stop_loop()
 {
 	if(s_player_main_loop)
 		g_main_quit(s_player_main_loop);
@@ -389,5 +743,22 @@ void player_shutdown()
 		g_thread_join(s_player_context_thread);
 		s_player_context_thread = NULL;
     }
+    if(s_player_main_loop)
+    {
+        g_main_loop_unref(s_player_main_loop);
+        s_player_main_loop = NULL;
+    }
+
+    /* updates in flight complete on this thread, the context is no longer run*/
+    dispmanx_update_set_context(NULL);
+    /* what is left is completed without running*/
+    player_dispatch_shutdown();
+    return;
+}
+
+void player_shutdown()
+{
+    player_stop_loop();
+    player_media_cache_shutdown();
     return;
 }
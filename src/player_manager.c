@@ -0,0 +1,166 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+
+/* Registry of live player instances.
+ * Every instance gets a non zero handle and a layer slot, slot n owns the
+ * display layers (2n - 1) for its background and (2n) for its video, so
+ * instance 0 keeps the historic -1/0 pair and later instances stack above it.*/
+
+typedef struct
+{
+    GMutex lock;
+    GHashTable *instances; /* handle => player_instance_t*/
+    uint32_t next_handle;
+    gboolean slot_used[PLAYER_MAX_INSTANCES];
+}player_manager_t;
+
+static player_manager_t s_manager;
+
+/* ********** All Global Functions Defined Here ***********/
+
+int8_t player_manager_register(player_instance_t *player_instance)
+{
+    int8_t ret_status = -1;
+    gint slot;
+
+    I_ARG_CHECK( (player_instance != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    g_mutex_lock(&s_manager.lock);
+    if(s_manager.instances == NULL)
+        s_manager.instances = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    for(slot = 0; slot < PLAYER_MAX_INSTANCES; slot++)
+    {
+        if(s_manager.slot_used[slot] == FALSE)
+            break;
+    }
+    if(slot == PLAYER_MAX_INSTANCES)
+    {
+        g_mutex_unlock(&s_manager.lock);
+        I_LOG_ERROR("xxxxxxxxxx No Free Player Slot [max %d] xxxxxxxxxx\n", PLAYER_MAX_INSTANCES);
+        goto safe_exit;
+    }
+
+    /* handles are never re-used so a stale handle can not reach a new player*/
+    do
+    {
+        s_manager.next_handle++;
+    } while(s_manager.next_handle == 0 || g_hash_table_lookup(s_manager.instances, GUINT_TO_POINTER(s_manager.next_handle)));
+
+    s_manager.slot_used[slot] = TRUE;
+    player_instance->player_handler = s_manager.next_handle;
+    player_instance->layer_slot = slot;
+    player_instance->vid_win.vid_layer = PLAYER_LAYER_BASE + (2 * slot);
+    player_instance->bg.layer = player_instance->vid_win.vid_layer - 1;
+    g_hash_table_insert(s_manager.instances, GUINT_TO_POINTER(player_instance->player_handler), player_instance);
+    g_mutex_unlock(&s_manager.lock);
+
+    g_snprintf(player_instance->player_name, P_MAX_BUFFER_SIZE, "Player-%u", player_instance->player_handler);
+    I_LOG_DEBUG("Registered %s : slot %d layers [%d, %d]\n", player_instance->player_name, slot,
+            player_instance->bg.layer, player_instance->vid_win.vid_layer);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_manager_unregister(player_instance_t *player_instance)
+{
+    if(player_instance == NULL || player_instance->player_handler == 0)
+        return;
+
+    g_mutex_lock(&s_manager.lock);
+    if(s_manager.instances && g_hash_table_lookup(s_manager.instances, GUINT_TO_POINTER(player_instance->player_handler)) == player_instance)
+    {
+        g_hash_table_remove(s_manager.instances, GUINT_TO_POINTER(player_instance->player_handler));
+        if(player_instance->layer_slot >= 0 && player_instance->layer_slot < PLAYER_MAX_INSTANCES)
+            s_manager.slot_used[player_instance->layer_slot] = FALSE;
+    }
+    g_mutex_unlock(&s_manager.lock);
+
+    player_instance->player_handler = 0;
+    return;
+}
+
+player_instance_t *player_manager_lookup(uint32_t handle)
+{
+    player_instance_t *player_instance = NULL;
+
+    g_mutex_lock(&s_manager.lock);
+    if(s_manager.instances)
+        player_instance = g_hash_table_lookup(s_manager.instances, GUINT_TO_POINTER(handle));
+    g_mutex_unlock(&s_manager.lock);
+
+    return player_instance;
+}
+
+guint player_manager_count(void)
+{
+    guint count = 0;
+
+    g_mutex_lock(&s_manager.lock);
+    if(s_manager.instances)
+        count = g_hash_table_size(s_manager.instances);
+    g_mutex_unlock(&s_manager.lock);
+
+    return count;
+}
+
+/* Live handles in ascending order, returns how many were written*/
+guint player_manager_get_handles(uint32_t *handles, guint max_handles)
+{
+    GHashTableIter iter;
+    gpointer key = NULL;
+    guint count = 0, i, j;
+
+    if(handles == NULL || max_handles == 0)
+        return 0;
+
+    g_mutex_lock(&s_manager.lock);
+    if(s_manager.instances)
+    {
+        g_hash_table_iter_init(&iter, s_manager.instances);
+        while(count < max_handles && g_hash_table_iter_next(&iter, &key, NULL))
+            handles[count++] = GPOINTER_TO_UINT(key);
+    }
+    g_mutex_unlock(&s_manager.lock);
+
+    /* at most PLAYER_MAX_INSTANCES entries*/
+    for(i = 1; i < count; i++)
+    {
+        uint32_t handle = handles[i];
+        for(j = i; j > 0 && handles[j - 1] > handle; j--)
+            handles[j] = handles[j - 1];
+        handles[j] = handle;
+    }
+    return count;
+}
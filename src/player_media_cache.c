@@ -0,0 +1,469 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <glib/gstdio.h>
+
+#include <player.h>
+#include <player_media_cache.h>
+
+/* One group per uri, named by the SHA1 of the uri.
+ * Called from the application and from the player context, one mutex guards it all*/
+
+typedef struct
+{
+    GMutex lock;
+    gboolean loaded;
+    gchar *path;
+    GKeyFile *key_file;
+    guint save_id;
+    GstDiscoverer *discoverer;
+    GHashTable *discovering;    /* uri => start time*/
+    player_media_cache_stats_t stats;
+}player_media_cache_t;
+
+static player_media_cache_t s_cache;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static gchar *s_cache_group(const char *uri)
+{
+    return g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+}
+
+/* size and mtime of a local file, FALSE for other uris*/
+static gboolean s_cache_file_stamp(const char *uri, gint64 *size, gint64 *mtime)
+{
+    gchar *location = g_filename_from_uri (uri, NULL, NULL);
+    GStatBuf st;
+    gboolean local = FALSE;
+
+    if (location && g_stat (location, &st) == 0)
+    {
+        *size = (gint64)st.st_size;
+        *mtime = (gint64)st.st_mtime;
+        local = TRUE;
+    }
+    g_free(location);
+    return local;
+}
+
+/* called with the lock held*/
+static void s_cache_load_locked(void)
+{
+    GError *error = NULL;
+
+    if (s_cache.loaded)
+        return;
+
+    s_cache.loaded = TRUE;
+    s_cache.path = g_build_filename (g_get_user_cache_dir(), "i_player", "media_info", NULL);
+    s_cache.key_file = g_key_file_new ();
+    if (!g_key_file_load_from_file (s_cache.key_file, s_cache.path, G_KEY_FILE_NONE, &error))
+    {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            I_LOG_WARNING("!!!!!!!!!! Media info cache %s not loaded : %s !!!!!!!!!!\n", s_cache.path, error->message);
+        g_error_free(error);
+    }
+    return;
+}
+
+/* called with the lock held*/
+static void s_cache_save_locked(void)
+{
+    gchar *data = NULL, *dir = NULL;
+    gsize length = 0;
+    GError *error = NULL;
+
+    if (s_cache.key_file == NULL)
+        return;
+
+    data = g_key_file_to_data (s_cache.key_file, &length, NULL);
+    dir = g_path_get_dirname (s_cache.path);
+    g_mkdir_with_parents (dir, 0755);
+    if (!g_file_set_contents (s_cache.path, data, (gssize)length, &error))
+    {
+        I_LOG_WARNING("!!!!!!!!!! Media info cache not saved : %s !!!!!!!!!!\n", error->message);
+        g_error_free(error);
+    }
+    g_free(dir);
+    g_free(data);
+    return;
+}
+
+/* player context, stores are batched*/
+static gboolean s_cache_save_cb(gpointer user_data)
+{
+    g_mutex_lock(&s_cache.lock);
+    s_cache.save_id = 0;
+    s_cache_save_locked();
+    g_mutex_unlock(&s_cache.lock);
+    return G_SOURCE_REMOVE;
+}
+
+/* least recently used entry out, called with the lock held*/
+static void s_cache_trim_locked(void)
+{
+    gchar **groups = NULL, *oldest = NULL;
+    gint64 oldest_used = G_MAXINT64, used;
+    gsize count = 0, i;
+
+    groups = g_key_file_get_groups (s_cache.key_file, &count);
+    if (count > PLAYER_MEDIA_CACHE_MAX_ENTRIES)
+    {
+        for (i = 0; i < count; i++)
+        {
+            used = g_key_file_get_int64 (s_cache.key_file, groups[i], "used", NULL);
+            if (used < oldest_used)
+            {
+                oldest_used = used;
+                oldest = groups[i];
+            }
+        }
+        if (oldest)
+            g_key_file_remove_group (s_cache.key_file, oldest, NULL);
+    }
+    g_strfreev(groups);
+    return;
+}
+
+static void s_cache_info_from_discoverer(GstDiscovererInfo *discovered, player_media_info_t *info)
+{
+    GList *video = gst_discoverer_info_get_video_streams (discovered);
+    GList *audio = gst_discoverer_info_get_audio_streams (discovered);
+    GList *subtitles = gst_discoverer_info_get_subtitle_streams (discovered);
+    GstClockTime duration = gst_discoverer_info_get_duration (discovered);
+
+    memset(info, 0, sizeof(player_media_info_t));
+    info->duration = GST_CLOCK_TIME_IS_VALID (duration) ? (gint64)duration : -1;
+    info->seekable = gst_discoverer_info_get_seekable (discovered);
+    info->video_tracks = g_list_length (video);
+    info->audio_tracks = g_list_length (audio);
+    info->subtitle_tracks = g_list_length (subtitles);
+    if (video)
+    {
+        GstDiscovererVideoInfo *video_info = (GstDiscovererVideoInfo *) video->data;
+
+        info->width = gst_discoverer_video_info_get_width (video_info);
+        info->height = gst_discoverer_video_info_get_height (video_info);
+        info->par_n = gst_discoverer_video_info_get_par_num (video_info);
+        info->par_d = gst_discoverer_video_info_get_par_denom (video_info);
+        info->fps_n = (gint)gst_discoverer_video_info_get_framerate_num (video_info);
+        info->fps_d = (gint)gst_discoverer_video_info_get_framerate_denom (video_info);
+    }
+    gst_discoverer_stream_info_list_free (video);
+    gst_discoverer_stream_info_list_free (audio);
+    gst_discoverer_stream_info_list_free (subtitles);
+    return;
+}
+
+/* player context*/
+static void s_cache_discovered_cb(GstDiscoverer *discoverer, GstDiscovererInfo *discovered, GError *error, gpointer user_data)
+{
+    const gchar *uri = gst_discoverer_info_get_uri (discovered);
+    player_media_info_t info;
+    gint64 *start = NULL;
+
+    g_mutex_lock(&s_cache.lock);
+    start = g_hash_table_lookup (s_cache.discovering, uri);
+    if (start)
+        s_cache.stats.discovery_us += g_get_monotonic_time() - *start;
+    g_hash_table_remove (s_cache.discovering, uri);
+    if (gst_discoverer_info_get_result (discovered) != GST_DISCOVERER_OK)
+        s_cache.stats.discovery_failures++;
+    g_mutex_unlock(&s_cache.lock);
+
+    if (gst_discoverer_info_get_result (discovered) != GST_DISCOVERER_OK)
+    {
+        I_LOG_DEBUG("Discovery of %s failed : %s\n", uri, (error) ? error->message : "no result");
+        return;
+    }
+
+    s_cache_info_from_discoverer(discovered, &info);
+    player_media_cache_store(uri, &info);
+    I_LOG_DEBUG("Discovered %s : %ux%u\n", uri, info.width, info.height);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_media_cache_init(void)
+{
+    g_mutex_lock(&s_cache.lock);
+    s_cache_load_locked();
+    if (s_cache.discovering == NULL)
+        s_cache.discovering = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    g_mutex_unlock(&s_cache.lock);
+    return;
+}
+
+/* Saves pending entries, stops discovery and logs the statistics*/
+void player_media_cache_shutdown(void)
+{
+    GstDiscoverer *discoverer = NULL;
+
+    g_mutex_lock(&s_cache.lock);
+    discoverer = s_cache.discoverer;
+    s_cache.discoverer = NULL;
+    g_mutex_unlock(&s_cache.lock);
+
+    if (discoverer)
+    {
+        gst_discoverer_stop (discoverer);
+        g_object_unref (discoverer);
+    }
+
+    player_media_cache_log_stats();
+
+    g_mutex_lock(&s_cache.lock);
+    if (s_cache.save_id)
+    {
+        g_source_remove (s_cache.save_id);
+        s_cache.save_id = 0;
+        s_cache_save_locked();
+    }
+    if (s_cache.key_file)
+        g_key_file_free (s_cache.key_file);
+    s_cache.key_file = NULL;
+    if (s_cache.discovering)
+        g_hash_table_destroy (s_cache.discovering);
+    s_cache.discovering = NULL;
+    g_free(s_cache.path);
+    s_cache.path = NULL;
+    s_cache.loaded = FALSE;
+    g_mutex_unlock(&s_cache.lock);
+    return;
+}
+
+/* TRUE with info filled when a valid entry exists*/
+gboolean player_media_cache_lookup(const char *uri, player_media_info_t *info)
+{
+    gchar *group = NULL;
+    gint64 size = 0, mtime = 0, now = g_get_real_time() / G_USEC_PER_SEC;
+    gboolean hit = FALSE, valid;
+
+    if (uri == NULL || info == NULL)
+        return FALSE;
+
+    group = s_cache_group(uri);
+    g_mutex_lock(&s_cache.lock);
+    s_cache_load_locked();
+    s_cache.stats.lookups++;
+    if (g_key_file_has_group (s_cache.key_file, group))
+    {
+        if (s_cache_file_stamp(uri, &size, &mtime))
+            valid = (g_key_file_get_int64 (s_cache.key_file, group, "size", NULL) == size &&
+                    g_key_file_get_int64 (s_cache.key_file, group, "mtime", NULL) == mtime);
+        else
+            valid = (now - g_key_file_get_int64 (s_cache.key_file, group, "stored", NULL) < PLAYER_MEDIA_CACHE_MAX_AGE_S);
+
+        if (valid)
+        {
+            info->width = (guint)g_key_file_get_integer (s_cache.key_file, group, "width", NULL);
+            info->height = (guint)g_key_file_get_integer (s_cache.key_file, group, "height", NULL);
+            info->par_n = (guint)g_key_file_get_integer (s_cache.key_file, group, "par_n", NULL);
+            info->par_d = (guint)g_key_file_get_integer (s_cache.key_file, group, "par_d", NULL);
+            info->fps_n = g_key_file_get_integer (s_cache.key_file, group, "fps_n", NULL);
+            info->fps_d = g_key_file_get_integer (s_cache.key_file, group, "fps_d", NULL);
+            info->duration = g_key_file_get_int64 (s_cache.key_file, group, "duration", NULL);
+            info->video_tracks = (guint)g_key_file_get_integer (s_cache.key_file, group, "video_tracks", NULL);
+            info->audio_tracks = (guint)g_key_file_get_integer (s_cache.key_file, group, "audio_tracks", NULL);
+            info->subtitle_tracks = (guint)g_key_file_get_integer (s_cache.key_file, group, "subtitle_tracks", NULL);
+            info->seekable = g_key_file_get_boolean (s_cache.key_file, group, "seekable", NULL);
+            g_key_file_set_int64 (s_cache.key_file, group, "used", now);
+            hit = TRUE;
+        }
+        else
+        {
+            g_key_file_remove_group (s_cache.key_file, group, NULL);
+            s_cache.stats.stale++;
+        }
+    }
+    if (hit)
+        s_cache.stats.hits++;
+    else
+        s_cache.stats.misses++;
+    g_mutex_unlock(&s_cache.lock);
+
+    g_free(group);
+    return hit;
+}
+
+/* Saved shortly after, unchanged entries are not written again*/
+void player_media_cache_store(const char *uri, const player_media_info_t *info)
+{
+    gchar *group = NULL;
+    gint64 size = 0, mtime = 0, now = g_get_real_time() / G_USEC_PER_SEC;
+
+    if (uri == NULL || info == NULL)
+        return;
+
+    group = s_cache_group(uri);
+    g_mutex_lock(&s_cache.lock);
+    s_cache_load_locked();
+    if (g_key_file_has_group (s_cache.key_file, group) &&
+            (guint)g_key_file_get_integer (s_cache.key_file, group, "width", NULL) == info->width &&
+            (guint)g_key_file_get_integer (s_cache.key_file, group, "height", NULL) == info->height &&
+            (guint)g_key_file_get_integer (s_cache.key_file, group, "par_n", NULL) == info->par_n &&
+            (guint)g_key_file_get_integer (s_cache.key_file, group, "par_d", NULL) == info->par_d &&
+            g_key_file_get_int64 (s_cache.key_file, group, "duration", NULL) == info->duration)
+    {
+        g_mutex_unlock(&s_cache.lock);
+        g_free(group);
+        return;
+    }
+
+    g_key_file_set_string (s_cache.key_file, group, "uri", uri);
+    if (s_cache_file_stamp(uri, &size, &mtime))
+    {
+        g_key_file_set_int64 (s_cache.key_file, group, "size", size);
+        g_key_file_set_int64 (s_cache.key_file, group, "mtime", mtime);
+    }
+    g_key_file_set_int64 (s_cache.key_file, group, "stored", now);
+    g_key_file_set_int64 (s_cache.key_file, group, "used", now);
+    g_key_file_set_integer (s_cache.key_file, group, "width", (gint)info->width);
+    g_key_file_set_integer (s_cache.key_file, group, "height", (gint)info->height);
+    g_key_file_set_integer (s_cache.key_file, group, "par_n", (gint)info->par_n);
+    g_key_file_set_integer (s_cache.key_file, group, "par_d", (gint)info->par_d);
+    g_key_file_set_integer (s_cache.key_file, group, "fps_n", info->fps_n);
+    g_key_file_set_integer (s_cache.key_file, group, "fps_d", info->fps_d);
+    g_key_file_set_int64 (s_cache.key_file, group, "duration", info->duration);
+    g_key_file_set_integer (s_cache.key_file, group, "video_tracks", (gint)info->video_tracks);
+    g_key_file_set_integer (s_cache.key_file, group, "audio_tracks", (gint)info->audio_tracks);
+    g_key_file_set_integer (s_cache.key_file, group, "subtitle_tracks", (gint)info->subtitle_tracks);
+    g_key_file_set_boolean (s_cache.key_file, group, "seekable", info->seekable);
+    s_cache_trim_locked();
+
+    if (s_cache.save_id == 0)
+        s_cache.save_id = g_timeout_add_seconds (PLAYER_MEDIA_CACHE_SAVE_DELAY_S, s_cache_save_cb, NULL);
+    g_mutex_unlock(&s_cache.lock);
+
+    g_free(group);
+    return;
+}
+
+/* Background discovery on the player context for uris not cached yet*/
+int8_t player_media_cache_discover(const char *uri)
+{
+    player_media_info_t info;
+    GError *error = NULL;
+    gint64 *start = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (uri != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    ret_status = 0;
+    if (player_media_cache_lookup(uri, &info))
+        goto safe_exit;
+
+    g_mutex_lock(&s_cache.lock);
+    if (s_cache.discovering == NULL)
+        s_cache.discovering = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    if (g_hash_table_lookup (s_cache.discovering, uri))
+    {
+        g_mutex_unlock(&s_cache.lock);
+        goto safe_exit;
+    }
+
+    if (s_cache.discoverer == NULL)
+    {
+        s_cache.discoverer = gst_discoverer_new (PLAYER_MEDIA_CACHE_DISCOVER_TIMEOUT, &error);
+        if (s_cache.discoverer == NULL)
+        {
+            g_mutex_unlock(&s_cache.lock);
+            I_LOG_ERROR("xxxxxxxxxx Couldnt Create Discoverer : %s xxxxxxxxxx\n", (error) ? error->message : "");
+            if (error)
+                g_error_free(error);
+            ret_status = -1;
+            goto safe_exit;
+        }
+        g_signal_connect (s_cache.discoverer, "discovered", G_CALLBACK (s_cache_discovered_cb), NULL);
+        /* the default context is run by the player loop thread*/
+        gst_discoverer_start (s_cache.discoverer);
+    }
+
+    start = g_new (gint64, 1);
+    *start = g_get_monotonic_time();
+    g_hash_table_insert (s_cache.discovering, g_strdup(uri), start);
+    s_cache.stats.discoveries++;
+    if (!gst_discoverer_discover_uri_async (s_cache.discoverer, uri))
+    {
+        g_hash_table_remove (s_cache.discovering, uri);
+        s_cache.stats.discovery_failures++;
+    }
+    g_mutex_unlock(&s_cache.lock);
+
+safe_exit:
+    return ret_status;
+}
+
+void player_media_cache_add_saved(gint64 saved_us)
+{
+    g_mutex_lock(&s_cache.lock);
+    s_cache.stats.saved_us += saved_us;
+    g_mutex_unlock(&s_cache.lock);
+    return;
+}
+
+void player_media_cache_get_stats(player_media_cache_stats_t *stats)
+{
+    gchar **groups = NULL;
+    gsize count = 0;
+
+    if (stats == NULL)
+        return;
+
+    g_mutex_lock(&s_cache.lock);
+    *stats = s_cache.stats;
+    if (s_cache.key_file)
+    {
+        groups = g_key_file_get_groups (s_cache.key_file, &count);
+        g_strfreev(groups);
+    }
+    stats->entries = (guint)count;
+    g_mutex_unlock(&s_cache.lock);
+    return;
+}
+
+void player_media_cache_log_stats(void)
+{
+    player_media_cache_stats_t stats;
+
+    player_media_cache_get_stats(&stats);
+    if (stats.lookups == 0 && stats.discoveries == 0)
+        return;
+
+    I_LOG_INFO("========== Media info cache : %u entries ==========\n", stats.entries);
+    I_LOG_INFO("%" G_GUINT64_FORMAT " lookups, %" G_GUINT64_FORMAT " hits (%.0f %%), %" G_GUINT64_FORMAT " stale, layout ready %" G_GINT64_FORMAT " ms earlier in total\n",
+            stats.lookups, stats.hits, (stats.lookups) ? ((gdouble)stats.hits * 100.0 / (gdouble)stats.lookups) : 0.0,
+            stats.stale, stats.saved_us / 1000);
+    I_LOG_INFO("%" G_GUINT64_FORMAT " discoveries, %" G_GUINT64_FORMAT " failed, %" G_GINT64_FORMAT " ms discovering\n",
+            stats.discoveries, stats.discovery_failures, stats.discovery_us / 1000);
+    return;
+}
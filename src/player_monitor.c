@@ -0,0 +1,379 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#include <player.h>
+#include <player_monitor.h>
+
+#define PLAYER_MONITOR_SUMMARY_EVENTS 16 /* newest timeline entries in the release summary*/
+
+struct player_monitor
+{
+    GMutex lock;
+    gulong message_id;
+    gint64 start_time;
+    gint64 buffering_since;     /* 0 while not buffering*/
+    GHashTable *qos_stats;      /* source name => last processed/dropped, sinks report running totals*/
+    player_monitor_counters_t counters;
+    player_monitor_event_t timeline[PLAYER_MONITOR_TIMELINE];
+    guint head;                 /* next slot to write*/
+    guint length;
+};
+
+typedef struct
+{
+    guint64 processed;
+    guint64 dropped;
+}s_qos_totals_t;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static player_monitor_event_t *s_monitor_last_event(struct player_monitor *monitor)
+{
+    if (monitor->length == 0)
+        return NULL;
+    return &monitor->timeline[(monitor->head + PLAYER_MONITOR_TIMELINE - 1) % PLAYER_MONITOR_TIMELINE];
+}
+
+static void s_monitor_add_event(struct player_monitor *monitor, gint64 now, GstMessage *message, const gchar *format, ...) G_GNUC_PRINTF (4, 5);
+static void s_monitor_add_event(struct player_monitor *monitor, gint64 now, GstMessage *message, const gchar *format, ...)
+{
+    player_monitor_event_t *event = &monitor->timeline[monitor->head];
+    va_list args;
+
+    I_ZEROMEM(event, sizeof(player_monitor_event_t));
+    event->time_us = now - monitor->start_time;
+    event->type = GST_MESSAGE_TYPE (message);
+    event->repeat = 1;
+    g_strlcpy(event->source, GST_MESSAGE_SRC_NAME (message) ? GST_MESSAGE_SRC_NAME (message) : "", sizeof(event->source));
+
+    va_start(args, format);
+    g_vsnprintf(event->detail, sizeof(event->detail), format, args);
+    va_end(args);
+
+    monitor->head = (monitor->head + 1) % PLAYER_MONITOR_TIMELINE;
+    if (monitor->length < PLAYER_MONITOR_TIMELINE)
+        monitor->length++;
+    return;
+}
+
+static void s_monitor_qos(struct player_monitor *monitor, gint64 now, GstMessage *message)
+{
+    player_monitor_event_t *last = s_monitor_last_event(monitor);
+    s_qos_totals_t *totals = NULL;
+    GstFormat format;
+    guint64 processed = 0, dropped = 0;
+    gint64 jitter = 0;
+    gdouble proportion = 1.0;
+    gint quality = 0;
+
+    gst_message_parse_qos_values (message, &jitter, &proportion, &quality);
+    gst_message_parse_qos_stats (message, &format, &processed, &dropped);
+    monitor->counters.qos++;
+    if (jitter / 1000 > monitor->counters.max_jitter_us)
+        monitor->counters.max_jitter_us = jitter / 1000;
+
+    /* the stats are running totals per element, keep the difference*/
+    if (format == GST_FORMAT_BUFFERS || format == GST_FORMAT_DEFAULT)
+    {
+        totals = g_hash_table_lookup(monitor->qos_stats, GST_MESSAGE_SRC_NAME (message));
+        if (totals == NULL)
+        {
+            totals = g_new0(s_qos_totals_t, 1);
+            g_hash_table_insert(monitor->qos_stats, g_strdup(GST_MESSAGE_SRC_NAME (message)), totals);
+        }
+        if (processed >= totals->processed && dropped >= totals->dropped)
+        {
+            monitor->counters.qos_processed += processed - totals->processed;
+            monitor->counters.qos_dropped += dropped - totals->dropped;
+        }
+        totals->processed = processed;
+        totals->dropped = dropped;
+    }
+
+    if (last && last->type == GST_MESSAGE_QOS && g_strcmp0(last->source, GST_MESSAGE_SRC_NAME (message)) == 0 &&
+            (now - monitor->start_time) - last->time_us < PLAYER_MONITOR_QOS_FOLD_US)
+    {
+        last->repeat++;
+        return;
+    }
+    s_monitor_add_event(monitor, now, message, "jitter %" G_GINT64_FORMAT " us proportion %.3f dropped %" G_GUINT64_FORMAT,
+            jitter / 1000, proportion, dropped);
+    return;
+}
+
+static void s_monitor_buffering(struct player_monitor *monitor, gint64 now, GstMessage *message)
+{
+    gint percent = 0;
+
+    gst_message_parse_buffering (message, &percent);
+    monitor->counters.buffering++;
+    if (percent < monitor->counters.buffering_min_percent)
+        monitor->counters.buffering_min_percent = percent;
+
+    /* only the transitions go into the timeline, the levels in between are frequent*/
+    if (percent < 100 && monitor->buffering_since == 0)
+    {
+        monitor->buffering_since = now;
+        monitor->counters.buffering_stalls++;
+        s_monitor_add_event(monitor, now, message, "buffering started at %d %%", percent);
+    }
+    else if (percent >= 100 && monitor->buffering_since)
+    {
+        monitor->counters.buffering_time_us += now - monitor->buffering_since;
+        s_monitor_add_event(monitor, now, message, "buffering done after %" G_GINT64_FORMAT " us", now - monitor->buffering_since);
+        monitor->buffering_since = 0;
+    }
+    return;
+}
+
+static void s_monitor_warning(struct player_monitor *monitor, gint64 now, GstMessage *message)
+{
+    GError *err = NULL;
+    gchar *debug = NULL;
+
+    gst_message_parse_warning (message, &err, &debug);
+    monitor->counters.warnings++;
+    s_monitor_add_event(monitor, now, message, "%s", (err && err->message) ? err->message : "warning");
+    I_LOG_WARNING("Warning from %s: %s (%s)\n", GST_MESSAGE_SRC_NAME (message),
+            (err && err->message) ? err->message : "", debug ? debug : "");
+    if (err)
+        g_error_free(err);
+    g_free(debug);
+    return;
+}
+
+static void s_monitor_stream_status(struct player_monitor *monitor, gint64 now, GstMessage *message)
+{
+    GstStreamStatusType type;
+    GstElement *owner = NULL;
+    const gchar *name = NULL;
+
+    gst_message_parse_stream_status (message, &type, &owner);
+    monitor->counters.stream_status++;
+    switch (type)
+    {
+        case GST_STREAM_STATUS_TYPE_ENTER:
+            monitor->counters.streaming_threads++;
+            name = "enter";
+            break;
+        case GST_STREAM_STATUS_TYPE_LEAVE:
+            monitor->counters.streaming_threads--;
+            name = "leave";
+            break;
+        case GST_STREAM_STATUS_TYPE_CREATE:
+            name = "create";
+            break;
+        case GST_STREAM_STATUS_TYPE_DESTROY:
+            name = "destroy";
+            break;
+        default:
+            return; /* start / pause / stop follow every state change*/
+    }
+    s_monitor_add_event(monitor, now, message, "thread %s for %s", name, owner ? GST_OBJECT_NAME (owner) : "?");
+    return;
+}
+
+/* GstPlayer thread*/
+static void s_monitor_message_cb(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    struct player_monitor *monitor = (struct player_monitor *) user_data;
+    gint64 now;
+
+    switch (GST_MESSAGE_TYPE (message))
+    {
+        case GST_MESSAGE_QOS:
+        case GST_MESSAGE_LATENCY:
+        case GST_MESSAGE_BUFFERING:
+        case GST_MESSAGE_WARNING:
+        case GST_MESSAGE_STREAM_STATUS:
+            break;
+        default:
+            return;
+    }
+
+    now = g_get_monotonic_time();
+    g_mutex_lock(&monitor->lock);
+    switch (GST_MESSAGE_TYPE (message))
+    {
+        case GST_MESSAGE_QOS:
+            s_monitor_qos(monitor, now, message);
+            break;
+        case GST_MESSAGE_LATENCY:
+            monitor->counters.latency++;
+            s_monitor_add_event(monitor, now, message, "latency changed");
+            break;
+        case GST_MESSAGE_BUFFERING:
+            s_monitor_buffering(monitor, now, message);
+            break;
+        case GST_MESSAGE_WARNING:
+            s_monitor_warning(monitor, now, message);
+            break;
+        case GST_MESSAGE_STREAM_STATUS:
+            s_monitor_stream_status(monitor, now, message);
+            break;
+        default:
+            break;
+    }
+    g_mutex_unlock(&monitor->lock);
+    return;
+}
+
+static const gchar *s_monitor_type_name(GstMessageType type)
+{
+    switch (type)
+    {
+        case GST_MESSAGE_QOS:
+            return "QOS";
+        case GST_MESSAGE_LATENCY:
+            return "LATENCY";
+        case GST_MESSAGE_BUFFERING:
+            return "BUFFERING";
+        case GST_MESSAGE_WARNING:
+            return "WARNING";
+        case GST_MESSAGE_STREAM_STATUS:
+            return "STREAM_STATUS";
+        default:
+            return "OTHER";
+    }
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+int8_t player_monitor_start(player_instance_t *player_instance)
+{
+    struct player_monitor *monitor = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->bus != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    if (player_instance->monitor == NULL)
+    {
+        monitor = g_new0(struct player_monitor, 1);
+        g_mutex_init(&monitor->lock);
+        monitor->start_time = g_get_monotonic_time();
+        monitor->counters.buffering_min_percent = 100;
+        monitor->qos_stats = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        monitor->message_id = g_signal_connect (player_instance->bus, "message", G_CALLBACK (s_monitor_message_cb), monitor);
+        player_instance->monitor = monitor;
+    }
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Call once GstPlayer is stopped, logs the summary*/
+void player_monitor_stop(player_instance_t *player_instance)
+{
+    struct player_monitor *monitor = NULL;
+
+    if (player_instance == NULL || player_instance->monitor == NULL)
+        return;
+
+    player_monitor_log_summary(player_instance);
+
+    monitor = player_instance->monitor;
+    g_signal_handler_disconnect (player_instance->bus, monitor->message_id);
+    player_instance->monitor = NULL;
+
+    g_hash_table_destroy(monitor->qos_stats);
+    g_mutex_clear(&monitor->lock);
+    g_free(monitor);
+    return;
+}
+
+int8_t player_monitor_get_counters(player_instance_t *player_instance, player_monitor_counters_t *counters)
+{
+    struct player_monitor *monitor = NULL;
+    gint64 now = g_get_monotonic_time();
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->monitor != NULL && counters != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    monitor = player_instance->monitor;
+    g_mutex_lock(&monitor->lock);
+    memcpy(counters, &monitor->counters, sizeof(player_monitor_counters_t));
+    if (monitor->buffering_since)
+        counters->buffering_time_us += now - monitor->buffering_since;
+    counters->elapsed_us = now - monitor->start_time;
+    g_mutex_unlock(&monitor->lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Copies up to max_events of the newest events, oldest first. Returns the number copied*/
+guint player_monitor_get_timeline(player_instance_t *player_instance, player_monitor_event_t *events, guint max_events)
+{
+    struct player_monitor *monitor = NULL;
+    guint count, first, i;
+
+    if (player_instance == NULL || player_instance->monitor == NULL || events == NULL)
+        return 0;
+
+    monitor = player_instance->monitor;
+    g_mutex_lock(&monitor->lock);
+    count = MIN(max_events, monitor->length);
+    first = (monitor->head + PLAYER_MONITOR_TIMELINE - count) % PLAYER_MONITOR_TIMELINE;
+    for (i = 0; i < count; i++)
+        events[i] = monitor->timeline[(first + i) % PLAYER_MONITOR_TIMELINE];
+    g_mutex_unlock(&monitor->lock);
+    return count;
+}
+
+void player_monitor_log_summary(player_instance_t *player_instance)
+{
+    player_monitor_counters_t counters;
+    player_monitor_event_t events[PLAYER_MONITOR_SUMMARY_EVENTS];
+    guint count, i;
+
+    if (player_monitor_get_counters(player_instance, &counters) != 0)
+        return;
+
+    I_LOG_INFO("========== Bus summary [%s] after %" G_GINT64_FORMAT " ms ==========\n", player_instance->player_name, counters.elapsed_us / 1000);
+    I_LOG_INFO("QOS %" G_GUINT64_FORMAT " (dropped %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT ", max jitter %" G_GINT64_FORMAT " us) LATENCY %" G_GUINT64_FORMAT "\n",
+            counters.qos, counters.qos_dropped, counters.qos_processed, counters.max_jitter_us, counters.latency);
+    I_LOG_INFO("BUFFERING %" G_GUINT64_FORMAT " (stalls %" G_GUINT64_FORMAT ", min %d %%, %" G_GINT64_FORMAT " ms) WARNING %" G_GUINT64_FORMAT " STREAM_STATUS %" G_GUINT64_FORMAT "\n",
+            counters.buffering, counters.buffering_stalls, counters.buffering_min_percent, counters.buffering_time_us / 1000,
+            counters.warnings, counters.stream_status);
+
+    count = player_monitor_get_timeline(player_instance, events, PLAYER_MONITOR_SUMMARY_EVENTS);
+    for (i = 0; i < count; i++)
+    {
+        I_LOG_INFO("  %8" G_GINT64_FORMAT " ms %-13s %-20s x%-4u %s\n", events[i].time_us / 1000, s_monitor_type_name(events[i].type),
+                events[i].source, events[i].repeat, events[i].detail);
+    }
+    return;
+}
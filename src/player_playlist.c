@@ -0,0 +1,350 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_media_cache.h>
+
+/* Gapless playlist.
+ * playbin emits "about-to-finish" from its streaming thread once the current
+ * entry is fully queued. Setting the next uri from there makes playbin build
+ * and pre-roll the next source while the old one drains, and the sinks keep
+ * running across the switch so no black frame and no state change is seen.
+ * Since GstPlayer does not know about the switch it does not emit
+ * "end-of-stream" for the intermediate entries, and gst_player_get_uri() and
+ * the media info uri keep naming the first entry. Player code reads the uri
+ * through player_playlist_dup_current_uri() instead.
+ *
+ * The switch time is taken on the video sink pad, from the last buffer of the
+ * old entry (where end_of_stream_cb used to fire) to the first buffer after
+ * the new stream-start. Entries appended too late for "about-to-finish" are
+ * started from end_of_stream_cb with player_playlist_next(), which is
+ * timed from the call instead.*/
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* src_uri may still be read by the main context, old strings are kept until release*/
+static void s_playlist_set_current(player_instance_t *player_instance, gchar *uri)
+{
+    if (player_instance->src_uri)
+        g_queue_push_tail(&player_instance->playlist.retired_uris, player_instance->src_uri);
+    player_instance->src_uri = uri;
+    return;
+}
+
+static GstPadProbeReturn s_playlist_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    player_instance_t *player_instance = (player_instance_t *) user_data;
+    player_playlist_t *playlist = &player_instance->playlist;
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&playlist->lock);
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER)
+    {
+        if (playlist->waiting_first_frame)
+        {
+            playlist->waiting_first_frame = FALSE;
+            playlist->last_switch_us = now - playlist->switch_start;
+            playlist->switches++;
+            I_LOG_INFO("========== Playlist switch %u : first frame after %" G_GINT64_FORMAT " us ==========\n",
+                    playlist->switches, playlist->last_switch_us);
+        }
+        playlist->last_frame_time = now;
+    }
+    else if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_STREAM_START && playlist->gapless_pending)
+    {
+        playlist->gapless_pending = FALSE;
+        playlist->waiting_first_frame = TRUE;
+        if (playlist->switch_start == 0)
+            playlist->switch_start = (playlist->last_frame_time) ? playlist->last_frame_time : now;
+    }
+    g_mutex_unlock(&playlist->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* The sink only exists once the first entry is pre-rolled, and may be re-created on a restart.
+ * Runs on the streaming thread from "about-to-finish" as well as on the main context*/
+static void s_playlist_watch_sink(player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = &player_instance->playlist;
+    GstPad *pad = player_get_video_sink_pad(player_instance);
+    GstPad *old_pad = NULL;
+
+    if (pad == NULL)
+    {
+        I_LOG_DEBUG("No video sink yet, playlist switch will not be timed\n");
+        return;
+    }
+
+    g_mutex_lock(&playlist->lock);
+    if (pad == playlist->probe_pad)
+    {
+        g_mutex_unlock(&playlist->lock);
+        gst_object_unref(pad);
+        return;
+    }
+
+    if (playlist->probe_pad)
+    {
+        gst_pad_remove_probe(playlist->probe_pad, playlist->probe_id);
+        old_pad = playlist->probe_pad;
+    }
+    playlist->probe_pad = pad;
+    playlist->probe_id = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+            s_playlist_sink_probe, player_instance, NULL);
+    g_mutex_unlock(&playlist->lock);
+
+    if (old_pad)
+        gst_object_unref(old_pad);
+    return;
+}
+
+/* playbin streaming thread*/
+static void s_about_to_finish_cb(GstElement *playbin, player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = &player_instance->playlist;
+    gchar *next_uri = NULL;
+
+    g_mutex_lock(&playlist->lock);
+    next_uri = g_queue_pop_head(&playlist->uris);
+    if (next_uri)
+    {
+        s_playlist_set_current(player_instance, next_uri);
+        playlist->gapless_pending = TRUE;
+        playlist->switch_start = 0;
+    }
+    g_mutex_unlock(&playlist->lock);
+
+    if (next_uri == NULL)
+        return;
+
+    I_LOG_INFO("========== Pre-rolling next entry %s ==========\n", next_uri);
+    s_playlist_watch_sink(player_instance);
+    g_object_set(playbin, "uri", next_uri, NULL);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_playlist_init(player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = NULL;
+
+    if (player_instance == NULL)
+        return;
+
+    playlist = &player_instance->playlist;
+    g_mutex_init(&playlist->lock);
+    g_queue_init(&playlist->uris);
+    g_queue_init(&playlist->retired_uris);
+    return;
+}
+
+void player_playlist_release(player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = NULL;
+    GstPad *probe_pad = NULL;
+    gchar *uri = NULL;
+
+    if (player_instance == NULL)
+        return;
+
+    playlist = &player_instance->playlist;
+    if (playlist->about_to_finish_id)
+    {
+        g_signal_handler_disconnect(player_instance->pipeline, playlist->about_to_finish_id);
+        playlist->about_to_finish_id = 0;
+    }
+    g_mutex_lock(&playlist->lock);
+    probe_pad = playlist->probe_pad;
+    if (probe_pad)
+    {
+        gst_pad_remove_probe(probe_pad, playlist->probe_id);
+        playlist->probe_pad = NULL;
+        playlist->probe_id = 0;
+    }
+    g_mutex_unlock(&playlist->lock);
+    if (probe_pad)
+        gst_object_unref(probe_pad);
+
+    player_playlist_clear(player_instance);
+    g_mutex_lock(&playlist->lock);
+    while ((uri = g_queue_pop_head(&playlist->retired_uris)) != NULL)
+        g_free(uri);
+    g_mutex_unlock(&playlist->lock);
+
+    g_mutex_clear(&playlist->lock);
+    return;
+}
+
+int8_t player_playlist_append(player_instance_t *player_instance, const char *uri)
+{
+    player_playlist_t *playlist = NULL;
+    gchar *next_uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && uri != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    playlist = &player_instance->playlist;
+    if (playlist->about_to_finish_id == 0)
+        playlist->about_to_finish_id = g_signal_connect(player_instance->pipeline, "about-to-finish",
+                G_CALLBACK(s_about_to_finish_cb), player_instance);
+
+    next_uri = player_make_uri(uri);
+    /* known by the time a non gapless player_playlist_next needs it*/
+    player_media_cache_discover(next_uri);
+    g_mutex_lock(&playlist->lock);
+    g_queue_push_tail(&playlist->uris, next_uri);
+    g_mutex_unlock(&playlist->lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_playlist_clear(player_instance_t *player_instance)
+{
+    gchar *uri = NULL;
+
+    if (player_instance == NULL)
+        return;
+
+    g_mutex_lock(&player_instance->playlist.lock);
+    while ((uri = g_queue_pop_head(&player_instance->playlist.uris)) != NULL)
+        g_free(uri);
+    g_mutex_unlock(&player_instance->playlist.lock);
+    return;
+}
+
+/* Replaces src_uri for the next player_play, the old string stays readable until release*/
+int8_t player_playlist_set_uri(player_instance_t *player_instance, const char *location)
+{
+    gchar *uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && location != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    uri = player_make_uri(location);
+    if (uri == NULL)
+        goto safe_exit;
+
+    g_mutex_lock(&player_instance->playlist.lock);
+    s_playlist_set_current(player_instance, uri);
+    /* GstPlayer is given this uri by player_play, no gapless switch is pending any more*/
+    player_instance->playlist.gapless_pending = FALSE;
+    g_mutex_unlock(&player_instance->playlist.lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Non gapless switch, for entries which missed "about-to-finish". Call from end_of_stream_cb*/
+int8_t player_playlist_next(player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = NULL;
+    gchar *next_uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    playlist = &player_instance->playlist;
+    g_mutex_lock(&playlist->lock);
+    next_uri = g_queue_pop_head(&playlist->uris);
+    if (next_uri)
+    {
+        s_playlist_set_current(player_instance, next_uri);
+        playlist->gapless_pending = TRUE;
+        playlist->switch_start = g_get_monotonic_time();
+    }
+    g_mutex_unlock(&playlist->lock);
+
+    if (next_uri == NULL)
+        goto safe_exit;
+
+    s_playlist_watch_sink(player_instance);
+    ret_status = player_play(player_instance);
+
+safe_exit:
+    return ret_status;
+}
+
+guint player_playlist_length(player_instance_t *player_instance)
+{
+    guint length = 0;
+
+    if (player_instance == NULL)
+        return 0;
+
+    g_mutex_lock(&player_instance->playlist.lock);
+    length = g_queue_get_length(&player_instance->playlist.uris);
+    g_mutex_unlock(&player_instance->playlist.lock);
+    return length;
+}
+
+/* Uri of the entry whose frames reach the sink, free with g_free. src_uri runs ahead of it from
+ * "about-to-finish" until the next entry's stream-start, the old string is the last retired one then.
+ * Any thread*/
+gchar *player_playlist_dup_current_uri(player_instance_t *player_instance)
+{
+    player_playlist_t *playlist = NULL;
+    gchar *uri = NULL;
+
+    if (player_instance == NULL)
+        return NULL;
+
+    playlist = &player_instance->playlist;
+    g_mutex_lock(&playlist->lock);
+    if (playlist->gapless_pending && g_queue_peek_tail(&playlist->retired_uris))
+        uri = g_strdup(g_queue_peek_tail(&playlist->retired_uris));
+    else
+        uri = g_strdup(player_instance->src_uri);
+    g_mutex_unlock(&playlist->lock);
+    return uri;
+}
+
+/* Microseconds from the last frame of one entry to the first frame of the next, -1 before any switch*/
+gint64 player_playlist_get_last_switch_time(player_instance_t *player_instance)
+{
+    gint64 switch_us = -1;
+
+    if (player_instance == NULL)
+        return -1;
+
+    g_mutex_lock(&player_instance->playlist.lock);
+    if (player_instance->playlist.switches)
+        switch_us = player_instance->playlist.last_switch_us;
+    g_mutex_unlock(&player_instance->playlist.lock);
+    return switch_us;
+}
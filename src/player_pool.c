@@ -0,0 +1,512 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_pool.h>
+#include <player_media_cache.h>
+#include <dispmanx_window.h>
+#include <dispmanx_update.h>
+
+/* A warm entry sits in PAUSED with its pre-roll frame already rendered into
+ * its hidden window, so the switch shows it in the same display update that
+ * hides the old window. A cold entry is built on the switch and the old
+ * window stays on screen until the new player has pre-rolled.
+ * The switch time runs from player_pool_switch() to the display update
+ * carrying the swap.*/
+
+typedef struct
+{
+    gchar *src_uri;
+    player_instance_t *player_instance; /* NULL while cold*/
+    gint64 last_used;
+    gboolean prerolled;
+}player_pool_entry_t;
+
+typedef struct
+{
+    player_pool_config_t config;
+    i_player_signal_handlers_t *sig_handlers;
+    GPtrArray *entries;               /* player_pool_entry_t, in configured order*/
+    player_instance_t *visible;       /* instance on screen, may not belong to the pool*/
+    player_pool_entry_t *pending;     /* switch waiting for its pre-roll*/
+    gint64 switch_start;
+    gboolean switch_warm;
+    guint budget_source_id;           /* deferred s_pool_enforce_budget*/
+    player_pool_stats_t stats;
+}player_pool_t;
+
+static player_pool_t s_pool;
+
+/* ********** All Static Functions Defined Here ***********/
+
+static player_pool_entry_t *s_pool_find(const gchar *src_uri)
+{
+    guint i;
+
+    if (s_pool.entries == NULL)
+        return NULL;
+
+    for (i = 0; i < s_pool.entries->len; i++)
+    {
+        player_pool_entry_t *entry = g_ptr_array_index(s_pool.entries, i);
+        if (g_strcmp0(entry->src_uri, src_uri) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+static player_pool_entry_t *s_pool_find_instance(player_instance_t *player_instance)
+{
+    guint i;
+
+    if (s_pool.entries == NULL || player_instance == NULL)
+        return NULL;
+
+    for (i = 0; i < s_pool.entries->len; i++)
+    {
+        player_pool_entry_t *entry = g_ptr_array_index(s_pool.entries, i);
+        if (entry->player_instance == player_instance)
+            return entry;
+    }
+    return NULL;
+}
+
+/* Rough resident size, the decoded frames dominate once the stream is known*/
+static guint64 s_pool_entry_cost(player_pool_entry_t *entry)
+{
+    GstPlayerVideoInfo *video = NULL;
+    guint64 cost = 0;
+
+    if (entry->player_instance == NULL)
+        return 0;
+
+    cost = PLAYER_POOL_BASE_COST;
+    if (entry->prerolled)
+        video = gst_player_get_current_video_track(entry->player_instance->player);
+    if (video)
+    {
+        guint64 frame = (guint64)gst_player_video_info_get_width(video) * (guint64)gst_player_video_info_get_height(video) * 3 / 2;
+        cost += frame * PLAYER_POOL_DECODE_FRAMES;
+        g_object_unref(video);
+    }
+    return cost;
+}
+
+static void s_pool_update_usage(void)
+{
+    guint i;
+
+    s_pool.stats.warm = 0;
+    s_pool.stats.memory_estimate = 0;
+    for (i = 0; i < s_pool.entries->len; i++)
+    {
+        player_pool_entry_t *entry = g_ptr_array_index(s_pool.entries, i);
+        if (entry->player_instance)
+        {
+            s_pool.stats.warm++;
+            s_pool.stats.memory_estimate += s_pool_entry_cost(entry);
+        }
+    }
+    return;
+}
+
+static void s_pool_cool(player_pool_entry_t *entry)
+{
+    if (entry->player_instance == NULL)
+        return;
+
+    I_LOG_DEBUG("Pool : releasing warm player for %s\n", entry->src_uri);
+    if (s_pool.pending == entry)
+        s_pool.pending = NULL;
+    if (s_pool.visible == entry->player_instance)
+        s_pool.visible = NULL;
+
+    player_release(entry->player_instance);
+    entry->player_instance = NULL;
+    entry->prerolled = FALSE;
+    return;
+}
+
+/* Drop least recently used warm players until the pool fits, never the one on screen or being switched to*/
+static void s_pool_enforce_budget(void)
+{
+    s_pool_update_usage();
+
+    while (s_pool.stats.warm > s_pool.config.max_warm || s_pool.stats.memory_estimate > s_pool.config.memory_budget)
+    {
+        player_pool_entry_t *victim = NULL;
+        guint i;
+
+        for (i = 0; i < s_pool.entries->len; i++)
+        {
+            player_pool_entry_t *entry = g_ptr_array_index(s_pool.entries, i);
+            if (entry->player_instance == NULL || entry->player_instance == s_pool.visible || entry == s_pool.pending)
+                continue;
+            if (victim == NULL || entry->last_used < victim->last_used)
+                victim = entry;
+        }
+        if (victim == NULL)
+            break;
+
+        I_LOG_INFO("Pool : evicting %s [warm %u, ~%" G_GUINT64_FORMAT " KB]\n", victim->src_uri,
+                s_pool.stats.warm, s_pool.stats.memory_estimate / 1024);
+        s_pool_cool(victim);
+        s_pool.stats.evictions++;
+        s_pool_update_usage();
+    }
+    return;
+}
+
+static gboolean s_pool_budget_cb(gpointer user_data)
+{
+    s_pool.budget_source_id = 0;
+    if (s_pool.entries)
+        s_pool_enforce_budget();
+    return G_SOURCE_REMOVE;
+}
+
+/* Evicting releases players, never do it under a callback of a player which may be the victim*/
+static void s_pool_schedule_budget(void)
+{
+    if (s_pool.budget_source_id == 0)
+        s_pool.budget_source_id = g_idle_add(s_pool_budget_cb, NULL);
+    return;
+}
+
+static void s_pool_state_changed_cb(GstPlayer *player, GstPlayerState state, player_instance_t *player_instance);
+
+/* Build the player and pre-roll it behind a hidden window*/
+static int8_t s_pool_warm(player_pool_entry_t *entry, gboolean play)
+{
+    player_instance_t *player_instance = NULL;
+
+    if (entry->player_instance)
+        return 0;
+
+    if (player_get_handler(entry->src_uri, NULL, s_pool.sig_handlers, &player_instance) != 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Pool : Couldnt Create Player for %s xxxxxxxxxx\n", entry->src_uri);
+        return -1;
+    }
+    entry->player_instance = player_instance;
+    entry->prerolled = FALSE;
+    entry->last_used = g_get_monotonic_time();
+
+    dispmanx_win_show_video_element(&player_instance->vid_win, FALSE);
+    g_signal_connect(player_instance->player, "state-changed", G_CALLBACK(s_pool_state_changed_cb), player_instance);
+
+    g_object_set(player_instance->player, "uri", player_instance->src_uri, NULL);
+    if (play)
+    {
+        player_instance->desired_state = GST_STATE_PLAYING;
+        gst_player_play(player_instance->player);
+    }
+    else
+    {
+        player_instance->desired_state = GST_STATE_PAUSED;
+        gst_player_pause(player_instance->player);
+    }
+    return 0;
+}
+
+static void s_pool_swap_done(gpointer user_data)
+{
+    gint64 switch_us = g_get_monotonic_time() - s_pool.switch_start;
+
+    s_pool.stats.last_switch_us = switch_us;
+    if (s_pool.switch_warm)
+        s_pool.stats.warm_switch_us += switch_us;
+    else
+        s_pool.stats.cold_switch_us += switch_us;
+    if (s_pool.stats.min_switch_us == 0 || switch_us < s_pool.stats.min_switch_us)
+        s_pool.stats.min_switch_us = switch_us;
+    if (switch_us > s_pool.stats.max_switch_us)
+        s_pool.stats.max_switch_us = switch_us;
+
+    I_LOG_INFO("========== Pool : %s switch on screen after %" G_GINT64_FORMAT " us ==========\n",
+            s_pool.switch_warm ? "warm" : "cold", switch_us);
+    return;
+}
+
+/* Show the new window and hide the old one in the same display update*/
+static void s_pool_swap(player_pool_entry_t *entry)
+{
+    player_instance_t *previous = s_pool.visible;
+    player_instance_t *target = entry->player_instance;
+
+    s_pool.pending = NULL;
+    entry->last_used = g_get_monotonic_time();
+
+    dispmanx_update_begin();
+    dispmanx_win_show_video_element(&target->vid_win, TRUE);
+    if (previous && previous != target)
+        dispmanx_win_show_video_element(&previous->vid_win, FALSE);
+    dispmanx_update_notify(s_pool_swap_done, NULL);
+    dispmanx_update_end();
+
+    s_pool.visible = target;
+
+    /* the old player stays pre-rolled for the way back*/
+    if (previous && previous != target)
+    {
+        player_pool_entry_t *previous_entry = s_pool_find_instance(previous);
+
+        previous->desired_state = GST_STATE_PAUSED;
+        gst_player_pause(previous->player);
+        if (previous_entry)
+            previous_entry->last_used = g_get_monotonic_time();
+    }
+
+    s_pool_schedule_budget();
+    return;
+}
+
+/* main context, through the GstPlayer signal dispatcher*/
+static void s_pool_state_changed_cb(GstPlayer *player, GstPlayerState state, player_instance_t *player_instance)
+{
+    player_pool_entry_t *entry = s_pool_find_instance(player_instance);
+
+    if (entry == NULL || (state != GST_PLAYER_STATE_PAUSED && state != GST_PLAYER_STATE_PLAYING))
+        return;
+
+    if (entry->prerolled == FALSE)
+    {
+        entry->prerolled = TRUE;
+        I_LOG_DEBUG("Pool : %s pre-rolled\n", entry->src_uri);
+    }
+
+    if (s_pool.pending == entry)
+        s_pool_swap(entry);
+    else
+        s_pool_schedule_budget(); /* stream size is known now*/
+    return;
+}
+
+static void s_pool_entry_free(gpointer data)
+{
+    player_pool_entry_t *entry = (player_pool_entry_t *) data;
+
+    s_pool_cool(entry);
+    g_free(entry->src_uri);
+    g_free(entry);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_pool_init(const player_pool_config_t *config, i_player_signal_handlers_t *sig_handlers)
+{
+    if (s_pool.entries)
+        return;
+
+    I_ZEROMEM(&s_pool, sizeof(s_pool));
+    s_pool.config.max_warm = PLAYER_POOL_DEFAULT_MAX_WARM;
+    s_pool.config.memory_budget = PLAYER_POOL_DEFAULT_BUDGET;
+    if (config)
+    {
+        if (config->max_warm)
+            s_pool.config.max_warm = MIN(config->max_warm, PLAYER_MAX_INSTANCES - 1);
+        if (config->memory_budget)
+            s_pool.config.memory_budget = config->memory_budget;
+    }
+    s_pool.sig_handlers = sig_handlers;
+    s_pool.entries = g_ptr_array_new_with_free_func(s_pool_entry_free);
+
+    I_LOG_DEBUG("Pool : max warm %u, budget %" G_GUINT64_FORMAT " KB\n", s_pool.config.max_warm, s_pool.config.memory_budget / 1024);
+    return;
+}
+
+void player_pool_shutdown(void)
+{
+    if (s_pool.entries == NULL)
+        return;
+
+    I_LOG_INFO("Pool : %" G_GUINT64_FORMAT " switches (%" G_GUINT64_FORMAT " warm, %" G_GUINT64_FORMAT " cold), %" G_GUINT64_FORMAT " evictions\n",
+            s_pool.stats.switches, s_pool.stats.warm_hits, s_pool.stats.cold_misses, s_pool.stats.evictions);
+
+    if (s_pool.budget_source_id)
+    {
+        g_source_remove(s_pool.budget_source_id);
+        s_pool.budget_source_id = 0;
+    }
+    s_pool.pending = NULL;
+    g_ptr_array_free(s_pool.entries, TRUE);
+    s_pool.entries = NULL;
+    s_pool.visible = NULL;
+    return;
+}
+
+/* Configure a uri and pre-roll it if the pool has room*/
+int8_t player_pool_add(const char *src_uri)
+{
+    player_pool_entry_t *entry = NULL;
+    gchar *uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (s_pool.entries != NULL && src_uri != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    uri = player_make_uri(src_uri);
+    if (s_pool_find(uri))
+    {
+        g_free(uri);
+        ret_status = 0;
+        goto safe_exit;
+    }
+
+    entry = g_new0(player_pool_entry_t, 1);
+    entry->src_uri = uri;
+    g_ptr_array_add(s_pool.entries, entry);
+
+    s_pool_update_usage();
+    if (s_pool.stats.warm < s_pool.config.max_warm && s_pool.stats.memory_estimate < s_pool.config.memory_budget)
+        s_pool_warm(entry, FALSE);
+    else
+        player_media_cache_discover(uri); /* a cold switch can still lay its window out early*/
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+int8_t player_pool_remove(const char *src_uri)
+{
+    player_pool_entry_t *entry = NULL;
+    gchar *uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (s_pool.entries != NULL && src_uri != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    uri = player_make_uri(src_uri);
+    entry = s_pool_find(uri);
+    g_free(uri);
+    if (entry == NULL || (entry->player_instance && entry->player_instance == s_pool.visible))
+        goto safe_exit; /* the visible player has to be switched away first*/
+
+    g_ptr_array_remove(s_pool.entries, entry);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+guint player_pool_length(void)
+{
+    return (s_pool.entries) ? s_pool.entries->len : 0;
+}
+
+const gchar *player_pool_get_uri(guint index)
+{
+    if (s_pool.entries == NULL || index >= s_pool.entries->len)
+        return NULL;
+    return ((player_pool_entry_t *)g_ptr_array_index(s_pool.entries, index))->src_uri;
+}
+
+gboolean player_pool_owns(player_instance_t *player_instance)
+{
+    return (s_pool_find_instance(player_instance) != NULL);
+}
+
+/* Put src_uri on screen in place of current (or whatever the pool last showed).
+ * *next is the player which will be on screen, it belongs to the pool*/
+int8_t player_pool_switch(const char *src_uri, player_instance_t *current, player_instance_t **next)
+{
+    player_pool_entry_t *entry = NULL;
+    gchar *uri = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (s_pool.entries != NULL && src_uri != NULL && next != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    uri = player_make_uri(src_uri);
+    entry = s_pool_find(uri);
+    if (entry == NULL)
+    {
+        entry = g_new0(player_pool_entry_t, 1);
+        entry->src_uri = uri;
+        g_ptr_array_add(s_pool.entries, entry);
+    }
+    else
+        g_free(uri);
+
+    if (s_pool.visible == NULL)
+        s_pool.visible = current;
+    if (entry->player_instance && entry->player_instance == s_pool.visible)
+    {
+        *next = entry->player_instance;
+        ret_status = 0;
+        goto safe_exit;
+    }
+
+    /* a switch still waiting for its pre-roll is abandoned, its player stays paused*/
+    if (s_pool.pending && s_pool.pending != entry && s_pool.pending->player_instance)
+    {
+        s_pool.pending->player_instance->desired_state = GST_STATE_PAUSED;
+        gst_player_pause(s_pool.pending->player_instance->player);
+    }
+
+    s_pool.stats.switches++;
+    s_pool.switch_start = g_get_monotonic_time();
+    s_pool.switch_warm = (entry->player_instance != NULL && entry->prerolled);
+    if (s_pool.switch_warm)
+        s_pool.stats.warm_hits++;
+    else
+        s_pool.stats.cold_misses++;
+
+    if (entry->player_instance == NULL && s_pool_warm(entry, TRUE) != 0)
+        goto safe_exit;
+
+    entry->player_instance->desired_state = GST_STATE_PLAYING;
+    gst_player_play(entry->player_instance->player);
+
+    if (entry->prerolled)
+        s_pool_swap(entry);
+    else
+        s_pool.pending = entry; /* swapped from s_pool_state_changed_cb*/
+
+    *next = entry->player_instance;
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_pool_get_stats(player_pool_stats_t *stats)
+{
+    if (stats == NULL)
+        return;
+
+    if (s_pool.entries)
+        s_pool_update_usage();
+    memcpy(stats, &s_pool.stats, sizeof(player_pool_stats_t));
+    return;
+}
@@ -0,0 +1,160 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <player.h>
+
+/* Restricted plugin registry.
+ * gst_init stats every installed plugin against the registry cache, and
+ * loads any new or changed plugin through the forked scanner. On SD card
+ * media with the full set of gst-plugins-* installed that is most of the
+ * gst_init time. With an allow-list, gst_init only sees a private plugin
+ * directory that links the listed plugins from the system plugin
+ * directory, and keeps its own registry cache next to it. Anything
+ * outside the list is never scanned and never autoplugged.*/
+
+#ifndef I_PLAYER_GST_PLUGIN_DIR
+#define I_PLAYER_GST_PLUGIN_DIR "/usr/lib/gstreamer-1.0"
+#endif
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* Links for plugins dropped from the list would still be scanned*/
+static void s_registry_remove_stale(const gchar *plugin_dir, GHashTable *allowed)
+{
+    GDir *dir = g_dir_open(plugin_dir, 0, NULL);
+    const gchar *name = NULL;
+
+    if (dir == NULL)
+        return;
+
+    while ((name = g_dir_read_name(dir)) != NULL)
+    {
+        if (g_hash_table_lookup(allowed, name) == NULL)
+        {
+            gchar *path = g_build_filename(plugin_dir, name, NULL);
+            I_LOG_DEBUG("Registry : dropping %s\n", name);
+            unlink(path);
+            g_free(path);
+        }
+    }
+    g_dir_close(dir);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Must run before gst_init and before any other thread is started (the log writer included),
+ * the registry location is passed to gstreamer through the environment. allow_list is a comma separated list of plugin names (libgst<name>.so),
+ * NULL for PLAYER_PLUGIN_ALLOW_LIST*/
+int8_t player_registry_restrict(const char *allow_list)
+{
+    GHashTable *allowed = NULL;
+    gchar **names = NULL;
+    gchar *cache_dir = NULL;
+    gchar *plugin_dir = NULL;
+    gchar *registry = NULL;
+    guint linked = 0;
+    int8_t ret_status = -1;
+    int i;
+
+    cache_dir = g_build_filename(g_get_user_cache_dir(), "i_player", NULL);
+    plugin_dir = g_build_filename(cache_dir, "plugins", NULL);
+    if (g_mkdir_with_parents(plugin_dir, 0755) != 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Registry : Couldnt Create %s : %s xxxxxxxxxx\n", plugin_dir, g_strerror(errno));
+        goto safe_exit;
+    }
+
+    allowed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    names = g_strsplit((allow_list) ? allow_list : PLAYER_PLUGIN_ALLOW_LIST, ",", -1);
+    for (i = 0; names[i]; i++)
+    {
+        gchar *file = NULL;
+        gchar *target = NULL;
+        gchar *link = NULL;
+
+        g_strstrip(names[i]);
+        if (names[i][0] == '\0')
+            continue;
+
+        file = g_strdup_printf("libgst%s.so", names[i]);
+        target = g_build_filename(I_PLAYER_GST_PLUGIN_DIR, file, NULL);
+        link = g_build_filename(plugin_dir, file, NULL);
+
+        if (g_file_test(target, G_FILE_TEST_EXISTS) == FALSE)
+        {
+            I_LOG_WARNING("!!!!!!!!!! Registry : plugin %s not installed !!!!!!!!!!\n", names[i]);
+            g_free(file);
+        }
+        else
+        {
+            /* existing links are kept so the registry cache stays valid*/
+            if (g_file_test(link, G_FILE_TEST_EXISTS) == FALSE)
+            {
+                unlink(link); /* dangling*/
+                if (symlink(target, link) != 0)
+                    I_LOG_WARNING("!!!!!!!!!! Registry : Couldnt link %s : %s !!!!!!!!!!\n", target, g_strerror(errno));
+            }
+            g_hash_table_insert(allowed, file, GINT_TO_POINTER(1));
+            linked++;
+        }
+        g_free(target);
+        g_free(link);
+    }
+    s_registry_remove_stale(plugin_dir, allowed);
+
+    if (linked == 0)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Registry : No Allowed Plugin Found In %s xxxxxxxxxx\n", I_PLAYER_GST_PLUGIN_DIR);
+        goto safe_exit;
+    }
+
+    /* GST_PLUGIN_PATH is left alone for development plugins*/
+    registry = g_build_filename(cache_dir, "registry.bin", NULL);
+    g_setenv("GST_PLUGIN_SYSTEM_PATH_1_0", plugin_dir, TRUE);
+    g_setenv("GST_REGISTRY_1_0", registry, TRUE);
+
+    /* a handful of plugins load faster in process than through the forked scanner*/
+    gst_registry_fork_set_enabled(FALSE);
+
+    I_LOG_INFO("Registry restricted to %u plugins [%s]\n", linked, registry);
+    ret_status = 0;
+
+safe_exit:
+    if (names)
+        g_strfreev(names);
+    if (allowed)
+        g_hash_table_destroy(allowed);
+    g_free(registry);
+    g_free(plugin_dir);
+    g_free(cache_dir);
+    return ret_status;
+}
@@ -0,0 +1,451 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_seek.h>
+#include <player_trick.h>
+
+/* a seek without ASYNC_DONE after this long (state change to NULL, error) no longer blocks new ones*/
+#define S_SEEK_LOST_US (2 * G_USEC_PER_SEC)
+
+typedef enum
+{
+    S_SEEK_IDLE = 0,
+    S_SEEK_WAIT_FLUSH,      /* frames still in the sink are from before the seek*/
+    S_SEEK_WAIT_FRAME
+}s_seek_latency_e;
+
+struct player_seek
+{
+    GMutex lock;
+    player_instance_t *player_instance;
+    gulong async_done_id;
+    GstPad *sink_pad;
+    gulong probe_id;
+    guint settle_id;            /* main context timeout, 0 once input settled*/
+    gboolean in_flight;
+    gboolean pending;           /* target moved while a seek was in flight*/
+    gboolean settle_due;        /* the accurate seek waits for the seek in flight*/
+    gint64 target;              /* ns*/
+    gboolean forward;           /* direction of the newest request, picks the snap side*/
+    gdouble rate;               /* of the next seek, see player_trick.h*/
+    gint64 last_request_time;
+    gboolean issued_accurate;
+    gint64 issue_time;
+    s_seek_latency_e latency_state;
+    player_seek_stats_t stats;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* Picks the next seek, called with the lock held. FALSE when there is nothing to do*/
+static gboolean s_seek_next_locked(struct player_seek *seek, gboolean *accurate)
+{
+    if (seek->in_flight)
+        return FALSE;
+
+    /* key frames only anyway, there is nothing to refine*/
+    if (seek->settle_due && PLAYER_RATE_IS_TRICK(seek->rate))
+        seek->settle_due = FALSE;
+
+    if (seek->pending)
+        *accurate = FALSE;
+    else if (seek->settle_due)
+        *accurate = TRUE;
+    else
+        return FALSE;
+
+    seek->pending = FALSE;
+    seek->settle_due = (*accurate) ? FALSE : seek->settle_due;
+    seek->in_flight = TRUE;
+    seek->issued_accurate = *accurate;
+    seek->issue_time = g_get_monotonic_time();
+    seek->latency_state = S_SEEK_WAIT_FLUSH;
+    if (*accurate)
+        seek->stats.accurate_seeks++;
+    else
+        seek->stats.scrub_seeks++;
+    return TRUE;
+}
+
+static GstSeekFlags s_seek_flags(gdouble rate, gboolean accurate, gboolean forward)
+{
+    GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
+
+    if (accurate)
+        flags |= GST_SEEK_FLAG_ACCURATE;
+    else
+        flags |= GST_SEEK_FLAG_KEY_UNIT | ((forward) ? GST_SEEK_FLAG_SNAP_AFTER : GST_SEEK_FLAG_SNAP_BEFORE);
+
+    /* decoders skip everything but key frames, audio is dropped at the demuxer*/
+    if (PLAYER_RATE_IS_TRICK(rate))
+        flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS | GST_SEEK_FLAG_TRICKMODE_NO_AUDIO;
+    return flags;
+}
+
+/* Called without the lock, a flushing seek waits for the streaming threads which take it in the probe*/
+static void s_seek_issue(struct player_seek *seek, gint64 target, gboolean accurate, gboolean forward, gdouble rate)
+{
+    player_instance_t *player_instance = seek->player_instance;
+    GstSeekFlags flags = s_seek_flags(rate, accurate, forward);
+    gboolean result;
+
+    I_LOG_DEBUG("%s seek to %" GST_TIME_FORMAT " at %.2fx\n", (accurate) ? "Accurate" : "Key unit",
+            GST_TIME_ARGS ((GstClockTime)target), rate);
+    if (rate < 0.0)
+        result = gst_element_seek (player_instance->pipeline, rate, GST_FORMAT_TIME, flags,
+                GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, target);
+    else
+        result = gst_element_seek (player_instance->pipeline, rate, GST_FORMAT_TIME, flags,
+                GST_SEEK_TYPE_SET, target, GST_SEEK_TYPE_NONE, (gint64)GST_CLOCK_TIME_NONE);
+
+    if (result == FALSE)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Seek to %" GST_TIME_FORMAT " failed !!!!!!!!!!\n", GST_TIME_ARGS ((GstClockTime)target));
+        g_mutex_lock(&seek->lock);
+        seek->in_flight = FALSE;
+        seek->latency_state = S_SEEK_IDLE;
+        g_mutex_unlock(&seek->lock);
+    }
+    return;
+}
+
+/* video streaming thread*/
+static GstPadProbeReturn s_seek_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_seek *seek = (struct player_seek *) user_data;
+    gint64 now, latency_us;
+
+    g_mutex_lock(&seek->lock);
+    if (seek->latency_state == S_SEEK_WAIT_FLUSH && (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) &&
+            GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_FLUSH_STOP)
+    {
+        seek->latency_state = S_SEEK_WAIT_FRAME;
+    }
+    else if (seek->latency_state == S_SEEK_WAIT_FRAME && (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER))
+    {
+        now = g_get_monotonic_time();
+        latency_us = now - seek->issue_time;
+        seek->latency_state = S_SEEK_IDLE;
+        seek->stats.last_latency_us = latency_us;
+        seek->stats.total_latency_us += latency_us;
+        seek->stats.latency_samples++;
+        if (seek->stats.min_latency_us < 0 || latency_us < seek->stats.min_latency_us)
+            seek->stats.min_latency_us = latency_us;
+        if (latency_us > seek->stats.max_latency_us)
+            seek->stats.max_latency_us = latency_us;
+        if (seek->issued_accurate)
+            seek->stats.last_settle_us = now - seek->last_request_time;
+    }
+    g_mutex_unlock(&seek->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* GstPlayer thread, the seek in flight has pre-rolled*/
+static void s_seek_async_done_cb(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    struct player_seek *seek = (struct player_seek *) user_data;
+    gboolean accurate = FALSE, issue, forward;
+    gdouble rate;
+    gint64 target;
+
+    if (GST_MESSAGE_SRC (message) != GST_OBJECT (seek->player_instance->pipeline))
+        return;
+
+    g_mutex_lock(&seek->lock);
+    seek->in_flight = FALSE;
+    issue = s_seek_next_locked(seek, &accurate);
+    target = seek->target;
+    forward = seek->forward;
+    rate = seek->rate;
+    g_mutex_unlock(&seek->lock);
+
+    if (issue)
+        s_seek_issue(seek, target, accurate, forward, rate);
+    return;
+}
+
+/* main context, no request for PLAYER_SEEK_SETTLE_MS*/
+static gboolean s_seek_settle_cb(gpointer user_data)
+{
+    struct player_seek *seek = (struct player_seek *) user_data;
+    gboolean accurate = FALSE, issue;
+    gdouble rate;
+    gint64 target;
+
+    g_mutex_lock(&seek->lock);
+    seek->settle_id = 0;
+    seek->settle_due = TRUE;
+    issue = s_seek_next_locked(seek, &accurate);
+    target = seek->target;
+    rate = seek->rate;
+    g_mutex_unlock(&seek->lock);
+
+    if (issue)
+        s_seek_issue(seek, target, accurate, TRUE, rate);
+    return G_SOURCE_REMOVE;
+}
+
+static struct player_seek *s_seek_get(player_instance_t *player_instance)
+{
+    struct player_seek *seek = player_instance->seek;
+
+    if (seek)
+        return seek;
+
+    seek = g_new0(struct player_seek, 1);
+    g_mutex_init(&seek->lock);
+    seek->player_instance = player_instance;
+    seek->rate = player_instance->rate;
+    seek->stats.last_latency_us = -1;
+    seek->stats.min_latency_us = -1;
+    seek->stats.last_settle_us = -1;
+    seek->async_done_id = g_signal_connect (player_instance->bus, "message::async-done", G_CALLBACK (s_seek_async_done_cb), seek);
+    player_instance->seek = seek;
+    return seek;
+}
+
+/* the video sink exists once the first uri is pre-rolled*/
+static void s_seek_watch_sink(struct player_seek *seek)
+{
+    GstPad *pad = player_get_video_sink_pad(seek->player_instance);
+
+    if (pad == NULL || pad == seek->sink_pad)
+    {
+        if (pad)
+            gst_object_unref (pad);
+        return;
+    }
+
+    if (seek->sink_pad)
+    {
+        gst_pad_remove_probe (seek->sink_pad, seek->probe_id);
+        gst_object_unref (seek->sink_pad);
+    }
+    seek->sink_pad = pad;
+    seek->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH, s_seek_sink_probe, seek, NULL);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* position in ns, clamped to the duration. Main context*/
+int8_t player_seek_to(player_instance_t *player_instance, gint64 position)
+{
+    struct player_seek *seek = NULL;
+    gboolean accurate = FALSE, issue, forward;
+    gdouble rate;
+    gint64 target;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && player_instance->seek_enabled), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    seek = s_seek_get(player_instance);
+    s_seek_watch_sink(seek);
+
+    position = MAX(position, 0);
+    if (player_instance->duration > 0)
+        position = MIN(position, player_instance->duration);
+
+    g_mutex_lock(&seek->lock);
+    if (seek->in_flight && g_get_monotonic_time() - seek->issue_time > S_SEEK_LOST_US)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Seek in flight never completed !!!!!!!!!!\n");
+        seek->in_flight = FALSE;
+    }
+    forward = (position >= seek->target);
+    seek->forward = forward;
+    seek->stats.requests++;
+    if (seek->pending)
+        seek->stats.coalesced++;
+    seek->target = position;
+    seek->pending = TRUE;
+    seek->settle_due = FALSE;
+    seek->last_request_time = g_get_monotonic_time();
+    issue = s_seek_next_locked(seek, &accurate);
+    target = seek->target;
+    rate = seek->rate;
+    g_mutex_unlock(&seek->lock);
+
+    if (seek->settle_id)
+        g_source_remove (seek->settle_id);
+    seek->settle_id = g_timeout_add (PLAYER_SEEK_SETTLE_MS, s_seek_settle_cb, seek);
+
+    if (issue)
+        s_seek_issue(seek, target, accurate, forward, rate);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* A rate change is a seek from position, queued behind the seek in flight like any other.
+ * Trick rates start with a key unit seek, normal rates with an accurate one so playback
+ * resumes on the frame the scan showed last*/
+int8_t player_seek_set_rate(player_instance_t *player_instance, gint64 position, gdouble rate)
+{
+    struct player_seek *seek = NULL;
+    gboolean accurate = FALSE, issue;
+    gint64 target;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && player_instance->seek_enabled &&
+                    (rate > 0.0 || rate < 0.0)), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    seek = s_seek_get(player_instance);
+    s_seek_watch_sink(seek);
+
+    position = MAX(position, 0);
+    if (player_instance->duration > 0)
+        position = MIN(position, player_instance->duration);
+
+    g_mutex_lock(&seek->lock);
+    if (seek->in_flight && g_get_monotonic_time() - seek->issue_time > S_SEEK_LOST_US)
+        seek->in_flight = FALSE;
+    if (seek->pending)
+        seek->stats.coalesced++;
+    seek->rate = rate;
+    seek->target = position;
+    seek->forward = (rate > 0.0);
+    seek->pending = PLAYER_RATE_IS_TRICK(rate);
+    seek->settle_due = !seek->pending;
+    seek->last_request_time = g_get_monotonic_time();
+    issue = s_seek_next_locked(seek, &accurate);
+    target = seek->target;
+    g_mutex_unlock(&seek->lock);
+
+    if (seek->settle_id)
+    {
+        g_source_remove (seek->settle_id);
+        seek->settle_id = 0;
+    }
+
+    if (issue)
+        s_seek_issue(seek, target, accurate, (rate > 0.0), rate);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* offset in ns from the target of a burst still going on, else from the position*/
+int8_t player_seek_relative(player_instance_t *player_instance, gint64 offset)
+{
+    struct player_seek *seek = NULL;
+    gint64 base = -1;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    seek = player_instance->seek;
+    if (seek && seek->settle_id)
+    {
+        g_mutex_lock(&seek->lock);
+        base = seek->target;
+        g_mutex_unlock(&seek->lock);
+    }
+    else if (player_query_position (player_instance, &base) != 0)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Could Not Seek, No Position !!!!!!!!!!\n");
+        goto safe_exit;
+    }
+
+    ret_status = player_seek_to(player_instance, base + offset);
+
+safe_exit:
+    return ret_status;
+}
+
+/* Call once GstPlayer is stopped*/
+void player_seek_release(player_instance_t *player_instance)
+{
+    struct player_seek *seek = NULL;
+
+    if (player_instance == NULL || player_instance->seek == NULL)
+        return;
+
+    seek = player_instance->seek;
+    if (seek->stats.requests)
+        player_seek_log_stats(player_instance);
+
+    if (seek->settle_id)
+        g_source_remove (seek->settle_id);
+    g_signal_handler_disconnect (player_instance->bus, seek->async_done_id);
+    if (seek->sink_pad)
+    {
+        gst_pad_remove_probe (seek->sink_pad, seek->probe_id);
+        gst_object_unref (seek->sink_pad);
+    }
+    player_instance->seek = NULL;
+
+    g_mutex_clear(&seek->lock);
+    g_free(seek);
+    return;
+}
+
+int8_t player_seek_get_stats(player_instance_t *player_instance, player_seek_stats_t *stats)
+{
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->seek != NULL && stats != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    g_mutex_lock(&player_instance->seek->lock);
+    *stats = player_instance->seek->stats;
+    g_mutex_unlock(&player_instance->seek->lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_seek_log_stats(player_instance_t *player_instance)
+{
+    player_seek_stats_t stats;
+
+    if (player_seek_get_stats(player_instance, &stats) != 0)
+        return;
+
+    I_LOG_INFO("========== Seeks [%s] ==========\n", player_instance->player_name);
+    I_LOG_INFO("%" G_GUINT64_FORMAT " requests, %" G_GUINT64_FORMAT " coalesced, %" G_GUINT64_FORMAT " key unit + %" G_GUINT64_FORMAT " accurate seeks\n",
+            stats.requests, stats.coalesced, stats.scrub_seeks, stats.accurate_seeks);
+    I_LOG_INFO("seek to first frame : last %" G_GINT64_FORMAT " ms, min %" G_GINT64_FORMAT " ms, mean %" G_GINT64_FORMAT " ms, max %" G_GINT64_FORMAT " ms, settle %" G_GINT64_FORMAT " ms\n",
+            stats.last_latency_us / 1000, stats.min_latency_us / 1000,
+            (stats.latency_samples) ? (stats.total_latency_us / (gint64)stats.latency_samples / 1000) : -1,
+            stats.max_latency_us / 1000, stats.last_settle_us / 1000);
+    return;
+}
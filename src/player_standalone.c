@@ -27,21 +27,45 @@ SOFTWARE */
 #include <stdint.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <errno.h>
 #include <termio.h>
+#include <sys/resource.h>
 
 #include <player.h>
 #include <dispmanx_window.h>
+#include <player_pool.h>
+#include <player_timing.h>
+#include <player_stats.h>
+#include <player_headless.h>
+#include <player_frames.h>
+#include <player_buffering.h>
+#include <player_seek.h>
+#include <player_trick.h>
+#include <player_thumbs.h>
+#include <player_control.h>
+#include <player_dispatch.h>
+#include <dispmanx_layout.h>
+
+#define STANDALONE_POSITION_UPDATE_MS 250
+#define STANDALONE_SEEK_STEP ((gint64)(10 * GST_SECOND))
+
+/* dispatcher kinds besides the keys, which are their own kind*/
+#define STANDALONE_CMD_MOVE 0x100
+#define STANDALONE_CMD_SEEK 0x101
+#define STANDALONE_CMD_CHANNEL 0x102
+#define STANDALONE_CMD_VIDEO_INFO 0x103
 
 static int s_stdin_fd = -1; 
 static struct termios s_original;
-pthread_t s_kbd_event_thread;
-gboolean s_event_run = TRUE;
+static GIOChannel *s_stdin_channel = NULL;
+static guint s_kbd_watch_id = 0;
  
 static GMainLoop *s_player_main_loop = NULL;
+static player_instance_t *s_active_player = NULL; /* changes when switching to a pool player*/
 
-void * s_on_key_pressed(void *user_data);
+static gboolean s_on_key_pressed(GIOChannel *source, GIOCondition condition, gpointer user_data);
 static void s_init_keyboard_input(player_instance_t *player_instance);
-static gboolean s_key_is_pressed(int32_t *character);
+static ssize_t s_read_keys(unsigned char *keys, size_t max_keys);
 
 static void buffering_cb (GstPlayer * player, gint percent, player_instance_t *player_instance);
 static void state_changed_cb (GstPlayer * player, GstPlayerState state, player_instance_t *player_instance);
@@ -65,7 +89,19 @@ i_player_signal_handlers_t s_sig_handlers =
 static void end_of_stream_cb (GstPlayer * player, player_instance_t *player_instance)
 {
     I_LOG_INFO("========== Reached end of stream ==========\n");
-	return;
+
+    /* entries appended after about-to-finish are started here, without gapless*/
+    if (player_playlist_length(player_instance) > 0)
+        player_playlist_next(player_instance);
+    else if (player_instance->headless)
+    {
+        /* throughput run is over*/
+        player_headless_log_stats(player_instance);
+        g_main_quit(s_player_main_loop);
+    }
+    else if (player_instance->frames)
+        player_frames_log_stats(player_instance);
+    return;
 }
 
 static void error_cb (GstPlayer * player, GError * err, player_instance_t *player_instance)
@@ -76,25 +112,21 @@ static void error_cb (GstPlayer * player, GError * err, player_instance_t *playe
 
 static void position_updated_cb (GstPlayer * player, GstClockTime pos, player_instance_t *player_instance)
 {
-    GstClockTime dur = (GstClockTime)-1; 
-    gchar status[64] = { 0, };
+    gint64 dur = player_get_duration(player_instance); /* cached, no property round trip*/
+    gint64 second;
 
-    g_object_get (player_instance->player, "duration", &dur, NULL);
+    if (!GST_CLOCK_TIME_IS_VALID (pos) || dur <= 0)
+        return;
 
-    memset (status, ' ', sizeof (status) - 1); 
+    /* the terminal only shows whole seconds, skip ticks which would print the same line*/
+    second = (gint64)(pos / GST_SECOND);
+    if (second == player_instance->position_last_second)
+        return;
+    player_instance->position_last_second = second;
 
-    if (pos != -1 && dur > 0 && dur != -1)
-    {
-        gchar dstr[32], pstr[32];
-
-        /* FIXME: pretty print in nicer format */
-        g_snprintf (pstr, 32, "%" GST_TIME_FORMAT, GST_TIME_ARGS (pos));
-        pstr[9] = '\0';
-        g_snprintf (dstr, 32, "%" GST_TIME_FORMAT, GST_TIME_ARGS (dur));
-        dstr[9] = '\0';
-        /*I_LOG_USER("%s / %s %s\r", pstr, dstr, status);*/
-        g_print ("%s / %s %s\r", pstr, dstr, status);
-    }
+    g_print ("%" G_GINT64_FORMAT ":%02" G_GINT64_FORMAT ":%02" G_GINT64_FORMAT " / %" G_GINT64_FORMAT ":%02" G_GINT64_FORMAT ":%02" G_GINT64_FORMAT "    \r",
+            second / 3600, (second / 60) % 60, second % 60,
+            (dur / (gint64)GST_SECOND) / 3600, ((dur / (gint64)GST_SECOND) / 60) % 60, (dur / (gint64)GST_SECOND) % 60);
     return;
 }
 
@@ -110,6 +142,14 @@ static void buffering_cb (GstPlayer * player, gint percent, player_instance_t *p
     return;
 }
 
+static void thumbs_ready_cb (player_instance_t *player_instance, const player_thumbs_strip_t *strip, gpointer user_data)
+{
+    if (strip)
+        I_LOG_INFO("========== Seek previews : %u x %ux%u every %" G_GINT64_FORMAT " s%s ==========\n", strip->count,
+                strip->width, strip->height, strip->interval / (gint64)GST_SECOND, (strip->from_cache) ? ", cached" : "");
+    return;
+}
+
 static void print_video_info (GstPlayerVideoInfo * info)
 {
   gint fps_n, fps_d;
@@ -183,142 +223,298 @@ static void print_current_tracks (player_instance_t *player_instance)
 }
 
 
+/* player context, the last video info of a burst*/
+static int8_t s_video_info_cb(player_instance_t *player_instance, player_dispatch_command_t *command)
+{
+	guint width = (guint)command->args[0], height = (guint)command->args[1];
+	guint par_n = (guint)command->args[2], par_d = (guint)command->args[3];
+
+	if(player_instance == NULL)
+		return -1;
+
+	if(player_instance->vid_win.par_n != par_n || player_instance->vid_win.par_d != par_d)
+	{
+		player_instance->vid_win.par_n = par_n;
+		player_instance->vid_win.par_d = par_d;
+		if(player_instance->vid_win.vid_width == width && player_instance->vid_win.vid_height == height)
+			dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
+	}
+
+	if(player_instance->vid_win.vid_width != width || player_instance->vid_win.vid_height != height)
+	{
+		I_LOG_WARNING("?????????? Video Resolution Changed ?????????? %d %d ==> %d %d\n", player_instance->vid_win.vid_width , player_instance->vid_win.vid_height, width, height);
+		player_instance->vid_win.vid_width = width;
+		player_instance->vid_win.vid_height = height;
+		/*once we have video dimensions we can call fullscreen*/
+		dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
+	}
+	return 0;
+}
+
 static void media_info_cb (GstPlayer * player, GstPlayerMediaInfo * info, player_instance_t *player_instance)
 {
 	GstPlayerVideoInfo *video = NULL;
+	player_dispatch_command_t *command = NULL;
+
+	/* without a window the frame renderer takes the size from the caps*/
+	if(player_instance->headless || player_instance->frames)
+		return;
 
 	video = gst_player_get_current_video_track (player_instance->player);
 	if(video)
 	{
-		gint width = 0, height = 0;
-
-		width = gst_player_video_info_get_width (video);
-		height = gst_player_video_info_get_height (video);
-
-		if(player_instance->vid_win.vid_width != width || player_instance->vid_win.vid_height != height)
-		{
-			I_LOG_WARNING("?????????? Video Resolution Changed ?????????? %d %d ==> %d %d\n", player_instance->vid_win.vid_width , player_instance->vid_win.vid_height, width, height);
-			player_instance->vid_win.vid_width = (guint)width;
-			player_instance->vid_win.vid_height = (guint)height;
-			/*once we have video dimensions we can call fullscreen*/
-			dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
-		}
+		guint par_n = 1, par_d = 1;
+
+		/* the window is only changed on the player context*/
+		command = player_dispatch_command_new(player_instance->player_handler, STANDALONE_CMD_VIDEO_INFO, PLAYER_DISPATCH_MERGE_LAST, s_video_info_cb);
+		gst_player_video_info_get_pixel_aspect_ratio (video, &par_n, &par_d);
+		command->args[0] = gst_player_video_info_get_width (video);
+		command->args[1] = gst_player_video_info_get_height (video);
+		command->args[2] = par_n;
+		command->args[3] = par_d;
+		g_object_unref (video);
+		player_dispatch_push(command);
   	}
 	return;
 }
 
 
-void * s_on_key_pressed(void *user_data)
+/* player context, player_instance is the one on screen when the key was pressed*/
+static int8_t s_key_command_cb(player_instance_t *player_instance, player_dispatch_command_t *command)
 {
-    player_instance_t *player_instance = (player_instance_t *) user_data;
+    gint32 c = (gint32)command->kind;
 
-    while (s_event_run)
-    {   
-        int32_t c = 0;
-        if (s_key_is_pressed(&c))
-        {   
-            c = tolower(c);
-			switch (c)
-			{
-				case ' ':
-				{
-					I_LOG_DEBUG("Key ' ' Pressed\n");
-                    player_toggle_pause(player_instance);
-					break;
-				}
-                case 27:
-                case 'q':
-                {
-                    I_LOG_DEBUG("Key q/Esc Pressed\n");
-                    s_event_run = FALSE;
-                    player_release(player_instance);
-                    g_main_quit(s_player_main_loop);
-                    break;
-                }
-                case 'b':
-                {
-                    /* Toggle background */
-                    I_LOG_TRACE("Key b Pressed , toggle background (%d)\n", player_instance->bg.opacity);
-                    if(player_instance->bg.opacity != 0)
-                        dispmanx_win_show_background_element(&player_instance->bg, FALSE);
-                    else
-                        dispmanx_win_show_background_element(&player_instance->bg, TRUE);
-                    break;
-                }
-                case 'r':
-                {
-                    /* Toggle between PLAYER_AR_ORIGINAL & PLAYER_AR_STRETCH*/
-                    I_LOG_TRACE("Key r Pressed Window is FullSCreen %d\n", player_instance->vid_win.in_fullscreen);
-                    if(player_instance->vid_win.ar == PLAYER_AR_STRETCH)
-                        dispmanx_win_set_aspect_ratio(player_instance, PLAYER_AR_ORIGINAL);
-                    else
-                        dispmanx_win_set_aspect_ratio(player_instance, PLAYER_AR_STRETCH);
-
-                    break;
-                }
-                case 'f':
-                {
-                    /* Toggle between fullscreen mode*/
-                    I_LOG_DEBUG("Key f Pressed Window is FullSCreen %d\n", player_instance->vid_win.in_fullscreen);
-                    if (player_instance->vid_win.in_fullscreen)
-                    {
-                        I_LOG_TRACE("Un-FullScreen\n");
-                        dispmanx_win_set_fullscreen(&player_instance->vid_win, FALSE);
-                    }
-                    else
-                    {
-                        I_LOG_TRACE("FullScreen\n");
-                        dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
-                    }
-                    break;
-                }
-				case 'w':
-                    dispmanx_win_move(&player_instance->vid_win, 0, -(WIN_MOVE_STEPS));
-                    break;
-				case 's':
-                    dispmanx_win_move(&player_instance->vid_win, 0, WIN_MOVE_STEPS);
-                    break;
-				case 'a':
-                    dispmanx_win_move(&player_instance->vid_win, -(WIN_MOVE_STEPS), 0);
-                    break;
-				case 'd':
-                    dispmanx_win_move(&player_instance->vid_win, WIN_MOVE_STEPS, 0);
-                    break;
-                case 'i':
-                    print_current_tracks(player_instance);
-                    break;
-                case '1':
-                    if(player_instance->src_uri)
-                    {
-                        g_free(player_instance->src_uri);
-                        player_instance->src_uri = g_strdup("file:/mnt/big_buck_bunny_720p_h264.mov");
-                        player_play(player_instance);
-                    }
-                    break;
-                case '2':
-                    if(player_instance->src_uri)
-                    {
-                        g_free(player_instance->src_uri);
-                        player_instance->src_uri = g_strdup("file:/mnt/8_Min_Abs_Workout_how_to_have_six_pack_HD_Version.mp4");
-                        player_play(player_instance);
-                    }
-                    break;
-                case '3':
-                    if(player_instance->src_uri)
-                    {
-                        g_free(player_instance->src_uri);
-                        player_instance->src_uri = g_strdup("file:/mnt/the_wolverine.mkv");
-                        player_play(player_instance);
-                    }
-                    break;
-                default:
-                    /*player_relative_seek(player_instance, +0.08);*/
-                    break;
-            } /* switch*/
-        }/*ke_pressed*/
-    }/*while*/
+    if (c == 'q')
+    {
+        I_LOG_DEBUG("Key q/Esc Pressed\n");
+        /* pool players are released with the pool*/
+        s_active_player = NULL;
+        player_release((player_instance_t *) command->data);
+        g_main_quit(s_player_main_loop);
+        return 0;
+    }
+    if (player_instance == NULL)
+        return -1;
 
-    return NULL;
+    switch (c)
+    {
+        case ' ':
+            I_LOG_DEBUG("Key ' ' Pressed\n");
+            player_toggle_pause(player_instance);
+            break;
+        case 'b':
+            /* Toggle background */
+            I_LOG_TRACE("Key b Pressed , toggle background (%d)\n", player_instance->bg.opacity);
+            if(player_instance->bg.opacity != 0)
+                dispmanx_win_show_background_element(&player_instance->bg, FALSE);
+            else
+                dispmanx_win_show_background_element(&player_instance->bg, TRUE);
+            break;
+        case 'r':
+            /* original, stretch, letterbox, pillarbox, crop, zoom*/
+            player_toggle_aspect_ratio(player_instance);
+            break;
+        case 'f':
+            /* Toggle between fullscreen mode*/
+            I_LOG_DEBUG("Key f Pressed Window is FullSCreen %d\n", player_instance->vid_win.in_fullscreen);
+            if (player_instance->vid_win.in_fullscreen)
+            {
+                I_LOG_TRACE("Un-FullScreen\n");
+                dispmanx_win_set_fullscreen(&player_instance->vid_win, FALSE);
+            }
+            else
+            {
+                I_LOG_TRACE("FullScreen\n");
+                dispmanx_win_set_fullscreen(&player_instance->vid_win, TRUE);
+            }
+            break;
+        case STANDALONE_CMD_MOVE:
+            dispmanx_win_move(&player_instance->vid_win, (gint)command->args[0], (gint)command->args[1]);
+            break;
+        case 'i':
+            print_current_tracks(player_instance);
+            break;
+        case STANDALONE_CMD_SEEK:
+            /* repeated presses are coalesced, the exact seek follows once they stop*/
+            player_seek_relative(player_instance, command->args[0]);
+            break;
+        case '.':
+            /* 2x, 4x .. 32x, from a rewind it slows the rewind down first*/
+            player_step_rate(player_instance, TRUE);
+            break;
+        case ',':
+            player_step_rate(player_instance, FALSE);
+            break;
+        case 'k':
+            player_set_rate(player_instance, 1.0);
+            break;
+        case 'z':
+            /* 1.25x steps up to 2x, then back to fit*/
+            if(player_instance->vid_win.ar == PLAYER_AR_ZOOM && player_instance->vid_win.zoom >= 2 * DISPMANX_LAYOUT_ONE)
+                dispmanx_win_set_aspect_ratio(player_instance, PLAYER_AR_ORIGINAL);
+            else if(player_instance->vid_win.ar == PLAYER_AR_ZOOM)
+                dispmanx_win_set_zoom(&player_instance->vid_win, player_instance->vid_win.zoom + DISPMANX_LAYOUT_ONE / 4);
+            else
+                dispmanx_win_set_zoom(&player_instance->vid_win, DISPMANX_LAYOUT_ONE + DISPMANX_LAYOUT_ONE / 4);
+            break;
+        case 'p':
+            /* first press starts collecting on the visible player*/
+            if(player_instance->stats)
+                player_stats_dump(player_instance, "-");
+            else
+                player_stats_enable(player_instance);
+            break;
+        case STANDALONE_CMD_CHANNEL:
+            if(player_pool_length() > 0)
+            {
+                const gchar *uri = player_pool_get_uri((guint)command->args[0]);
+                if(uri && player_pool_switch(uri, player_instance, &s_active_player) == 0 && s_active_player)
+                    player_control_set_default(s_active_player->player_handler);
+            }
+            else if(command->args[0] == 0 && player_instance->src_uri)
+            {
+                if (player_playlist_set_uri(player_instance, "file:/mnt/big_buck_bunny_720p_h264.mov") == 0)
+                    player_play(player_instance);
+            }
+            else if(command->args[0] == 1 && player_instance->src_uri)
+            {
+                if (player_playlist_set_uri(player_instance, "file:/mnt/8_Min_Abs_Workout_how_to_have_six_pack_HD_Version.mp4") == 0)
+                    player_play(player_instance);
+            }
+            else if(command->args[0] == 2 && player_instance->src_uri)
+            {
+                if (player_playlist_set_uri(player_instance, "file:/mnt/the_wolverine.mkv") == 0)
+                    player_play(player_instance);
+            }
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/* Queue the command for one key, returns FALSE once the key ends input*/
+static gboolean s_key_push(player_instance_t *main_player, int32_t c)
+{
+    player_instance_t *player_instance = (s_active_player) ? s_active_player : main_player;
+    player_dispatch_command_t *command = NULL;
+    player_dispatch_merge_e merge = PLAYER_DISPATCH_MERGE_NONE;
+    gboolean keep_watching = TRUE;
+    guint kind;
+    gint64 args[2] = { 0, 0 };
+
+    c = tolower(c);
+    kind = (guint)c;
+    switch (c)
+    {
+        case 27:
+        case 'q':
+            kind = 'q';
+            keep_watching = FALSE;
+            s_kbd_watch_id = 0;
+            break;
+        case ' ':
+        case 'b':
+        case 'f':
+            /* pressed twice before the player context got to them is no change at all*/
+            merge = PLAYER_DISPATCH_MERGE_TOGGLE;
+            break;
+        case 'w':
+        case 's':
+        case 'a':
+        case 'd':
+            /* key repeat becomes one move*/
+            kind = STANDALONE_CMD_MOVE;
+            merge = PLAYER_DISPATCH_MERGE_SUM;
+            args[0] = (c == 'a') ? -(WIN_MOVE_STEPS) : (c == 'd') ? WIN_MOVE_STEPS : 0;
+            args[1] = (c == 'w') ? -(WIN_MOVE_STEPS) : (c == 's') ? WIN_MOVE_STEPS : 0;
+            break;
+        case 'j':
+        case 'l':
+            kind = STANDALONE_CMD_SEEK;
+            merge = PLAYER_DISPATCH_MERGE_SUM;
+            args[0] = (c == 'j') ? -(STANDALONE_SEEK_STEP) : STANDALONE_SEEK_STEP;
+            break;
+        case 'k':
+            merge = PLAYER_DISPATCH_MERGE_LAST;
+            break;
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            /* zapping through channels only switches to the last one*/
+            kind = STANDALONE_CMD_CHANNEL;
+            merge = PLAYER_DISPATCH_MERGE_LAST;
+            args[0] = c - '1';
+            break;
+        case 'r':
+        case 'i':
+        case '.':
+        case ',':
+        case 'z':
+        case 'p':
+            break;
+        default:
+            return keep_watching;
+    }
+
+    /* no player was created, only quitting still means something*/
+    if (player_instance == NULL && kind != 'q')
+    {
+        I_LOG_DEBUG("No player, key %d dropped\n", c);
+        return keep_watching;
+    }
+
+    command = player_dispatch_command_new((player_instance) ? player_instance->player_handler : 0, kind, merge, s_key_command_cb);
+    command->args[0] = args[0];
+    command->args[1] = args[1];
+    command->data = main_player;
+    player_dispatch_push(command);
+    return keep_watching;
+}
+
+/* stdin watch on the main context, only dispatched when a key is actually waiting.
+ * Keys only queue commands, they run on the player context*/
+static gboolean s_on_key_pressed(GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+    unsigned char keys[64];
+    gboolean keep_watching = TRUE;
+    ssize_t count, i;
+
+    if (condition & (G_IO_HUP | G_IO_ERR | G_IO_NVAL))
+    {
+        I_LOG_WARNING("!!!!!!!!!! Keyboard Input Closed !!!!!!!!!!\n");
+        s_kbd_watch_id = 0;
+        return FALSE;
+    }
+
+    count = s_read_keys(keys, sizeof(keys));
+    if (count == 0)
+    {
+        I_LOG_WARNING("!!!!!!!!!! End Of Keyboard Input !!!!!!!!!!\n");
+        s_kbd_watch_id = 0;
+        return FALSE;
+    }
+
+    /* key repeat can leave several keys waiting, each one counts*/
+    for (i = 0; i < count && keep_watching; i++)
+    {
+        if (keys[i] == 27 && i + 1 < count && (keys[i + 1] == '[' || keys[i + 1] == 'O'))
+        {
+            /* arrow and function keys are not bound, skip up to the final byte of the sequence*/
+            i += 2;
+            while (i < count && (keys[i] < 0x40 || keys[i] > 0x7e))
+                i++;
+            continue;
+        }
+        keep_watching = s_key_push((player_instance_t *) user_data, keys[i]);
+    }
+    return keep_watching;
 }
 
 static void s_init_keyboard_input(player_instance_t *player_instance)
@@ -342,44 +538,90 @@ static void s_init_keyboard_input(player_instance_t *player_instance)
         /*Turn off buffering for stdin.*/
         setbuf(stdin, NULL);
 
-        pthread_create(&s_kbd_event_thread, NULL, s_on_key_pressed, player_instance);
+        s_stdin_channel = g_io_channel_unix_new(s_stdin_fd);
+        s_kbd_watch_id = g_io_add_watch(s_stdin_channel, G_IO_IN | G_IO_HUP | G_IO_ERR, s_on_key_pressed, player_instance);
     }
     return;
 }
 
 static void s_reset_keyboard_input()
 {
+    if(s_kbd_watch_id)
+    {
+        g_source_remove(s_kbd_watch_id);
+        s_kbd_watch_id = 0;
+    }
+    if(s_stdin_channel)
+    {
+        g_io_channel_unref(s_stdin_channel);
+        s_stdin_channel = NULL;
+    }
     if(s_stdin_fd != -1)
     {
         tcsetattr(s_stdin_fd, TCSANOW, &s_original);
         s_stdin_fd = -1;
     }
-    pthread_join(s_kbd_event_thread, NULL);
     return;
 }
 
 
-static gboolean s_key_is_pressed(int32_t *character)
+/* Only called once stdin is readable, so the read never blocks*/
+/* Everything waiting on stdin, 0 at end of input and -1 when nothing could be read*/
+static ssize_t s_read_keys(unsigned char *keys, size_t max_keys)
 {
-    int characters_buffered = 0;
-	gboolean pressed = FALSE; 
+    ssize_t characters_buffered = 0;
 
-	if(character == NULL)
-	{
-		I_LOG_WARNING("Invalid Argument\n");
-		return pressed;
-	}
+    do
+    {
+        characters_buffered = read(s_stdin_fd, keys, max_keys);
+    } while (characters_buffered < 0 && errno == EINTR);
+
+    return characters_buffered;
+}
 
-	/*Get the number of characters that are waiting to be read.*/
-    ioctl(s_stdin_fd, FIONREAD, &characters_buffered);
-	pressed = (characters_buffered != 0);
+static void s_print_cpu_usage(gint64 start_time)
+{
+    struct rusage usage;
+    gdouble wall, user, sys;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return;
+
+    wall = (gdouble)(g_get_monotonic_time() - start_time) / G_USEC_PER_SEC;
+    user = (gdouble)usage.ru_utime.tv_sec + ((gdouble)usage.ru_utime.tv_usec / G_USEC_PER_SEC);
+    sys = (gdouble)usage.ru_stime.tv_sec + ((gdouble)usage.ru_stime.tv_usec / G_USEC_PER_SEC);
+
+    I_LOG_INFO("CPU usage : user %.2fs sys %.2fs over %.2fs wall (%.1f%% of one core), %ld voluntary / %ld involuntary context switches\n",
+            user, sys, wall, (wall > 0) ? ((user + sys) * 100.0 / wall) : 0.0, usage.ru_nvcsw, usage.ru_nivcsw);
+    return;
+}
 
-    if (characters_buffered == 1)
-		*character = fgetc(stdin);
-	else if(characters_buffered > 0)
-		fflush(stdin);
+/* "duration_ms:low:high[:download]", empty fields keep the defaults*/
+static void s_configure_buffering(player_instance_t *player_instance, const gchar *spec)
+{
+    player_buffering_config_t config;
+    gchar **fields = g_strsplit(spec, ":", -1);
+    guint count = g_strv_length(fields);
+
+    player_buffering_config_init(&config);
+    if (count > 0 && fields[0][0])
+        config.buffer_duration = g_ascii_strtoll(fields[0], NULL, 10) * (gint64)GST_MSECOND;
+    if (count > 1 && fields[1][0])
+        config.low_percent = (gint)g_ascii_strtoll(fields[1], NULL, 10);
+    if (count > 2 && fields[2][0])
+        config.high_percent = (gint)g_ascii_strtoll(fields[2], NULL, 10);
+    config.download = (count > 3 && g_strcmp0(fields[3], "download") == 0);
+    g_strfreev(fields);
+
+    player_buffering_configure(player_instance, &config);
+    return;
+}
 
-	return pressed;
+static gpointer s_display_init_thread(gpointer data)
+{
+    dispmanx_initialize_window_system();
+    player_timing_mark(PLAYER_TIMING_WINDOW_SYSTEM_INIT);
+    return NULL;
 }
 
 
@@ -394,38 +636,127 @@ static gboolean s_key_is_pressed(int32_t *character)
 int32_t main(int32_t argc,char *argv[])
 {
     player_instance_t *player_instance = NULL;
+    uint32_t main_handle = 0;
+    gint64 start_time = g_get_monotonic_time();
+    GThread *display_thread = NULL;
+    int32_t i;
+
+    player_timing_mark(PLAYER_TIMING_PROCESS_START);
 
     if(argv[1] == NULL)
     {
-        I_LOG_FATAL("%s <url to play>\n", argv[0]);
+        I_LOG_FATAL("%s <url to play> [next url ...]\n", argv[0]);
         return -1;
     }
 
+    /* Only scan the plugins the player uses, I_PLAYER_PLUGINS="default" or "plugin,plugin,..."
+     * It sets environment variables, so it runs while this is still the only thread*/
+    if (g_getenv("I_PLAYER_PLUGINS"))
+        player_registry_restrict(g_strcmp0(g_getenv("I_PLAYER_PLUGINS"), "default") ? g_getenv("I_PLAYER_PLUGINS") : NULL);
+
+    /* log records are written from a background thread from here on*/
+    i_log_init();
+
+    /* JSON breakdown of the startup phases, "-" for stdout*/
+    if (g_getenv("I_PLAYER_STARTUP_REPORT"))
+        player_timing_set_report(g_getenv("I_PLAYER_STARTUP_REPORT"));
+
     /* Main Loop Init*/
     s_player_main_loop = g_main_loop_new (NULL, FALSE);
 
-    /* Initialize Dispmanx windowsystem*/
-    dispmanx_initialize_window_system();
+    /* Initialize Dispmanx windowsystem, independent of gstreamer so it runs while gst_init loads the registry*/
+    if (g_getenv("I_PLAYER_SERIAL_STARTUP") == NULL)
+        display_thread = g_thread_try_new("DisplayInit", s_display_init_thread, NULL, NULL);
+    if (display_thread == NULL)
+        s_display_init_thread(NULL);
 
     gst_init (&argc, &argv);
+    player_timing_mark(PLAYER_TIMING_GST_INIT);
+
+    if (display_thread)
+        g_thread_join(display_thread);
     
     /* Player Init*/
     player_init();
+    player_timing_mark(PLAYER_TIMING_PLAYER_INIT);
+
+    /* I_PLAYER_HEADLESS=fakesink|appsink decodes as fast as possible without a window*/
+    if (g_getenv("I_PLAYER_HEADLESS"))
+        player_get_headless_handler(argv[1], (g_strcmp0(g_getenv("I_PLAYER_HEADLESS"), "appsink") == 0) ?
+                PLAYER_HEADLESS_APPSINK : PLAYER_HEADLESS_FAKESINK, &s_sig_handlers, &player_instance);
+    /* I_PLAYER_FRAMES=2|3 uploads frames into that many dispmanx resources instead of the EGL sink*/
+    else if (g_getenv("I_PLAYER_FRAMES"))
+        player_get_frame_handler(argv[1], (guint)g_ascii_strtoull(g_getenv("I_PLAYER_FRAMES"), NULL, 10), &s_sig_handlers, &player_instance);
+    else
+        player_get_handler(argv[1], NULL, &s_sig_handlers, &player_instance);
+    player_timing_mark(PLAYER_TIMING_GET_HANDLER);
+    /* 'q' frees it on the player context, teardown looks it up again by handle*/
+    main_handle = (player_instance) ? player_instance->player_handler : 0;
+    s_active_player = player_instance;
+    player_set_position_update_interval(player_instance, STANDALONE_POSITION_UPDATE_MS);
+    for (i = 2; i < argc; i++)
+        player_playlist_append(player_instance, argv[i]);
+    if (g_getenv("I_PLAYER_FRAME_STATS"))
+        player_stats_enable(player_instance);
+    if (g_getenv("I_PLAYER_BUFFERING"))
+        s_configure_buffering(player_instance, g_getenv("I_PLAYER_BUFFERING"));
+    if (g_getenv("I_PLAYER_THUMBS"))
+    {
+        player_thumbs_config_t thumbs_config;
 
-    player_get_handler(argv[1], NULL, &s_sig_handlers, &player_instance);
+        player_thumbs_config_init(&thumbs_config);
+        player_thumbs_request(player_instance, &thumbs_config, thumbs_ready_cb, NULL);
+    }
     s_init_keyboard_input(player_instance);
+    /* I_PLAYER_CONTROL=<socket path>, handle 0 is the player on screen*/
+    if (g_getenv("I_PLAYER_CONTROL") && player_instance)
+        player_control_start(g_getenv("I_PLAYER_CONTROL"), player_instance->player_handler);
     player_play(player_instance);
+    player_timing_mark(PLAYER_TIMING_PLAY);
+
+    /* Channels for keys 1-9, pre-rolled in the background. I_PLAYER_POOL="uri;uri;..."*/
+    if (g_getenv("I_PLAYER_POOL"))
+    {
+        gchar **pool_uris = g_strsplit(g_getenv("I_PLAYER_POOL"), ";", -1);
+        gchar **uri;
+
+        player_pool_init(NULL, &s_sig_handlers);
+        for (uri = pool_uris; *uri; uri++)
+        {
+            if (**uri)
+                player_pool_add(*uri);
+        }
+        g_strfreev(pool_uris);
+    }
 
     g_main_loop_run (s_player_main_loop); /* Blocked until g_main_quit is called*/
     g_main_loop_unref (s_player_main_loop);
 
-    /*Do cleanups here*/
+    /*Do cleanups here, once nothing dispatches the default context any more*/
+    player_stop_loop();
     s_reset_keyboard_input();
+    player_control_stop();
 
+    /* no frame was shown, report whatever was reached*/
+    player_timing_finish();
+
+    /* headless EOS and every exit but 'q' still have the player playing, release it the same way*/
+    player_instance = (main_handle) ? player_manager_lookup(main_handle) : NULL;
+    if (player_instance && !player_pool_owns(player_instance))
+    {
+        s_active_player = NULL;
+        player_release(player_instance);
+    }
+    player_instance = NULL;
+
+    player_pool_shutdown();
     player_shutdown();
     
     /* De-Initialize Dispmanx windowsystem*/
     dispmanx_shutdown_window_system();
 
+    s_print_cpu_usage(start_time);
+    i_log_shutdown();
+
     return 0;
 }
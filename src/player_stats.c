@@ -0,0 +1,384 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <player.h>
+#include <player_stats.h>
+
+/* Upper bounds of the interval histogram in us, the last bucket is open*/
+static const gint64 s_bucket_limits[PLAYER_STATS_BUCKETS] =
+{
+    4000, 8000, 12000, 16000, 20000, 25000, 33000, 42000, 50000, 67000, 100000, G_MAXINT64
+};
+
+struct player_stats
+{
+    GMutex lock;
+    GstElement *sink;
+    GstPad *pad;
+    gulong probe_id;
+    gulong qos_message_id;
+    gint64 start_time;
+    gint64 last_frame_time;
+    gint64 interval_total_us;
+    player_stats_snapshot_t data;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+static void s_stats_add_frame(struct player_stats *stats, GstBuffer *buffer)
+{
+    gint64 now = g_get_monotonic_time();
+    gint64 interval, expected, deviation;
+    guint bucket;
+
+    stats->data.frames++;
+    if (stats->last_frame_time == 0)
+    {
+        stats->last_frame_time = now;
+        return;
+    }
+
+    interval = now - stats->last_frame_time;
+    stats->last_frame_time = now;
+
+    for (bucket = 0; bucket < PLAYER_STATS_BUCKETS - 1 && interval >= s_bucket_limits[bucket]; bucket++)
+        ;
+    stats->data.histogram[bucket]++;
+
+    if (stats->data.interval_min_us == 0 || interval < stats->data.interval_min_us)
+        stats->data.interval_min_us = interval;
+    if (interval > stats->data.interval_max_us)
+        stats->data.interval_max_us = interval;
+    stats->interval_total_us += interval;
+    stats->data.interval_mean_us = stats->interval_total_us / (gint64)(stats->data.frames - 1);
+
+    /* RFC 3550 style running jitter against the buffer duration, or the mean when it is unknown*/
+    expected = GST_CLOCK_TIME_IS_VALID (GST_BUFFER_DURATION (buffer)) ?
+        (gint64)(GST_BUFFER_DURATION (buffer) / 1000) : stats->data.interval_mean_us;
+    deviation = ABS (interval - expected);
+    stats->data.jitter_us += (deviation - stats->data.jitter_us) / 16;
+    return;
+}
+
+static void s_stats_add_qos(struct player_stats *stats, GstEvent *event)
+{
+    GstQOSType type;
+    gdouble proportion;
+    GstClockTimeDiff diff;
+    GstClockTime timestamp;
+
+    gst_event_parse_qos (event, &type, &proportion, &diff, &timestamp);
+    stats->data.qos_events++;
+    stats->data.proportion = proportion;
+    if (diff > 0)
+    {
+        stats->data.late++;
+        if (diff / 1000 > stats->data.max_lateness_us)
+            stats->data.max_lateness_us = diff / 1000;
+    }
+    return;
+}
+
+/* streaming thread*/
+static GstPadProbeReturn s_stats_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_stats *stats = (struct player_stats *) user_data;
+
+    g_mutex_lock(&stats->lock);
+    if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+        s_stats_add_frame(stats, GST_PAD_PROBE_INFO_BUFFER (info));
+    else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_QOS)
+        s_stats_add_qos(stats, GST_PAD_PROBE_INFO_EVENT (info));
+    g_mutex_unlock(&stats->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* GstPlayer bus thread. The sink posts its running dropped count with every QoS message*/
+static void s_stats_qos_message_cb(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    struct player_stats *stats = (struct player_stats *) user_data;
+    GstFormat format;
+    guint64 processed = 0, dropped = 0;
+
+    g_mutex_lock(&stats->lock);
+    if (stats->sink && GST_MESSAGE_SRC (message) == GST_OBJECT (stats->sink))
+    {
+        gst_message_parse_qos_stats (message, &format, &processed, &dropped);
+        if (format == GST_FORMAT_BUFFERS || format == GST_FORMAT_DEFAULT)
+            stats->data.dropped = dropped;
+    }
+    g_mutex_unlock(&stats->lock);
+    return;
+}
+
+/* Quoted JSON string, uris may carry quotes, backslashes and control characters*/
+static void s_stats_append_json_string(GString *json, const gchar *text)
+{
+    const gchar *c;
+
+    g_string_append_c(json, '"');
+    for (c = (text) ? text : ""; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            g_string_append_c(json, '\\');
+            g_string_append_c(json, *c);
+        }
+        else if ((guchar)*c < 0x20)
+            g_string_append_printf(json, "\\u%04x", (guint)(guchar)*c);
+        else
+            g_string_append_c(json, *c);
+    }
+    g_string_append_c(json, '"');
+    return;
+}
+
+static void s_stats_detach_sink(struct player_stats *stats)
+{
+    if (stats->pad)
+    {
+        gst_pad_remove_probe (stats->pad, stats->probe_id);
+        gst_object_unref (stats->pad);
+        stats->pad = NULL;
+    }
+    g_mutex_lock(&stats->lock);
+    if (stats->sink)
+    {
+        gst_object_unref (stats->sink);
+        stats->sink = NULL;
+    }
+    g_mutex_unlock(&stats->lock);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+int8_t player_stats_enable(player_instance_t *player_instance)
+{
+    struct player_stats *stats = NULL;
+    GstPad *pad = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    if (player_instance->stats)
+    {
+        ret_status = 0;
+        goto safe_exit;
+    }
+
+    stats = g_new0(struct player_stats, 1);
+    g_mutex_init(&stats->lock);
+    stats->start_time = g_get_monotonic_time();
+    player_instance->stats = stats;
+
+    if (player_instance->bus)
+        stats->qos_message_id = g_signal_connect (player_instance->bus, "message::qos", G_CALLBACK (s_stats_qos_message_cb), stats);
+
+    /* later sinks are attached from deep-element-added*/
+    pad = player_get_video_sink_pad(player_instance);
+    if (pad)
+    {
+        GstElement *sink = gst_pad_get_parent_element (pad);
+        if (sink)
+        {
+            player_stats_attach_sink(player_instance, sink);
+            gst_object_unref (sink);
+        }
+        gst_object_unref (pad);
+    }
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+void player_stats_disable(player_instance_t *player_instance)
+{
+    struct player_stats *stats = NULL;
+
+    if (player_instance == NULL || player_instance->stats == NULL)
+        return;
+
+    stats = player_instance->stats;
+    if (stats->qos_message_id)
+        g_signal_handler_disconnect (player_instance->bus, stats->qos_message_id);
+    s_stats_detach_sink(stats);
+    player_instance->stats = NULL;
+
+    g_mutex_clear(&stats->lock);
+    g_free(stats);
+    return;
+}
+
+/* Any thread, the sink may be replaced when playbin rebuilds its sinks*/
+void player_stats_attach_sink(player_instance_t *player_instance, GstElement *video_sink)
+{
+    struct player_stats *stats = NULL;
+    GstPad *pad = NULL;
+
+    if (player_instance == NULL || player_instance->stats == NULL || video_sink == NULL)
+        return;
+
+    stats = player_instance->stats;
+    if (stats->sink == video_sink)
+        return;
+
+    pad = gst_element_get_static_pad (video_sink, "sink");
+    if (pad == NULL)
+        return;
+
+    s_stats_detach_sink(stats);
+
+    g_mutex_lock(&stats->lock);
+    stats->sink = gst_object_ref (video_sink);
+    stats->last_frame_time = 0;
+    g_mutex_unlock(&stats->lock);
+
+    stats->pad = pad;
+    stats->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+            s_stats_sink_probe, stats, NULL);
+    return;
+}
+
+void player_stats_reset(player_instance_t *player_instance)
+{
+    struct player_stats *stats = NULL;
+
+    if (player_instance == NULL || player_instance->stats == NULL)
+        return;
+
+    stats = player_instance->stats;
+    g_mutex_lock(&stats->lock);
+    I_ZEROMEM(&stats->data, sizeof(player_stats_snapshot_t));
+    stats->interval_total_us = 0;
+    stats->last_frame_time = 0;
+    stats->start_time = g_get_monotonic_time();
+    g_mutex_unlock(&stats->lock);
+    return;
+}
+
+int8_t player_stats_get(player_instance_t *player_instance, player_stats_snapshot_t *snapshot)
+{
+    struct player_stats *stats = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->stats != NULL && snapshot != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    stats = player_instance->stats;
+    g_mutex_lock(&stats->lock);
+    memcpy(snapshot, &stats->data, sizeof(player_stats_snapshot_t));
+    snapshot->elapsed_us = g_get_monotonic_time() - stats->start_time;
+    g_mutex_unlock(&stats->lock);
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* Upper bound in us of a histogram bucket, G_MAXINT64 for the last one*/
+gint64 player_stats_bucket_limit(guint bucket)
+{
+    return (bucket < PLAYER_STATS_BUCKETS) ? s_bucket_limits[bucket] : -1;
+}
+
+/* Free with g_free, NULL if stats are not enabled*/
+gchar *player_stats_to_json(player_instance_t *player_instance)
+{
+    player_stats_snapshot_t data;
+    GString *json = NULL;
+    gchar *uri = NULL;
+    guint i;
+
+    if (player_stats_get(player_instance, &data) != 0)
+        return NULL;
+
+    uri = player_playlist_dup_current_uri(player_instance);
+    json = g_string_new("{\"player\":");
+    s_stats_append_json_string(json, player_instance->player_name);
+    g_string_append(json, ",\"uri\":");
+    s_stats_append_json_string(json, uri);
+    g_free(uri);
+    g_string_append_printf(json, ",\"elapsed_us\":%" G_GINT64_FORMAT ",\"frames\":%" G_GUINT64_FORMAT
+            ",\"fps\":%.2f,\"late\":%" G_GUINT64_FORMAT ",\"dropped\":%" G_GUINT64_FORMAT ",\"qos_events\":%" G_GUINT64_FORMAT
+            ",\"max_lateness_us\":%" G_GINT64_FORMAT ",\"proportion\":%.3f,\"interval_us\":{\"min\":%" G_GINT64_FORMAT
+            ",\"mean\":%" G_GINT64_FORMAT ",\"max\":%" G_GINT64_FORMAT "},\"jitter_us\":%" G_GINT64_FORMAT ",\"histogram\":[",
+            data.elapsed_us, data.frames,
+            (data.elapsed_us > 0) ? ((gdouble)data.frames * G_USEC_PER_SEC / (gdouble)data.elapsed_us) : 0.0,
+            data.late, data.dropped, data.qos_events, data.max_lateness_us, data.proportion,
+            data.interval_min_us, data.interval_mean_us, data.interval_max_us, data.jitter_us);
+
+    for (i = 0; i < PLAYER_STATS_BUCKETS; i++)
+    {
+        if (s_bucket_limits[i] == G_MAXINT64)
+            g_string_append_printf(json, "%s{\"le_us\":null,\"count\":%" G_GUINT64_FORMAT "}", i ? "," : "", data.histogram[i]);
+        else
+            g_string_append_printf(json, "%s{\"le_us\":%" G_GINT64_FORMAT ",\"count\":%" G_GUINT64_FORMAT "}", i ? "," : "",
+                    s_bucket_limits[i], data.histogram[i]);
+    }
+    g_string_append(json, "]}\n");
+
+    return g_string_free(json, FALSE);
+}
+
+/* path "-" writes to stdout*/
+int8_t player_stats_dump(player_instance_t *player_instance, const char *path)
+{
+    gchar *json = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (path != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    json = player_stats_to_json(player_instance);
+    if (json == NULL)
+        goto safe_exit;
+
+    if (g_strcmp0(path, "-") == 0)
+    {
+        fputs(json, stdout);
+        fflush(stdout);
+        ret_status = 0;
+    }
+    else if (g_file_set_contents(path, json, -1, NULL))
+        ret_status = 0;
+    else
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Write Frame Stats %s xxxxxxxxxx\n", path);
+
+safe_exit:
+    if (json)
+        g_free(json);
+    return ret_status;
+}
@@ -0,0 +1,497 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <glib/gstdio.h>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-align"
+#pragma GCC diagnostic ignored "-Wconversion"
+#include <gst/video/video.h>
+#pragma GCC diagnostic pop
+
+#include <player.h>
+#include <player_thumbs.h>
+
+/* GstPlayFlags is private to playbin*/
+#define S_PLAY_FLAG_VIDEO (1 << 0)
+
+#define S_THUMBS_MAGIC 0x42485449 /* "ITHB"*/
+#define S_THUMBS_VERSION 1
+#define S_THUMBS_PREROLL_TIMEOUT (5 * GST_SECOND)
+
+typedef struct
+{
+    guint32 magic;
+    guint32 version;
+    guint32 width;
+    guint32 height;
+    guint32 count;
+    guint32 reserved;
+    gint64 interval;
+}s_thumbs_header_t;
+
+struct player_thumbs
+{
+    player_instance_t *player_instance;
+    player_thumbs_config_t config;
+    gchar *uri;
+    gchar *cache_path;
+    GThread *thread;
+    gint cancel;                /* atomic*/
+    guint ready_id;             /* main context idle delivering the result*/
+    player_thumbs_ready_cb ready_cb;
+    gpointer user_data;
+    gboolean ready;
+    player_thumbs_strip_t strip;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* the calling thread only, on Linux the policy is per thread*/
+static void s_thumbs_lower_priority(void)
+{
+    struct sched_param param;
+
+    memset(&param, 0, sizeof(param));
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0)
+        I_LOG_DEBUG("SCHED_IDLE not available for the thumbnail thread\n");
+    return;
+}
+
+/* streaming threads post STREAM_STATUS ENTER from themselves before they run*/
+static GstBusSyncReply s_thumbs_sync_handler(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    GstStreamStatusType type;
+    GstElement *owner = NULL;
+
+    if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_STATUS)
+    {
+        gst_message_parse_stream_status (message, &type, &owner);
+        if (type == GST_STREAM_STATUS_TYPE_ENTER)
+            s_thumbs_lower_priority();
+    }
+    return GST_BUS_PASS;
+}
+
+static gchar *s_thumbs_cache_path(const gchar *uri, const player_thumbs_config_t *config)
+{
+    gchar *location = NULL, *key = NULL, *digest = NULL, *name = NULL, *path = NULL;
+    gint64 mtime = 0, size = 0;
+    GStatBuf st;
+
+    /* a changed local file gets a new key, remote uris only by name*/
+    location = g_filename_from_uri (uri, NULL, NULL);
+    if (location && g_stat (location, &st) == 0)
+    {
+        mtime = (gint64)st.st_mtime;
+        size = (gint64)st.st_size;
+    }
+    g_free(location);
+
+    key = g_strdup_printf("%s|%ux%u|%" G_GINT64_FORMAT "|%" G_GINT64_FORMAT "|%" G_GINT64_FORMAT,
+            uri, config->width, config->height, config->interval, mtime, size);
+    digest = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+    name = g_strconcat (digest, ".thumbs", NULL);
+    path = g_build_filename (g_get_user_cache_dir(), "i_player", "thumbs", name, NULL);
+
+    g_free(name);
+    g_free(digest);
+    g_free(key);
+    return path;
+}
+
+static gboolean s_thumbs_cache_load(struct player_thumbs *thumbs)
+{
+    gchar *contents = NULL;
+    gsize length = 0, pixels_size;
+    s_thumbs_header_t header;
+    gint64 start = g_get_monotonic_time();
+
+    if (!g_file_get_contents (thumbs->cache_path, &contents, &length, NULL))
+        return FALSE;
+
+    if (length < sizeof(header))
+        goto invalid;
+    memcpy(&header, contents, sizeof(header));
+    pixels_size = (gsize)header.width * header.height * PLAYER_THUMBS_BYTES_PER_PIXEL * header.count;
+    if (header.magic != S_THUMBS_MAGIC || header.version != S_THUMBS_VERSION || header.width != thumbs->config.width ||
+            header.height != thumbs->config.height || header.count == 0 || length != sizeof(header) + pixels_size)
+        goto invalid;
+
+    thumbs->strip.width = header.width;
+    thumbs->strip.height = header.height;
+    thumbs->strip.count = header.count;
+    thumbs->strip.interval = header.interval;
+    thumbs->strip.pixels = g_malloc(pixels_size);
+    memcpy(thumbs->strip.pixels, contents + sizeof(header), pixels_size);
+    thumbs->strip.from_cache = TRUE;
+    thumbs->strip.build_us = g_get_monotonic_time() - start;
+    g_free(contents);
+    return TRUE;
+
+invalid:
+    I_LOG_WARNING("!!!!!!!!!! Ignoring invalid thumbnail cache %s !!!!!!!!!!\n", thumbs->cache_path);
+    g_free(contents);
+    return FALSE;
+}
+
+static void s_thumbs_cache_store(struct player_thumbs *thumbs)
+{
+    s_thumbs_header_t header;
+    gsize pixels_size = (gsize)thumbs->strip.width * thumbs->strip.height * PLAYER_THUMBS_BYTES_PER_PIXEL * thumbs->strip.count;
+    gchar *contents = NULL, *dir = NULL;
+    GError *error = NULL;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = S_THUMBS_MAGIC;
+    header.version = S_THUMBS_VERSION;
+    header.width = thumbs->strip.width;
+    header.height = thumbs->strip.height;
+    header.count = thumbs->strip.count;
+    header.interval = thumbs->strip.interval;
+
+    contents = g_malloc(sizeof(header) + pixels_size);
+    memcpy(contents, &header, sizeof(header));
+    memcpy(contents + sizeof(header), thumbs->strip.pixels, pixels_size);
+
+    dir = g_path_get_dirname (thumbs->cache_path);
+    g_mkdir_with_parents (dir, 0755);
+    /* written to a temporary file and renamed, a reader never sees half a strip*/
+    if (!g_file_set_contents (thumbs->cache_path, contents, (gssize)(sizeof(header) + pixels_size), &error))
+    {
+        I_LOG_WARNING("!!!!!!!!!! Couldnt store thumbnails : %s !!!!!!!!!!\n", error->message);
+        g_error_free(error);
+    }
+    g_free(dir);
+    g_free(contents);
+    return;
+}
+
+static GstElement *s_thumbs_make_pipeline(struct player_thumbs *thumbs, GstElement **appsink)
+{
+    GstElement *pipeline = NULL, *video_sink = NULL, *audio_sink = NULL;
+    GstBus *bus = NULL;
+    gchar *description = NULL;
+    GError *error = NULL;
+
+    pipeline = gst_element_factory_make ("playbin", NULL);
+    description = g_strdup_printf("videoconvert ! videoscale ! video/x-raw,format=RGB16,width=%u,height=%u,pixel-aspect-ratio=1/1 ! "
+            "appsink name=thumbs_sink sync=false max-buffers=1", thumbs->config.width, thumbs->config.height);
+    video_sink = gst_parse_bin_from_description (description, TRUE, &error);
+    audio_sink = gst_element_factory_make ("fakesink", NULL);
+    g_free(description);
+
+    if (pipeline == NULL || video_sink == NULL || audio_sink == NULL)
+    {
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Create Thumbnail Pipeline %s xxxxxxxxxx\n", (error) ? error->message : "");
+        if (error)
+            g_error_free(error);
+        if (pipeline)
+            gst_object_unref (pipeline);
+        if (video_sink)
+            gst_object_unref (gst_object_ref_sink (video_sink));
+        if (audio_sink)
+            gst_object_unref (gst_object_ref_sink (audio_sink));
+        return NULL;
+    }
+
+    *appsink = gst_bin_get_by_name (GST_BIN (video_sink), "thumbs_sink");
+    g_object_set (pipeline, "uri", thumbs->uri, "flags", S_PLAY_FLAG_VIDEO, "video-sink", video_sink, "audio-sink", audio_sink, NULL);
+    bus = gst_element_get_bus (pipeline);
+    gst_bus_set_sync_handler (bus, s_thumbs_sync_handler, NULL, NULL);
+    gst_object_unref (bus);
+    return pipeline;
+}
+
+/* Copies the pre-rolled frame into slot index of the strip*/
+static gboolean s_thumbs_take_frame(struct player_thumbs *thumbs, GstElement *appsink, guint index)
+{
+    GstSample *sample = NULL;
+    GstBuffer *buffer = NULL;
+    GstVideoMeta *meta = NULL;
+    GstVideoInfo info;
+    GstMapInfo map;
+    gsize row_size = (gsize)thumbs->strip.width * PLAYER_THUMBS_BYTES_PER_PIXEL;
+    guint8 *dest = thumbs->strip.pixels + row_size * thumbs->strip.height * index;
+    gsize offset;
+    gint stride;
+    guint row;
+    gboolean taken = FALSE;
+
+    g_signal_emit_by_name (appsink, "pull-preroll", &sample);
+    if (sample == NULL)
+        return FALSE;
+
+    buffer = gst_sample_get_buffer (sample);
+    gst_video_info_init (&info);
+    if (buffer == NULL || !gst_video_info_from_caps (&info, gst_sample_get_caps (sample)) ||
+            (guint)GST_VIDEO_INFO_WIDTH (&info) != thumbs->strip.width || (guint)GST_VIDEO_INFO_HEIGHT (&info) != thumbs->strip.height)
+    {
+        gst_sample_unref (sample);
+        return FALSE;
+    }
+
+    /* the layout of the buffer wins over the one implied by the caps*/
+    stride = GST_VIDEO_INFO_PLANE_STRIDE (&info, 0);
+    offset = GST_VIDEO_INFO_PLANE_OFFSET (&info, 0);
+    meta = gst_buffer_get_video_meta (buffer);
+    if (meta)
+    {
+        stride = meta->stride[0];
+        offset = meta->offset[0];
+    }
+
+    if (stride >= (gint)row_size && gst_buffer_map (buffer, &map, GST_MAP_READ))
+    {
+        if (map.size >= offset + (gsize)stride * (thumbs->strip.height - 1) + row_size)
+        {
+            for (row = 0; row < thumbs->strip.height; row++)
+                memcpy(dest + row * row_size, map.data + offset + row * (gsize)stride, row_size);
+            taken = TRUE;
+        }
+        gst_buffer_unmap (buffer, &map);
+    }
+    gst_sample_unref (sample);
+    return taken;
+}
+
+static gboolean s_thumbs_extract(struct player_thumbs *thumbs)
+{
+    GstElement *pipeline = NULL, *appsink = NULL;
+    gint64 duration = -1, start = g_get_monotonic_time(), frame_start, frame_us;
+    guint index, count;
+    gboolean built = FALSE;
+
+    pipeline = s_thumbs_make_pipeline(thumbs, &appsink);
+    if (pipeline == NULL)
+        return FALSE;
+
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+    if (gst_element_get_state (pipeline, NULL, NULL, S_THUMBS_PREROLL_TIMEOUT) != GST_STATE_CHANGE_SUCCESS ||
+            !gst_element_query_duration (pipeline, GST_FORMAT_TIME, &duration) || duration <= 0)
+    {
+        I_LOG_WARNING("!!!!!!!!!! No thumbnails for %s, not pre-rolled or no duration !!!!!!!!!!\n", thumbs->uri);
+        goto done;
+    }
+
+    count = (guint)MIN(duration / thumbs->config.interval + 1, PLAYER_THUMBS_MAX_COUNT);
+    thumbs->strip.width = thumbs->config.width;
+    thumbs->strip.height = thumbs->config.height;
+    thumbs->strip.interval = thumbs->config.interval;
+    thumbs->strip.pixels = g_malloc0((gsize)thumbs->strip.width * thumbs->strip.height * PLAYER_THUMBS_BYTES_PER_PIXEL * count);
+
+    for (index = 0; index < count && !g_atomic_int_get(&thumbs->cancel); index++)
+    {
+        frame_start = g_get_monotonic_time();
+        /* key unit, the decoder only has to decode the key frame before the position*/
+        if (!gst_element_seek_simple (pipeline, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE,
+                    thumbs->config.interval * index) ||
+                gst_element_get_state (pipeline, NULL, NULL, S_THUMBS_PREROLL_TIMEOUT) != GST_STATE_CHANGE_SUCCESS ||
+                !s_thumbs_take_frame(thumbs, appsink, index))
+        {
+            /* the slot stays black*/
+            I_LOG_DEBUG("No thumbnail %u of %s\n", index, thumbs->uri);
+            thumbs->strip.missing++;
+        }
+
+        /* at most half of a core even when SCHED_IDLE has nothing to yield to*/
+        frame_us = g_get_monotonic_time() - frame_start;
+        g_usleep((gulong)frame_us);
+    }
+
+    if (index == count)
+    {
+        thumbs->strip.count = count;
+        thumbs->strip.build_us = g_get_monotonic_time() - start;
+        built = TRUE;
+    }
+
+done:
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (appsink);
+    gst_object_unref (pipeline);
+    return built;
+}
+
+/* main context*/
+static gboolean s_thumbs_ready_idle(gpointer user_data)
+{
+    struct player_thumbs *thumbs = (struct player_thumbs *) user_data;
+
+    /* the worker may still be storing ready_id*/
+    g_thread_join (thumbs->thread);
+    thumbs->thread = NULL;
+    thumbs->ready_id = 0;
+
+    if (thumbs->strip.count)
+        I_LOG_INFO("========== %u thumbnails %ux%u built in %" G_GINT64_FORMAT " ms, %u missing ==========\n", thumbs->strip.count,
+                thumbs->strip.width, thumbs->strip.height, thumbs->strip.build_us / 1000, thumbs->strip.missing);
+    thumbs->ready = TRUE;
+    if (thumbs->ready_cb)
+        thumbs->ready_cb(thumbs->player_instance, (thumbs->strip.count) ? &thumbs->strip : NULL, thumbs->user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer s_thumbs_worker(gpointer data)
+{
+    struct player_thumbs *thumbs = (struct player_thumbs *) data;
+
+    s_thumbs_lower_priority();
+    if (s_thumbs_extract(thumbs))
+    {
+        /* a later request tries the failed positions again*/
+        if (thumbs->strip.missing == 0)
+            s_thumbs_cache_store(thumbs);
+        else
+            I_LOG_WARNING("!!!!!!!!!! %u of %u thumbnails missing for %s, strip not cached !!!!!!!!!!\n",
+                    thumbs->strip.missing, thumbs->strip.count, thumbs->uri);
+    }
+    else
+    {
+        g_free(thumbs->strip.pixels);
+        memset(&thumbs->strip, 0, sizeof(thumbs->strip));
+    }
+
+    if (!g_atomic_int_get(&thumbs->cancel))
+        thumbs->ready_id = g_idle_add (s_thumbs_ready_idle, thumbs);
+    return NULL;
+}
+
+static void s_thumbs_free(struct player_thumbs *thumbs)
+{
+    g_atomic_int_set(&thumbs->cancel, 1);
+    if (thumbs->thread)
+        g_thread_join (thumbs->thread);
+    if (thumbs->ready_id)
+        g_source_remove (thumbs->ready_id);
+    g_free(thumbs->strip.pixels);
+    g_free(thumbs->cache_path);
+    g_free(thumbs->uri);
+    g_free(thumbs);
+    return;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_thumbs_config_init(player_thumbs_config_t *config)
+{
+    if (config == NULL)
+        return;
+
+    config->width = PLAYER_THUMBS_DEFAULT_WIDTH;
+    config->height = PLAYER_THUMBS_DEFAULT_HEIGHT;
+    config->interval = PLAYER_THUMBS_DEFAULT_INTERVAL;
+    return;
+}
+
+/* Strip of the player's current uri. A cache hit calls ready_cb before returning,
+ * otherwise it is called from the main context once the strip is built. Main context*/
+int8_t player_thumbs_request(player_instance_t *player_instance, const player_thumbs_config_t *config,
+        player_thumbs_ready_cb ready_cb, gpointer user_data)
+{
+    struct player_thumbs *thumbs = NULL;
+    GError *error = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->src_uri != NULL && config != NULL &&
+                    config->width > 0 && config->height > 0 && config->interval > 0), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    /* a new request replaces the previous strip*/
+    player_thumbs_release(player_instance);
+
+    thumbs = g_new0(struct player_thumbs, 1);
+    thumbs->player_instance = player_instance;
+    thumbs->config = *config;
+    thumbs->uri = player_playlist_dup_current_uri(player_instance);
+    thumbs->cache_path = s_thumbs_cache_path(thumbs->uri, config);
+    thumbs->ready_cb = ready_cb;
+    thumbs->user_data = user_data;
+    player_instance->thumbs = thumbs;
+
+    if (s_thumbs_cache_load(thumbs))
+    {
+        I_LOG_DEBUG("Thumbnails from cache in %" G_GINT64_FORMAT " us\n", thumbs->strip.build_us);
+        thumbs->ready = TRUE;
+        if (ready_cb)
+            ready_cb(player_instance, &thumbs->strip, user_data);
+    }
+    else
+    {
+        thumbs->thread = g_thread_try_new ("i_player_thumbs", s_thumbs_worker, thumbs, &error);
+        if (thumbs->thread == NULL)
+        {
+            I_LOG_ERROR("xxxxxxxxxx Couldnt Create Thumbnail Thread : %s xxxxxxxxxx\n", (error) ? error->message : "");
+            if (error)
+                g_error_free(error);
+            player_instance->thumbs = NULL;
+            s_thumbs_free(thumbs);
+            goto safe_exit;
+        }
+    }
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+/* NULL until the strip of the last request is ready*/
+const player_thumbs_strip_t *player_thumbs_get(player_instance_t *player_instance)
+{
+    if (player_instance == NULL || player_instance->thumbs == NULL || !player_instance->thumbs->ready ||
+            player_instance->thumbs->strip.count == 0)
+        return NULL;
+
+    return &player_instance->thumbs->strip;
+}
+
+/* The thumbnail shown for a position in ns*/
+const guint8 *player_thumbs_at(const player_thumbs_strip_t *strip, gint64 position)
+{
+    guint index;
+
+    if (strip == NULL || strip->count == 0 || strip->interval <= 0)
+        return NULL;
+
+    index = (guint)CLAMP((position + strip->interval / 2) / strip->interval, 0, (gint64)strip->count - 1);
+    return strip->pixels + (gsize)strip->width * strip->height * PLAYER_THUMBS_BYTES_PER_PIXEL * index;
+}
+
+/* Stops an extraction still running*/
+void player_thumbs_release(player_instance_t *player_instance)
+{
+    if (player_instance == NULL || player_instance->thumbs == NULL)
+        return;
+
+    s_thumbs_free(player_instance->thumbs);
+    player_instance->thumbs = NULL;
+    return;
+}
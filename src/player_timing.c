@@ -0,0 +1,252 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <player.h>
+#include <player_timing.h>
+
+static const char *s_checkpoint_names[PLAYER_TIMING_MAX] =
+{
+    "process_start",
+    "window_system_init",
+    "gst_init",
+    "player_init",
+    "get_handler",
+    "play",
+    "first_state_changed",
+    "first_media_info",
+    "first_frame"
+};
+
+static GMutex s_timing_lock;
+static gint64 s_marks[PLAYER_TIMING_MAX];
+static gchar *s_report_path = NULL;
+static gboolean s_report_written = FALSE;
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* Time from exec to main(), mostly the dynamic loader pulling in gstreamer. Clock tick resolution (10ms)*/
+static gint64 s_timing_exec_to_main(void)
+{
+    gchar *stat = NULL;
+    gchar *fields = NULL;
+    gint64 exec_to_main = -1;
+
+    if (g_file_get_contents("/proc/self/stat", &stat, NULL, NULL) == FALSE)
+        return -1;
+
+    /* skip "pid (comm)", comm may contain spaces*/
+    fields = strrchr(stat, ')');
+    if (fields)
+    {
+        guint64 start_ticks = 0;
+        struct timespec now;
+        int field;
+        gchar *cursor = fields + 2;
+
+        /* starttime is field 22, cursor is at field 3*/
+        for (field = 3; field < 22 && cursor; field++)
+        {
+            cursor = strchr(cursor, ' ');
+            if (cursor)
+                cursor++;
+        }
+        if (cursor && clock_gettime(CLOCK_BOOTTIME, &now) == 0)
+        {
+            gint64 boot_now;
+            start_ticks = g_ascii_strtoull(cursor, NULL, 10);
+            boot_now = ((gint64)now.tv_sec * G_USEC_PER_SEC) + (now.tv_nsec / 1000);
+            /* shift by the time already spent since main()*/
+            exec_to_main = boot_now - (gint64)(start_ticks * G_USEC_PER_SEC / (guint64)sysconf(_SC_CLK_TCK))
+                - (g_get_monotonic_time() - s_marks[PLAYER_TIMING_PROCESS_START]);
+            if (exec_to_main < 0)
+                exec_to_main = 0;
+        }
+    }
+    g_free(stat);
+    return exec_to_main;
+}
+
+/* main context, the first frame is marked from a streaming thread*/
+static gboolean s_timing_report_cb(gpointer user_data)
+{
+    player_timing_finish();
+    return G_SOURCE_REMOVE;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+void player_timing_mark(player_timing_checkpoint_e checkpoint)
+{
+    gint64 now = g_get_monotonic_time();
+
+    if (checkpoint >= PLAYER_TIMING_MAX)
+        return;
+
+    g_mutex_lock(&s_timing_lock);
+    if (s_marks[checkpoint] == 0)
+    {
+        s_marks[checkpoint] = now;
+        if (checkpoint != PLAYER_TIMING_PROCESS_START && s_marks[PLAYER_TIMING_PROCESS_START])
+            I_LOG_DEBUG("Startup checkpoint %s at %" G_GINT64_FORMAT " us\n", s_checkpoint_names[checkpoint],
+                    now - s_marks[PLAYER_TIMING_PROCESS_START]);
+        if (checkpoint == PLAYER_TIMING_FIRST_FRAME && s_report_path)
+            g_main_context_invoke(NULL, s_timing_report_cb, NULL);
+    }
+    g_mutex_unlock(&s_timing_lock);
+    return;
+}
+
+/* Write the report to path ("-" for stdout) once the first frame is shown, or from player_timing_finish()*/
+void player_timing_set_report(const char *path)
+{
+    g_mutex_lock(&s_timing_lock);
+    g_free(s_report_path);
+    s_report_path = g_strdup(path);
+    s_report_written = FALSE;
+    g_mutex_unlock(&s_timing_lock);
+    return;
+}
+
+/* Writes the report if one was requested and not written yet*/
+void player_timing_finish(void)
+{
+    gchar *path = NULL;
+
+    g_mutex_lock(&s_timing_lock);
+    if (s_report_path && s_report_written == FALSE)
+    {
+        path = g_strdup(s_report_path);
+        s_report_written = TRUE;
+    }
+    g_mutex_unlock(&s_timing_lock);
+
+    if (path)
+    {
+        player_timing_write_report(path);
+        g_free(path);
+    }
+    return;
+}
+
+/* Microseconds since PLAYER_TIMING_PROCESS_START, -1 if not reached*/
+gint64 player_timing_get(player_timing_checkpoint_e checkpoint)
+{
+    gint64 at = -1;
+
+    if (checkpoint >= PLAYER_TIMING_MAX)
+        return -1;
+
+    g_mutex_lock(&s_timing_lock);
+    if (s_marks[checkpoint] && s_marks[PLAYER_TIMING_PROCESS_START])
+        at = s_marks[checkpoint] - s_marks[PLAYER_TIMING_PROCESS_START];
+    g_mutex_unlock(&s_timing_lock);
+    return at;
+}
+
+/* Free with g_free*/
+gchar *player_timing_report_json(void)
+{
+    GString *json = g_string_new(NULL);
+    gint64 marks[PLAYER_TIMING_MAX];
+    int order[PLAYER_TIMING_MAX];
+    gint64 previous = 0;
+    gboolean first = TRUE;
+    int i;
+
+    g_mutex_lock(&s_timing_lock);
+    memcpy(marks, s_marks, sizeof(marks));
+    g_mutex_unlock(&s_timing_lock);
+
+    g_string_append_printf(json, "{\"unit\":\"us\",\"exec_to_main\":%" G_GINT64_FORMAT ",\"checkpoints\":[",
+            marks[PLAYER_TIMING_PROCESS_START] ? s_timing_exec_to_main() : -1);
+
+    /* Steps may overlap (display init runs beside gst_init), list them in the order they were reached*/
+    for (i = 0; i < PLAYER_TIMING_MAX; i++)
+        order[i] = i;
+    for (i = 1; i < PLAYER_TIMING_MAX; i++)
+    {
+        int j = i;
+        while (j > 0 && marks[order[j - 1]] > marks[order[j]])
+        {
+            int swap = order[j - 1];
+            order[j - 1] = order[j];
+            order[j] = swap;
+            j--;
+        }
+    }
+
+    previous = marks[PLAYER_TIMING_PROCESS_START];
+    for (i = 0; i < PLAYER_TIMING_MAX && previous; i++)
+    {
+        int checkpoint = order[i];
+
+        if (marks[checkpoint] == 0 || checkpoint == PLAYER_TIMING_PROCESS_START)
+            continue;
+        g_string_append_printf(json, "%s{\"name\":\"%s\",\"at\":%" G_GINT64_FORMAT ",\"phase\":%" G_GINT64_FORMAT "}",
+                first ? "" : ",", s_checkpoint_names[checkpoint], marks[checkpoint] - marks[PLAYER_TIMING_PROCESS_START],
+                marks[checkpoint] - previous);
+        previous = marks[checkpoint];
+        first = FALSE;
+    }
+    g_string_append_printf(json, "],\"time_to_first_frame\":%" G_GINT64_FORMAT "}\n",
+            (marks[PLAYER_TIMING_FIRST_FRAME] && marks[PLAYER_TIMING_PROCESS_START]) ?
+            marks[PLAYER_TIMING_FIRST_FRAME] - marks[PLAYER_TIMING_PROCESS_START] : -1);
+
+    return g_string_free(json, FALSE);
+}
+
+/* path "-" writes to stdout*/
+int8_t player_timing_write_report(const char *path)
+{
+    gchar *json = NULL;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (path != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    json = player_timing_report_json();
+    if (g_strcmp0(path, "-") == 0)
+    {
+        fputs(json, stdout);
+        fflush(stdout);
+        ret_status = 0;
+    }
+    else if (g_file_set_contents(path, json, -1, NULL))
+        ret_status = 0;
+    else
+        I_LOG_ERROR("xxxxxxxxxx Couldnt Write Startup Report %s xxxxxxxxxx\n", path);
+
+safe_exit:
+    if (json)
+        g_free(json);
+    return ret_status;
+}
@@ -0,0 +1,281 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+#include <player.h>
+#include <player_seek.h>
+#include <player_trick.h>
+
+/* player_step_rate walks this ladder*/
+static const gdouble s_trick_rates[] = { -32.0, -16.0, -8.0, -4.0, -2.0, 1.0, 2.0, 4.0, 8.0, 16.0, 32.0 };
+
+struct player_trick
+{
+    GMutex lock;
+    GstPad *sink_pad;
+    gulong probe_id;
+    player_trick_load_t loads[PLAYER_TRICK_MAX_LOADS];
+    guint n_loads;
+    gdouble rate;               /* of the running segment*/
+    gint64 segment_start;       /* monotonic us*/
+    gint64 segment_cpu;
+    guint64 segment_frames;
+};
+
+/* ********** All Static Functions Defined Here ***********/
+
+static gint64 s_trick_cpu_us(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return ((gint64)usage.ru_utime.tv_sec + (gint64)usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+        (gint64)usage.ru_utime.tv_usec + (gint64)usage.ru_stime.tv_usec;
+}
+
+/* video streaming thread*/
+static GstPadProbeReturn s_trick_sink_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    struct player_trick *trick = (struct player_trick *) user_data;
+
+    g_mutex_lock(&trick->lock);
+    trick->segment_frames++;
+    g_mutex_unlock(&trick->lock);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static player_trick_load_t *s_trick_load_for(struct player_trick *trick, gdouble rate)
+{
+    guint i;
+
+    for (i = 0; i < trick->n_loads; i++)
+    {
+        if (!(trick->loads[i].rate < rate) && !(trick->loads[i].rate > rate))
+            return &trick->loads[i];
+    }
+    if (trick->n_loads == PLAYER_TRICK_MAX_LOADS)
+        return NULL;
+
+    trick->loads[trick->n_loads].rate = rate;
+    return &trick->loads[trick->n_loads++];
+}
+
+/* Adds the running segment to its rate, called with the lock held*/
+static void s_trick_close_segment(struct player_trick *trick, player_trick_load_t *loads, gint64 now, gint64 cpu)
+{
+    player_trick_load_t *load = s_trick_load_for(trick, trick->rate);
+
+    if (load == NULL)
+        return;
+
+    /* loads may be a copy for player_trick_get_load*/
+    load = &loads[load - trick->loads];
+    load->wall_us += now - trick->segment_start;
+    load->cpu_us += cpu - trick->segment_cpu;
+    load->frames += trick->segment_frames;
+    return;
+}
+
+static struct player_trick *s_trick_get(player_instance_t *player_instance)
+{
+    struct player_trick *trick = player_instance->trick;
+    GstPad *pad = NULL;
+
+    if (trick)
+        return trick;
+
+    trick = g_new0(struct player_trick, 1);
+    g_mutex_init(&trick->lock);
+    trick->rate = player_instance->rate;
+    trick->segment_start = g_get_monotonic_time();
+    trick->segment_cpu = s_trick_cpu_us();
+
+    pad = player_get_video_sink_pad(player_instance);
+    if (pad)
+    {
+        trick->sink_pad = pad;
+        trick->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, s_trick_sink_probe, trick, NULL);
+    }
+    else
+        I_LOG_DEBUG("No video sink yet, trick mode frames are not counted\n");
+
+    player_instance->trick = trick;
+    return trick;
+}
+
+/* ********** All Global Functions Defined Here ***********/
+
+/* Negative rates play backwards, 1.0 is normal playback. Main context*/
+int8_t player_set_rate(player_instance_t *player_instance, gdouble rate)
+{
+    struct player_trick *trick = NULL;
+    gint64 position = -1, now, cpu;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL && player_instance->pipeline != NULL && (rate > 0.0 || rate < 0.0) &&
+                    ABS(rate) <= PLAYER_TRICK_MAX_RATE), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    if (player_query_position (player_instance, &position) != 0)
+    {
+        I_LOG_WARNING("!!!!!!!!!! Could Not Change Rate, No Position !!!!!!!!!!\n");
+        goto safe_exit;
+    }
+
+    if (player_seek_set_rate(player_instance, position, rate) != 0)
+        goto safe_exit;
+
+    trick = s_trick_get(player_instance);
+    now = g_get_monotonic_time();
+    cpu = s_trick_cpu_us();
+    g_mutex_lock(&trick->lock);
+    s_trick_close_segment(trick, trick->loads, now, cpu);
+    trick->rate = rate;
+    trick->segment_start = now;
+    trick->segment_cpu = cpu;
+    trick->segment_frames = 0;
+    g_mutex_unlock(&trick->lock);
+
+    I_LOG_INFO("========== Rate %.2fx%s ==========\n", rate, PLAYER_RATE_IS_TRICK(rate) ? ", key frames only" : "");
+    player_instance->rate = rate;
+    ret_status = 0;
+
+safe_exit:
+    return ret_status;
+}
+
+gdouble player_get_rate(player_instance_t *player_instance)
+{
+    return (player_instance) ? player_instance->rate : 1.0;
+}
+
+/* Next rate of the ladder, forward from a reverse rate slows the rewind down first*/
+int8_t player_step_rate(player_instance_t *player_instance, gboolean forward)
+{
+    guint count = G_N_ELEMENTS(s_trick_rates), i;
+    gdouble rate;
+    int8_t ret_status = -1;
+
+    I_ARG_CHECK( (player_instance != NULL), /* Check this condition*/
+                    ret_status, /* On error return this*/
+                    -1); /* with this value*/
+
+    rate = player_instance->rate;
+    if (forward)
+    {
+        i = 0;
+        while (i < count - 1 && !(s_trick_rates[i] > rate))
+            i++;
+    }
+    else
+    {
+        i = count - 1;
+        while (i > 0 && !(s_trick_rates[i] < rate))
+            i--;
+    }
+    ret_status = player_set_rate(player_instance, s_trick_rates[i]);
+
+safe_exit:
+    return ret_status;
+}
+
+/* Fills up to max_loads entries, the rate currently played included. Returns the number filled*/
+guint player_trick_get_load(player_instance_t *player_instance, player_trick_load_t *loads, guint max_loads)
+{
+    struct player_trick *trick = NULL;
+    player_trick_load_t current[PLAYER_TRICK_MAX_LOADS];
+    guint count, i;
+
+    if (player_instance == NULL || player_instance->trick == NULL || loads == NULL)
+        return 0;
+
+    trick = player_instance->trick;
+    g_mutex_lock(&trick->lock);
+    s_trick_load_for(trick, trick->rate);
+    memcpy(current, trick->loads, sizeof(current));
+    s_trick_close_segment(trick, current, g_get_monotonic_time(), s_trick_cpu_us());
+    count = MIN(trick->n_loads, max_loads);
+    g_mutex_unlock(&trick->lock);
+
+    for (i = 0; i < count; i++)
+    {
+        loads[i] = current[i];
+        if (loads[i].wall_us > 0)
+        {
+            loads[i].fps = (gdouble)loads[i].frames * G_USEC_PER_SEC / (gdouble)loads[i].wall_us;
+            loads[i].cpu_percent = (gdouble)loads[i].cpu_us * 100.0 / (gdouble)loads[i].wall_us;
+        }
+    }
+    return count;
+}
+
+void player_trick_log_load(player_instance_t *player_instance)
+{
+    player_trick_load_t loads[PLAYER_TRICK_MAX_LOADS];
+    guint count, i;
+
+    count = player_trick_get_load(player_instance, loads, PLAYER_TRICK_MAX_LOADS);
+    if (count == 0)
+        return;
+
+    I_LOG_INFO("========== Decode load per rate [%s] ==========\n", player_instance->player_name);
+    for (i = 0; i < count; i++)
+    {
+        I_LOG_INFO("%6.2fx : %.1f s, %" G_GUINT64_FORMAT " frames (%.1f fps), cpu %.1f %%\n", loads[i].rate,
+                (gdouble)loads[i].wall_us / G_USEC_PER_SEC, loads[i].frames, loads[i].fps, loads[i].cpu_percent);
+    }
+    return;
+}
+
+/* Call once GstPlayer is stopped, logs the load*/
+void player_trick_release(player_instance_t *player_instance)
+{
+    struct player_trick *trick = NULL;
+
+    if (player_instance == NULL || player_instance->trick == NULL)
+        return;
+
+    player_trick_log_load(player_instance);
+
+    trick = player_instance->trick;
+    if (trick->sink_pad)
+    {
+        gst_pad_remove_probe (trick->sink_pad, trick->probe_id);
+        gst_object_unref (trick->sink_pad);
+    }
+    player_instance->trick = NULL;
+
+    g_mutex_clear(&trick->lock);
+    g_free(trick);
+    return;
+}
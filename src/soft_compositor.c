@@ -0,0 +1,797 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "player.h"
+#include "soft_compositor.h"
+
+#define SOFT_DISPLAY_HANDLE 1
+
+typedef enum
+{
+  SOFT_OP_ADD = 1,
+  SOFT_OP_CHANGE,
+  SOFT_OP_SOURCE,
+  SOFT_OP_REMOVE
+}soft_op_type_e;
+
+typedef struct
+{
+  soft_op_type_e type;
+  DISPMANX_ELEMENT_HANDLE_T element;
+  uint32_t change_flags;
+  soft_compositor_element_t attr;
+}soft_op_t;
+
+typedef struct
+{
+  VC_IMAGE_TYPE_T type;
+  uint32_t width;
+  uint32_t height;
+  uint32_t *pixels; /* ARGB8888*/
+}soft_resource_t;
+
+typedef struct
+{
+  gboolean visible;
+  guint64 order;
+  DISPMANX_FLAGS_ALPHA_T alpha_flags;
+  soft_compositor_element_t attr;
+}soft_element_t;
+
+typedef struct
+{
+  DISPMANX_UPDATE_HANDLE_T update; /* 0 stops the submit thread*/
+  DISPMANX_CALLBACK_FUNC_T cb_func;
+  void *cb_arg;
+}soft_submit_t;
+
+typedef struct
+{
+  GMutex lock;
+  gboolean open;
+  int32_t width;
+  int32_t height;
+  guint vsync_hz;
+  gint64 last_vsync;
+  guint64 next_order;
+  GPtrArray *resources; /* handle - 1 => soft_resource_t*/
+  GPtrArray *elements;  /* handle - 1 => soft_element_t*/
+  GPtrArray *updates;   /* handle - 1 => GArray of soft_op_t*/
+  GAsyncQueue *submits; /* soft_submit_t for the async submit thread*/
+  GThread *submit_thread;
+  soft_compositor_stats_t stats;
+}soft_compositor_t;
+
+static soft_compositor_t s_soft;
+
+/* ********** All Static Functions Defined Here ***********/
+
+/* Returns a 1 based handle for ptr, re-using free slots*/
+static uint32_t s_soft_slot_insert(GPtrArray *array, gpointer ptr)
+{
+  guint i;
+
+  for(i = 0; i < array->len; i++)
+  {
+    if(g_ptr_array_index(array, i) == NULL)
+    {
+      g_ptr_array_index(array, i) = ptr;
+      return i + 1;
+    }
+  }
+  g_ptr_array_add(array, ptr);
+  return array->len;
+}
+
+static gpointer s_soft_slot_get(GPtrArray *array, uint32_t handle)
+{
+  if(array == NULL || handle == 0 || handle > array->len)
+    return NULL;
+  return g_ptr_array_index(array, handle - 1);
+}
+
+static uint32_t s_soft_pixel_to_argb(VC_IMAGE_TYPE_T type, const uint8_t *src)
+{
+  uint32_t r, g, b, a;
+  uint16_t v;
+
+  switch(type)
+  {
+    case VC_IMAGE_RGBA16:
+      memcpy(&v, src, sizeof(v));
+      r = (uint32_t)((v >> 12) & 0xF) * 17;
+      g = (uint32_t)((v >> 8) & 0xF) * 17;
+      b = (uint32_t)((v >> 4) & 0xF) * 17;
+      a = (uint32_t)(v & 0xF) * 17;
+      break;
+    case VC_IMAGE_RGB565:
+      memcpy(&v, src, sizeof(v));
+      r = (uint32_t)((v >> 11) & 0x1F) * 255 / 31;
+      g = (uint32_t)((v >> 5) & 0x3F) * 255 / 63;
+      b = (uint32_t)(v & 0x1F) * 255 / 31;
+      a = 255;
+      break;
+    case VC_IMAGE_RGBA32:
+    default:
+      r = src[0];
+      g = src[1];
+      b = src[2];
+      a = src[3];
+      break;
+  }
+  return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+static uint32_t s_soft_bytes_per_pixel(VC_IMAGE_TYPE_T type)
+{
+  return (type == VC_IMAGE_RGBA16 || type == VC_IMAGE_RGB565) ? 2 : 4;
+}
+
+static uint32_t s_soft_blend(uint32_t dst, uint32_t src, uint32_t alpha)
+{
+  uint32_t out = 0xFF000000;
+  uint32_t shift;
+
+  for(shift = 0; shift < 24; shift += 8)
+  {
+    uint32_t s = (src >> shift) & 0xFF;
+    uint32_t d = (dst >> shift) & 0xFF;
+    out |= (((s * alpha) + (d * (255 - alpha)) + 127) / 255) << shift;
+  }
+  return out;
+}
+
+static gint s_soft_element_compare(gconstpointer a, gconstpointer b)
+{
+  const soft_element_t *ea = *(soft_element_t * const *)a;
+  const soft_element_t *eb = *(soft_element_t * const *)b;
+
+  if(ea->attr.layer != eb->attr.layer)
+    return (ea->attr.layer < eb->attr.layer) ? -1 : 1;
+  return (ea->order < eb->order) ? -1 : ((ea->order > eb->order) ? 1 : 0);
+}
+
+/* Caller holds s_soft.lock*/
+static void s_soft_apply_op(const soft_op_t *op)
+{
+  soft_element_t *element = s_soft_slot_get(s_soft.elements, op->element);
+
+  if(element == NULL)
+    return;
+
+  switch(op->type)
+  {
+    case SOFT_OP_ADD:
+      element->visible = TRUE;
+      break;
+    case SOFT_OP_CHANGE:
+      if(op->change_flags & ELEMENT_CHANGE_LAYER)
+        element->attr.layer = op->attr.layer;
+      if(op->change_flags & ELEMENT_CHANGE_OPACITY)
+        element->attr.opacity = op->attr.opacity;
+      if(op->change_flags & ELEMENT_CHANGE_DEST_RECT)
+        element->attr.dst_rect = op->attr.dst_rect;
+      if(op->change_flags & ELEMENT_CHANGE_SRC_RECT)
+        element->attr.src_rect = op->attr.src_rect;
+      s_soft.stats.element_changes++;
+      break;
+    case SOFT_OP_SOURCE:
+      element->attr.resource = op->attr.resource;
+      s_soft.stats.source_changes++;
+      break;
+    case SOFT_OP_REMOVE:
+      g_ptr_array_index(s_soft.elements, op->element - 1) = NULL;
+      g_free(element);
+      s_soft.stats.elements--;
+      break;
+    default:
+      break;
+  }
+  return;
+}
+
+static void s_soft_queue_op(DISPMANX_UPDATE_HANDLE_T update, const soft_op_t *op)
+{
+  GArray *ops = s_soft_slot_get(s_soft.updates, update);
+
+  if(ops)
+    g_array_append_val(ops, *op);
+  return;
+}
+
+/* Simulated vsync, only when I_PLAYER_SOFT_VSYNC_HZ is set*/
+static void s_soft_wait_vsync(void)
+{
+  gint64 period, now, next;
+
+  if(s_soft.vsync_hz == 0)
+    return;
+
+  period = G_USEC_PER_SEC / s_soft.vsync_hz;
+  now = g_get_monotonic_time();
+  next = ((now / period) + 1) * period;
+  g_usleep((gulong)(next - now));
+
+  g_mutex_lock(&s_soft.lock);
+  s_soft.last_vsync = next;
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
+
+/* ********** Backend Implementation ***********/
+
+static void s_soft_init(void)
+{
+  const gchar *env;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft.width <= 0 || s_soft.height <= 0)
+  {
+    s_soft.width = SOFT_COMPOSITOR_DEFAULT_WIDTH;
+    s_soft.height = SOFT_COMPOSITOR_DEFAULT_HEIGHT;
+
+    env = g_getenv("I_PLAYER_SOFT_DISPLAY");
+    if(env)
+    {
+      int w = 0, h = 0;
+      if(sscanf(env, "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+      {
+        s_soft.width = w;
+        s_soft.height = h;
+      }
+    }
+  }
+
+  env = g_getenv("I_PLAYER_SOFT_VSYNC_HZ");
+  s_soft.vsync_hz = env ? (guint)g_ascii_strtoull(env, NULL, 10) : 0;
+
+  if(s_soft.resources == NULL)
+  {
+    s_soft.resources = g_ptr_array_new();
+    s_soft.elements = g_ptr_array_new();
+    s_soft.updates = g_ptr_array_new();
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
+
+static void s_soft_deinit(void)
+{
+  guint i;
+
+  /* let queued async submits complete first*/
+  if(s_soft.submit_thread)
+  {
+    g_async_queue_push(s_soft.submits, g_new0(soft_submit_t, 1));
+    g_thread_join(s_soft.submit_thread);
+    g_async_queue_unref(s_soft.submits);
+    s_soft.submit_thread = NULL;
+    s_soft.submits = NULL;
+  }
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft.resources)
+  {
+    for(i = 0; i < s_soft.resources->len; i++)
+    {
+      soft_resource_t *res = g_ptr_array_index(s_soft.resources, i);
+      if(res)
+      {
+        g_free(res->pixels);
+        g_free(res);
+      }
+    }
+    for(i = 0; i < s_soft.elements->len; i++)
+      g_free(g_ptr_array_index(s_soft.elements, i));
+    for(i = 0; i < s_soft.updates->len; i++)
+    {
+      GArray *ops = g_ptr_array_index(s_soft.updates, i);
+      if(ops)
+        g_array_free(ops, TRUE);
+    }
+    g_ptr_array_free(s_soft.resources, TRUE);
+    g_ptr_array_free(s_soft.elements, TRUE);
+    g_ptr_array_free(s_soft.updates, TRUE);
+    s_soft.resources = s_soft.elements = s_soft.updates = NULL;
+  }
+  s_soft.stats.elements = 0;
+  s_soft.stats.resources = 0;
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
+
+static DISPMANX_DISPLAY_HANDLE_T s_soft_display_open(uint32_t screen)
+{
+  DISPMANX_DISPLAY_HANDLE_T display = 0;
+
+  g_mutex_lock(&s_soft.lock);
+  if(screen == 0 && s_soft.resources != NULL && s_soft.open == FALSE)
+  {
+    s_soft.open = TRUE;
+    display = SOFT_DISPLAY_HANDLE;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return display;
+}
+
+static int s_soft_display_get_info(DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_MODEINFO_T *info)
+{
+  if(display != SOFT_DISPLAY_HANDLE || info == NULL)
+    return -1;
+
+  I_ZEROMEM(info, sizeof(DISPMANX_MODEINFO_T));
+  g_mutex_lock(&s_soft.lock);
+  info->width = s_soft.width;
+  info->height = s_soft.height;
+  g_mutex_unlock(&s_soft.lock);
+  return 0;
+}
+
+static int s_soft_display_close(DISPMANX_DISPLAY_HANDLE_T display)
+{
+  if(display != SOFT_DISPLAY_HANDLE)
+    return -1;
+
+  g_mutex_lock(&s_soft.lock);
+  s_soft.open = FALSE;
+  g_mutex_unlock(&s_soft.lock);
+  return 0;
+}
+
+static DISPMANX_UPDATE_HANDLE_T s_soft_update_start(int32_t priority)
+{
+  DISPMANX_UPDATE_HANDLE_T update = 0;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft.updates)
+  {
+    update = s_soft_slot_insert(s_soft.updates, g_array_new(FALSE, FALSE, sizeof(soft_op_t)));
+    s_soft.stats.updates_started++;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return update;
+}
+
+static int s_soft_update_submit_sync(DISPMANX_UPDATE_HANDLE_T update)
+{
+  GArray *ops;
+  guint i;
+
+  g_mutex_lock(&s_soft.lock);
+  ops = s_soft_slot_get(s_soft.updates, update);
+  if(ops == NULL)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    return -1;
+  }
+
+  for(i = 0; i < ops->len; i++)
+    s_soft_apply_op(&g_array_index(ops, soft_op_t, i));
+
+  g_ptr_array_index(s_soft.updates, update - 1) = NULL;
+  g_array_free(ops, TRUE);
+  s_soft.stats.updates_submitted++;
+  g_mutex_unlock(&s_soft.lock);
+
+  s_soft_wait_vsync();
+  return 0;
+}
+
+/* Stands in for the VideoCore completing updates in the background*/
+static gpointer s_soft_submit_loop(gpointer data)
+{
+  gboolean run = TRUE;
+
+  while(run)
+  {
+    soft_submit_t *submit = g_async_queue_pop(s_soft.submits);
+
+    if(submit->update == 0)
+      run = FALSE;
+    else
+    {
+      s_soft_update_submit_sync(submit->update);
+      if(submit->cb_func)
+        submit->cb_func(submit->update, submit->cb_arg);
+    }
+    g_free(submit);
+  }
+  return NULL;
+}
+
+static int s_soft_update_submit(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_CALLBACK_FUNC_T cb_func, void *cb_arg)
+{
+  soft_submit_t *submit;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft_slot_get(s_soft.updates, update) == NULL)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    return -1;
+  }
+  if(s_soft.submit_thread == NULL)
+  {
+    s_soft.submits = g_async_queue_new();
+    s_soft.submit_thread = g_thread_new("SoftSubmitThread", s_soft_submit_loop, NULL);
+  }
+  g_mutex_unlock(&s_soft.lock);
+
+  submit = g_new0(soft_submit_t, 1);
+  submit->update = update;
+  submit->cb_func = cb_func;
+  submit->cb_arg = cb_arg;
+  g_async_queue_push(s_soft.submits, submit);
+  return 0;
+}
+
+static DISPMANX_ELEMENT_HANDLE_T s_soft_element_add(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t layer, const VC_RECT_T *dst_rect, DISPMANX_RESOURCE_HANDLE_T src,
+    const VC_RECT_T *src_rect, VC_DISPMANX_ALPHA_T *alpha, DISPMANX_TRANSFORM_T transform)
+{
+  soft_element_t *element;
+  soft_op_t op;
+
+  if(display != SOFT_DISPLAY_HANDLE || dst_rect == NULL || src_rect == NULL)
+    return 0;
+
+  element = g_new0(soft_element_t, 1);
+  element->attr.layer = layer;
+  element->attr.opacity = (uint8_t)(alpha ? alpha->opacity : 255);
+  element->attr.dst_rect = *dst_rect;
+  element->attr.src_rect = *src_rect;
+  element->attr.resource = src;
+  element->alpha_flags = alpha ? alpha->flags : DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS;
+
+  I_ZEROMEM(&op, sizeof(op));
+  op.type = SOFT_OP_ADD;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft_slot_get(s_soft.updates, update) == NULL)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    g_free(element);
+    return 0;
+  }
+  element->order = s_soft.next_order++;
+  op.element = s_soft_slot_insert(s_soft.elements, element);
+  s_soft_queue_op(update, &op);
+  s_soft.stats.elements++;
+  g_mutex_unlock(&s_soft.lock);
+
+  return op.element;
+}
+
+static int s_soft_element_change_attributes(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+    uint32_t change_flags, int32_t layer, uint8_t opacity,
+    const VC_RECT_T *dst_rect, const VC_RECT_T *src_rect)
+{
+  soft_op_t op;
+  int result = -1;
+
+  I_ZEROMEM(&op, sizeof(op));
+  op.type = SOFT_OP_CHANGE;
+  op.element = element;
+  op.change_flags = change_flags;
+  op.attr.layer = layer;
+  op.attr.opacity = opacity;
+  if(dst_rect)
+    op.attr.dst_rect = *dst_rect;
+  else
+    op.change_flags &= ~(uint32_t)ELEMENT_CHANGE_DEST_RECT;
+  if(src_rect)
+    op.attr.src_rect = *src_rect;
+  else
+    op.change_flags &= ~(uint32_t)ELEMENT_CHANGE_SRC_RECT;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft_slot_get(s_soft.updates, update) && s_soft_slot_get(s_soft.elements, element))
+  {
+    s_soft_queue_op(update, &op);
+    result = 0;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return result;
+}
+
+static int s_soft_element_change_source(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+    DISPMANX_RESOURCE_HANDLE_T src)
+{
+  soft_op_t op;
+  int result = -1;
+
+  I_ZEROMEM(&op, sizeof(op));
+  op.type = SOFT_OP_SOURCE;
+  op.element = element;
+  op.attr.resource = src;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft_slot_get(s_soft.updates, update) && s_soft_slot_get(s_soft.elements, element))
+  {
+    s_soft_queue_op(update, &op);
+    result = 0;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return result;
+}
+
+static int s_soft_element_remove(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element)
+{
+  soft_op_t op;
+  int result = -1;
+
+  I_ZEROMEM(&op, sizeof(op));
+  op.type = SOFT_OP_REMOVE;
+  op.element = element;
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft_slot_get(s_soft.updates, update) && s_soft_slot_get(s_soft.elements, element))
+  {
+    s_soft_queue_op(update, &op);
+    result = 0;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return result;
+}
+
+static DISPMANX_RESOURCE_HANDLE_T s_soft_resource_create(VC_IMAGE_TYPE_T type, uint32_t width, uint32_t height)
+{
+  soft_resource_t *res;
+  DISPMANX_RESOURCE_HANDLE_T handle = 0;
+
+  if(width == 0 || height == 0)
+    return 0;
+
+  res = g_new0(soft_resource_t, 1);
+  res->type = type;
+  res->width = width;
+  res->height = height;
+  res->pixels = g_new0(uint32_t, (gsize)width * height);
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft.resources)
+  {
+    handle = s_soft_slot_insert(s_soft.resources, res);
+    s_soft.stats.resources++;
+  }
+  g_mutex_unlock(&s_soft.lock);
+
+  if(handle == 0)
+  {
+    g_free(res->pixels);
+    g_free(res);
+  }
+  return handle;
+}
+
+static int s_soft_resource_write_data(DISPMANX_RESOURCE_HANDLE_T resource, VC_IMAGE_TYPE_T src_type,
+    int src_pitch, void *src_address, const VC_RECT_T *rect)
+{
+  soft_resource_t *res;
+  uint32_t bpp = s_soft_bytes_per_pixel(src_type);
+  int32_t x, y;
+
+  if(src_address == NULL || rect == NULL)
+    return -1;
+
+  g_mutex_lock(&s_soft.lock);
+  res = s_soft_slot_get(s_soft.resources, resource);
+  if(res == NULL || rect->x < 0 || rect->y < 0 ||
+      (uint32_t)(rect->x + rect->width) > res->width || (uint32_t)(rect->y + rect->height) > res->height)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    return -1;
+  }
+
+  /* Same convention as the VideoCore, src_address is the image base and rect selects the region*/
+  for(y = rect->y; y < rect->y + rect->height; y++)
+  {
+    const uint8_t *row = (const uint8_t *)src_address + ((gssize)src_pitch * y);
+    for(x = rect->x; x < rect->x + rect->width; x++)
+      res->pixels[((gsize)y * res->width) + (gsize)x] = s_soft_pixel_to_argb(src_type, row + ((gsize)x * bpp));
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return 0;
+}
+
+static int s_soft_resource_delete(DISPMANX_RESOURCE_HANDLE_T resource)
+{
+  soft_resource_t *res;
+
+  g_mutex_lock(&s_soft.lock);
+  res = s_soft_slot_get(s_soft.resources, resource);
+  if(res == NULL)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    return -1;
+  }
+  g_ptr_array_index(s_soft.resources, resource - 1) = NULL;
+  s_soft.stats.resources--;
+  g_mutex_unlock(&s_soft.lock);
+
+  g_free(res->pixels);
+  g_free(res);
+  return 0;
+}
+
+static const dispmanx_backend_t s_soft_backend =
+{
+  "soft",
+  FALSE,
+  s_soft_init,
+  s_soft_deinit,
+  s_soft_display_open,
+  s_soft_display_get_info,
+  s_soft_display_close,
+  s_soft_update_start,
+  s_soft_update_submit_sync,
+  s_soft_update_submit,
+  s_soft_element_add,
+  s_soft_element_change_attributes,
+  s_soft_element_change_source,
+  s_soft_element_remove,
+  s_soft_resource_create,
+  s_soft_resource_write_data,
+  s_soft_resource_delete
+};
+
+/* ********** All Global Functions Defined Here ***********/
+
+const dispmanx_backend_t *dispmanx_backend_soft(void)
+{
+  return &s_soft_backend;
+}
+
+void soft_compositor_set_display_size(int32_t width, int32_t height)
+{
+  g_mutex_lock(&s_soft.lock);
+  s_soft.width = width;
+  s_soft.height = height;
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
+
+gboolean soft_compositor_get_element(DISPMANX_ELEMENT_HANDLE_T element, soft_compositor_element_t *info)
+{
+  soft_element_t *elem;
+  gboolean found = FALSE;
+
+  g_mutex_lock(&s_soft.lock);
+  elem = s_soft_slot_get(s_soft.elements, element);
+  if(elem && elem->visible && info)
+  {
+    memcpy(info, &elem->attr, sizeof(soft_compositor_element_t));
+    found = TRUE;
+  }
+  g_mutex_unlock(&s_soft.lock);
+  return found;
+}
+
+/* Compose all visible elements bottom to top into an ARGB8888 buffer of width x height, pitch in bytes*/
+int soft_compositor_compose(uint32_t *pixels, uint32_t pitch, int32_t width, int32_t height)
+{
+  GPtrArray *visible;
+  gint64 start;
+  guint i;
+  int32_t x, y;
+
+  if(pixels == NULL || width <= 0 || height <= 0 || pitch < (uint32_t)width * sizeof(uint32_t))
+    return -1;
+
+  start = g_get_monotonic_time();
+
+  for(y = 0; y < height; y++)
+  {
+    uint32_t *row = (uint32_t *)(void *)((uint8_t *)pixels + ((gsize)pitch * (gsize)y));
+    for(x = 0; x < width; x++)
+      row[x] = 0xFF000000;
+  }
+
+  g_mutex_lock(&s_soft.lock);
+  if(s_soft.elements == NULL)
+  {
+    g_mutex_unlock(&s_soft.lock);
+    return -1;
+  }
+
+  visible = g_ptr_array_new();
+  for(i = 0; i < s_soft.elements->len; i++)
+  {
+    soft_element_t *elem = g_ptr_array_index(s_soft.elements, i);
+    if(elem && elem->visible && elem->attr.opacity != 0)
+      g_ptr_array_add(visible, elem);
+  }
+  g_ptr_array_sort(visible, s_soft_element_compare);
+
+  for(i = 0; i < visible->len; i++)
+  {
+    soft_element_t *elem = g_ptr_array_index(visible, i);
+    soft_resource_t *res = s_soft_slot_get(s_soft.resources, elem->attr.resource);
+    VC_RECT_T dst = elem->attr.dst_rect;
+    VC_RECT_T src = elem->attr.src_rect;
+    int32_t x0, y0, x1, y1;
+
+    /* A zero sized destination covers the whole display*/
+    if(dst.width <= 0 || dst.height <= 0)
+      vc_dispmanx_rect_set(&dst, 0, 0, (uint32_t)s_soft.width, (uint32_t)s_soft.height);
+
+    x0 = MAX(dst.x, 0);
+    y0 = MAX(dst.y, 0);
+    x1 = MIN(dst.x + dst.width, width);
+    y1 = MIN(dst.y + dst.height, height);
+
+    for(y = y0; y < y1; y++)
+    {
+      uint32_t *row = (uint32_t *)(void *)((uint8_t *)pixels + ((gsize)pitch * (gsize)y));
+      for(x = x0; x < x1; x++)
+      {
+        uint32_t color = SOFT_COMPOSITOR_VIDEO_COLOR;
+        uint32_t alpha = elem->attr.opacity;
+
+        if(res)
+        {
+          /* src rect is 16.16 fixed point*/
+          gint64 sx = ((gint64)src.x + ((gint64)(x - dst.x) * src.width) / dst.width) >> 16;
+          gint64 sy = ((gint64)src.y + ((gint64)(y - dst.y) * src.height) / dst.height) >> 16;
+          sx = CLAMP(sx, 0, (gint64)res->width - 1);
+          sy = CLAMP(sy, 0, (gint64)res->height - 1);
+          color = res->pixels[((gsize)sy * res->width) + (gsize)sx];
+          if((elem->alpha_flags & 0x3) == DISPMANX_FLAGS_ALPHA_FROM_SOURCE)
+            alpha = (alpha * (color >> 24)) / 255;
+        }
+        row[x] = s_soft_blend(row[x], color, alpha);
+      }
+    }
+  }
+  g_ptr_array_free(visible, TRUE);
+
+  s_soft.stats.frames_composed++;
+  s_soft.stats.compose_time_us += (guint64)(g_get_monotonic_time() - start);
+  g_mutex_unlock(&s_soft.lock);
+
+  return 0;
+}
+
+void soft_compositor_get_stats(soft_compositor_stats_t *stats)
+{
+  if(stats == NULL)
+    return;
+
+  g_mutex_lock(&s_soft.lock);
+  memcpy(stats, &s_soft.stats, sizeof(soft_compositor_stats_t));
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
+
+void soft_compositor_reset_stats(void)
+{
+  g_mutex_lock(&s_soft.lock);
+  s_soft.stats.updates_started = 0;
+  s_soft.stats.updates_submitted = 0;
+  s_soft.stats.element_changes = 0;
+  s_soft.stats.frames_composed = 0;
+  s_soft.stats.compose_time_us = 0;
+  g_mutex_unlock(&s_soft.lock);
+  return;
+}
@@ -0,0 +1,120 @@
+/* MIT License
+
+Copyright (c) 2016 Munez Bokkapatna Nayakwady <munezbn.dev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <player.h>
+#include <dispmanx_layout.h>
+
+/* Table test for dispmanx_layout_compute, run by `meson test`.
+ * Every case is laid out on a 1920x1080 screen, src_rect is 16.16.*/
+
+#define ONE DISPMANX_LAYOUT_ONE
+
+typedef struct
+{
+    const char *name;
+    dispmanx_layout_source_t source;
+    dispmanx_layout_params_t params;
+    gboolean valid;
+    VC_RECT_T src_rect;
+    VC_RECT_T dst_rect;
+}layout_case_t;
+
+static const layout_case_t s_cases[] =
+{
+    { "4:3 fit",                  { 640, 480, 1, 1 },    { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 640 * ONE, 480 * ONE },   { 240, 0, 1440, 1080 } },
+    { "4:3 stretch",              { 640, 480, 1, 1 },    { PLAYER_AR_STRETCH, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 640 * ONE, 480 * ONE },   { 0, 0, 1920, 1080 } },
+    { "4:3 letterbox",            { 640, 480, 1, 1 },    { PLAYER_AR_LETTERBOX, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 60 * ONE, 640 * ONE, 360 * ONE }, { 0, 0, 1920, 1080 } },
+    { "4:3 pillarbox",            { 640, 480, 1, 1 },    { PLAYER_AR_PILLARBOX, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 640 * ONE, 480 * ONE },   { 240, 0, 1440, 1080 } },
+    { "4:3 crop",                 { 640, 480, 1, 1 },    { PLAYER_AR_CROP, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 60 * ONE, 640 * ONE, 360 * ONE }, { 0, 0, 1920, 1080 } },
+    { "4:3 zoom 2x",              { 640, 480, 1, 1 },    { PLAYER_AR_ZOOM, 2 * ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 6990506, 120 * ONE, 27962027, 240 * ONE }, { 0, 0, 1920, 1080 } },
+    { "4:3 zoom below 1x",        { 640, 480, 1, 1 },    { PLAYER_AR_ZOOM, ONE / 2, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 640 * ONE, 480 * ONE },   { 240, 0, 1440, 1080 } },
+    { "2.35:1 fit",               { 1920, 816, 1, 1 },   { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 1920 * ONE, 816 * ONE },  { 0, 132, 1920, 816 } },
+    { "2.35:1 crop",              { 1920, 816, 1, 1 },   { PLAYER_AR_CROP, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 15375813, 0, 95077493, 816 * ONE }, { 0, 0, 1920, 1080 } },
+    { "2.35:1 pillarbox",         { 1920, 816, 1, 1 },   { PLAYER_AR_PILLARBOX, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 15375813, 0, 95077493, 816 * ONE }, { 0, 0, 1920, 1080 } },
+    { "PAL 4:3 anamorphic",       { 720, 576, 16, 15 },  { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 720 * ONE, 576 * ONE },   { 240, 0, 1440, 1080 } },
+    { "PAL 16:9 anamorphic",      { 720, 576, 64, 45 },  { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 720 * ONE, 576 * ONE },   { 0, 0, 1920, 1080 } },
+    { "PAL unknown par is 1:1",   { 720, 576, 0, 0 },    { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 720 * ONE, 576 * ONE },   { 285, 0, 1350, 1080 } },
+    { "custom centre quarter",    { 1920, 1080, 1, 1 },  { PLAYER_AR_CUSTOM, ONE, { 480 * ONE, 270 * ONE, 960 * ONE, 540 * ONE } }, TRUE,
+        { 480 * ONE, 270 * ONE, 960 * ONE, 540 * ONE }, { 0, 0, 1920, 1080 } },
+    { "custom clamped to frame",  { 1920, 1080, 1, 1 },  { PLAYER_AR_CUSTOM, ONE, { 960 * ONE, 0, 1920 * ONE, 1080 * ONE } }, TRUE,
+        { 960 * ONE, 0, 960 * ONE, 1080 * ONE }, { 480, 0, 960, 1080 } },
+    { "custom empty is frame",    { 1920, 1080, 1, 1 },  { PLAYER_AR_CUSTOM, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 1920 * ONE, 1080 * ONE }, { 0, 0, 1920, 1080 } },
+    { "largest source",           { 32767, 32767, 1, 1 }, { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, TRUE,
+        { 0, 0, 32767 * ONE, 32767 * ONE }, { 420, 0, 1080, 1080 } },
+    { "source too wide",          { 32768, 1080, 1, 1 }, { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, FALSE,
+        { 0, 0, 0, 0 }, { 0, 0, 0, 0 } },
+    { "no video size",            { 0, 0, 1, 1 },        { PLAYER_AR_ORIGINAL, ONE, { 0, 0, 0, 0 } }, FALSE,
+        { 0, 0, 0, 0 }, { 0, 0, 0, 0 } }
+};
+
+static gboolean s_rect_equal(const VC_RECT_T *a, const VC_RECT_T *b)
+{
+    return (a->x == b->x && a->y == b->y && a->width == b->width && a->height == b->height);
+}
+
+int32_t main(int32_t argc, char *argv[])
+{
+    const VC_RECT_T area = { 0, 0, 1920, 1080 };
+    guint i, failed = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(s_cases); i++)
+    {
+        const layout_case_t *test = &s_cases[i];
+        VC_RECT_T src_rect, dst_rect;
+        gboolean valid;
+
+        memset(&src_rect, 0, sizeof(src_rect));
+        memset(&dst_rect, 0, sizeof(dst_rect));
+        valid = dispmanx_layout_compute(&test->source, &area, &test->params, &src_rect, &dst_rect);
+
+        if (valid != test->valid || (valid && (!s_rect_equal(&src_rect, &test->src_rect) || !s_rect_equal(&dst_rect, &test->dst_rect))))
+        {
+            printf("FAIL %s [%s] : %s src %d %d %d %d dst %d %d %d %d\n", test->name, dispmanx_layout_mode_name(test->params.mode),
+                    valid ? "laid out" : "refused", src_rect.x, src_rect.y, src_rect.width, src_rect.height,
+                    dst_rect.x, dst_rect.y, dst_rect.width, dst_rect.height);
+            failed++;
+        }
+        else
+            printf("ok   %s\n", test->name);
+    }
+
+    printf("%u of %u layouts failed\n", failed, (guint)G_N_ELEMENTS(s_cases));
+    return (failed == 0) ? 0 : 1;
+}